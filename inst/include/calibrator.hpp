@@ -0,0 +1,101 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+#ifndef CALIBRATOR_H
+#define CALIBRATOR_H
+/*
+ *  calibrator.hpp - fits model parameters to observed series
+ *  hector
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#include "core.hpp"
+#include "h_exception.hpp"
+#include "unitval.hpp"
+
+namespace Hector {
+
+/*! \brief Fits model parameters to observed time series.
+ *
+ *  Parameters (e.g. D_ECS, D_DIFFUSIVITY) are given with bounds, and targets
+ *  are observed series of model outputs (e.g. D_GLOBAL_TEMP), given directly
+ *  or read from a CSV table laid out like the constraint inputs.  The
+ *  objective is the sum over targets of the weight times the mean squared
+ *  difference between model and observations.
+ *
+ *  The objective is minimized by the Nelder-Mead simplex method, working in
+ *  parameter space scaled to the unit cube, with trial points projected onto
+ *  the bounds.  Each evaluation sets the parameters and lets the core redo
+ *  only the part of the run they invalidate (so the spinup is reused for
+ *  parameters that leave it valid), running no further than the last target
+ *  date.  When calibrate() returns, the core holds the run with the best
+ *  parameters found.
+ */
+class Calibrator {
+public:
+    Calibrator( Core* core );
+
+    void addParameter( const std::string& datum, double lower, double upper,
+                       unit_types units ) throw ( h_exception );
+    void addTarget( const std::string& datum, const std::vector<double>& dates,
+                    const std::vector<unitval>& values, double weight=1.0 ) throw ( h_exception );
+    void addTarget( const std::string& datum, const std::string& fileName,
+                    const std::string& column, double weight=1.0 ) throw ( h_exception );
+
+    void setMaxEvaluations( int n ) { maxEvaluations = n; };
+    void setTolerance( double tol ) { tolerance = tol; };
+
+    double calibrate() throw ( h_exception );
+    double objective( const std::vector<double>& values ) throw ( h_exception );
+
+    const std::vector<double>& getBestValues() const { return best; };
+    int getEvaluations() const { return evaluations; };
+    bool converged() const { return hasConverged; };
+
+private:
+    //! A parameter to fit
+    struct parameter {
+        std::string datum;
+        double lower;
+        double upper;
+        unit_types units;
+    };
+
+    //! An observed series
+    struct target {
+        std::string datum;
+        std::vector<double> dates;
+        std::vector<unitval> values;
+        double weight;
+    };
+
+    Core* core;
+    std::vector<parameter> parameters;
+    std::vector<target> targets;
+
+    //! Most objective evaluations calibrate() may make
+    int maxEvaluations;
+    //! Convergence tolerance on the objective and the (scaled) parameters
+    double tolerance;
+
+    std::vector<double> best;
+    int evaluations;
+    bool hasConverged;
+
+    double lastTargetDate() const;
+    std::vector<double> unscale( const std::vector<double>& x ) const;
+    double scaledObjective( std::vector<double>& x ) throw ( h_exception );
+
+    Calibrator( const Calibrator& );
+    Calibrator& operator=( const Calibrator& );
+};
+
+}
+
+#endif // CALIBRATOR_H
@@ -110,6 +110,10 @@ public:
         H_THROW("`createBiome` is not defined for this component.")
     }
     inline
+    virtual void createBiomes(const std::vector<std::string>& biomes) {
+        H_THROW("`createBiomes` is not defined for this component.")
+    }
+    inline
     virtual void deleteBiome(const std::string& biome) {
         H_THROW("`deleteBiome` is not defined for this component.")
     };
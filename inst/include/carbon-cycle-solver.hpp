@@ -19,6 +19,7 @@
 #include "logger.hpp"
 #include "carbon-cycle-model.hpp"
 #include "h_util.hpp"
+#include "tseries.hpp"
 
 #define MAX_CARBON_MODEL_RETRIES 8
 
@@ -98,6 +99,8 @@ private:
     double eps_rel;
     //! Default stepsize (years) -- the integrator will adjust this as required
     double dt;
+    //! Stepsize history, so that a reset resumes with the same stepsize
+    tseries<double> dt_ts;
     
     unitval eps_spinup;     //! spinup epsilon (drift/tolerance), Pg C
     
@@ -107,11 +110,12 @@ private:
     };
     // A functor to provide callbacks for the ODE solver. 
     struct ODEEvalFunctor {
-        ODEEvalFunctor( CarbonCycleModel* cmodel, double* time ):modelptr(cmodel), t(time) { }
-        void operator()( const std::vector<double>& y, std::vector<double>& dydt, double t ) throw( bad_derivative_exception );
+        ODEEvalFunctor( CarbonCycleModel* cmodel, double* time, Core* coreptr ):modelptr(cmodel), t(time), core(coreptr) { }
+        void operator()( const std::vector<double>& y, std::vector<double>& dydt, double t ) throw( bad_derivative_exception, h_exception );
         void operator()( const std::vector<double>& y, double t );
         CarbonCycleModel* modelptr;
         double* t;
+        Core* core;
     };
     
     void failure( int stat, double t0, double tmid ) throw( h_exception );
@@ -25,6 +25,7 @@
 #define D_END_DATE              "endDate"
 #define D_DO_SPINUP             "do_spinup"
 #define D_MAX_SPINUP            "max_spinup"
+#define D_TIMESTEP              "timestep"
 #define D_ENABLED               "enabled"
 #define D_OUTPUT_ENABLED        "output"
 
@@ -297,6 +298,8 @@
 #define D_SLR                   "slr"
 #define D_SL_RC_NO_ICE          "sl_rc_no_ice"
 #define D_SLR_NO_ICE            "slr_no_ice"
+#define D_SLR_REFPERIOD_LOW     "refperiod_low"
+#define D_SLR_REFPERIOD_HIGH    "refperiod_high"
 
 // so2 component
 #define D_NATURAL_SO2       "SN"
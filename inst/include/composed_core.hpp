@@ -0,0 +1,149 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+#ifndef COMPOSED_CORE_H
+#define COMPOSED_CORE_H
+/*
+ *  composed_core.hpp - a core whose component types are known at compile time
+ *  hector
+ *
+ */
+
+#include <typeinfo>
+#include <vector>
+
+#include "core.hpp"
+#include "imodel_component.hpp"
+#include "bc_component.hpp"
+#include "carbon-cycle-solver.hpp"
+#include "ch4_component.hpp"
+#include "forcing_component.hpp"
+#include "halocarbon_component.hpp"
+#include "n2o_component.hpp"
+#include "o3_component.hpp"
+#include "oc_component.hpp"
+#include "ocean_component.hpp"
+#include "oh_component.hpp"
+#include "onelineocean_component.hpp"
+#include "simpleNbox.hpp"
+#include "slr_component.hpp"
+#include "so2_component.hpp"
+#include "temperature_component.hpp"
+
+namespace Hector {
+
+//------------------------------------------------------------------------------
+/*! \brief Calls into components whose type is one of Cs, without going through
+ *         the virtual table.
+ *
+ *  Each type in the list gets an index, starting at I.  A component is
+ *  matched by its exact dynamic type, so a class derived from one in the list
+ *  is not mistaken for it; components of other types get the index past the
+ *  end of the list and are called virtually.
+ */
+template <size_t I, class... Cs>
+struct composed_dispatch;
+
+template <size_t I>
+struct composed_dispatch<I> {
+    static size_t index( const IModelComponent* ) { return I; }
+    static void run( size_t, IModelComponent* c, double date ) {
+        c->run( date );
+    }
+    static bool run_spinup( size_t, IModelComponent* c, int step ) {
+        return c->run_spinup( step );
+    }
+};
+
+template <size_t I, class C, class... Cs>
+struct composed_dispatch<I, C, Cs...> {
+    typedef composed_dispatch<I+1, Cs...> next;
+
+    static size_t index( const IModelComponent* c ) {
+        return typeid( *c ) == typeid( C ) ? I : next::index( c );
+    }
+    static void run( size_t type, IModelComponent* c, double date ) {
+        if( type == I )
+            static_cast<C*>( c )->C::run( date );
+        else
+            next::run( type, c, date );
+    }
+    static bool run_spinup( size_t type, IModelComponent* c, int step ) {
+        if( type == I )
+            return static_cast<C*>( c )->C::run_spinup( step );
+        return next::run_spinup( type, c, step );
+    }
+};
+
+//------------------------------------------------------------------------------
+/*! \brief A core specialized at compile time for a set of component types.
+ *
+ *  The components are created, wired together and ordered exactly as in
+ *  Core, so results are identical (test_hector.sh checks this against
+ *  `hector --dynamic`).  The only difference is that each step calls the
+ *  run functions of the listed types by name instead of through the virtual
+ *  table.  Those functions are defined out of line and the build doesn't use
+ *  link-time optimization, so they are not inlined.  Component dependencies
+ *  and data exchange still go through Core (getComponentByCapability,
+ *  sendMessage) by name.  In practice a run takes the same time as with
+ *  Core.  Components of other types (added with addModelComponent, for
+ *  example) still work; they are just called virtually.
+ *
+ *  Types that account for more of the schedule should come first in the
+ *  list, since a component's type is found by checking the list in order.
+ */
+template <class... Components>
+class ComposedCore : public Core {
+public:
+    ComposedCore( Logger::LogLevel loglvl = Logger::DEBUG, bool echotoscreen=true,
+                  bool echotofile=true, bool use_arena=false )
+        : Core( loglvl, echotoscreen, echotofile, use_arena ) {}
+
+protected:
+    typedef composed_dispatch<0, Components...> dispatch;
+
+    virtual void scheduleChanged() {
+        const std::vector<IModelComponent*>& schedule = getSchedule();
+        typedSchedule.clear();
+        for( size_t i=0; i<schedule.size(); ++i ) {
+            typed_component tc = { dispatch::index( schedule[ i ] ), schedule[ i ] };
+            typedSchedule.push_back( tc );
+        }
+    }
+
+    virtual void runSchedule( double date ) throw ( h_exception ) {
+        for( size_t i=0; i<typedSchedule.size(); ++i )
+            dispatch::run( typedSchedule[ i ].type, typedSchedule[ i ].component, date );
+    }
+
+    virtual bool runScheduleSpinup( int step ) throw ( h_exception ) {
+        bool spunup = true;
+        for( size_t i=0; i<typedSchedule.size() && spunup; ++i )
+            spunup = dispatch::run_spinup( typedSchedule[ i ].type, typedSchedule[ i ].component, step );
+        return spunup;
+    }
+
+private:
+    //! A scheduled component and the index of its type in Components
+    struct typed_component {
+        size_t type;
+        IModelComponent* component;
+    };
+
+    //! The schedule, with each component's type resolved
+    std::vector<typed_component> typedSchedule;
+};
+
+//! The standard set of components, most numerous first
+typedef ComposedCore<HalocarbonComponent, SimpleNbox, CarbonCycleSolver, OceanComponent,
+                     TemperatureComponent, ForcingComponent, CH4Component, OHComponent,
+                     N2OComponent, OzoneComponent, BlackCarbonComponent,
+                     OrganicCarbonComponent, SulfurComponent, slrComponent,
+                     OneLineOceanComponent> StandardCore;
+
+}
+
+#endif // COMPOSED_CORE_H
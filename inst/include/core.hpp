@@ -15,13 +15,21 @@
  */
 
 #include <map>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
 
 #include "logger.hpp"
+#include "h_arena.hpp"
 #include "h_exception.hpp"
 #include "ivisitable.hpp"
+#include "tseries.hpp"
+#include "unitval.hpp"
 
 namespace Hector {
 
@@ -36,8 +44,9 @@ class IModelComponent;
  */
 class Core : public IVisitable {
 public:
-    Core(Logger::LogLevel loglvl = Logger::DEBUG, bool echotoscreen=true, bool echotofile=true);
-    ~Core();
+    Core(Logger::LogLevel loglvl = Logger::DEBUG, bool echotoscreen=true, bool echotofile=true,
+         bool use_arena=false);
+    virtual ~Core();
 
     const std::string& getComponentName() const;
 
@@ -54,6 +63,8 @@ public:
 
     void reset(double resetdate);
 
+    double step() throw ( h_exception );
+
     void shutDown();
 
     Logger &getGlobalLogger() {return glog;}
@@ -67,7 +78,25 @@ public:
     int checkCapability( const std::string& capabilityName );
 
     void registerDependency( const std::string& capabilityName, const std::string& componentName );
+    void registerLaggedDependency( const std::string& capabilityName, const std::string& componentName );
     void registerInput(const std::string &inputName, const std::string &componentName);
+    bool sharesInput( const std::string& datum, const Core& other ) const throw ( h_exception );
+
+    //! How much of a completed run a change to a parameter invalidates
+    enum Invalidation {
+        //! The parameter feeds the initial state or the spinup (the default)
+        INVALIDATE_SPINUP,
+        //! The parameter only acts from the start date onward
+        INVALIDATE_RUN,
+        //! The parameter only affects outputs of its component and of the
+        //! components that depend on it; the rest of the model is unchanged
+        INVALIDATE_DIAGNOSTICS
+    };
+    void registerInvalidation( const std::string& paramName, const std::string& componentName,
+                               Invalidation invalidation );
+    bool changesPending() const { return spinup_invalid || runInvalidDate <= lastDate ||
+                                         !diagnosticComponents.empty(); }
+    void applyChanges() throw ( h_exception );
 
     unitval sendMessage( const std::string& message,
                         const std::string& datum ) throw ( h_exception );
@@ -79,6 +108,8 @@ public:
     double getStartDate() const { return startDate; };
     double getEndDate() const { return endDate; };
     double getCurrentDate() const {return lastDate;}
+    int getTimeStep() const { return timeStep; };
+    bool isStepDate( double date ) const;
     std::string getRun_name() const { return run_name; };
     bool inSpinup() const { return in_spinup; };
     bool outputEnabled( std::string componentName ) { return std::find( disabledOutputComponents.begin(),
@@ -96,15 +127,66 @@ public:
     //! Manage cores in the global registry
     static int mkcore(bool logtofile=false,
                       Logger::LogLevel loglvl=Logger::NOTICE,
-                      bool logtoscrn=false);
+                      bool logtoscrn=false,
+                      bool use_arena=false);
     static Core *getcore(int idx);
     static void delcore(int idx);
 
     std::vector<std::string> getBiomeList() const;
     void createBiome(const std::string& biome);
+    void createBiomes(const std::vector<std::string>& biomes);
     void deleteBiome(const std::string& biome);
     void renameBiome(const std::string& oldname, const std::string& newname);
 
+    //! Coupling interface: exchange buffers read/written every time step
+    void registerInputBuffer( const std::string& datum, const double* buffer,
+                              size_t len, double bufferStart, unit_types units ) throw ( h_exception );
+    void registerOutputBuffer( const std::string& datum, double* buffer,
+                               size_t len, double bufferStart, unit_types units ) throw ( h_exception );
+    void clearCouplingBuffers();
+
+    //! Output subscriptions: a set of outputs collected every (stride'th) step
+    int subscribeOutputs( const std::vector<std::string>& datums, double start=-1.0,
+                          double end=-1.0, int stride=1 ) throw ( h_exception );
+    void unsubscribeOutputs( int id ) throw ( h_exception );
+    const std::vector<double>& getSubscriptionValues( int id ) const throw ( h_exception );
+    const std::vector<std::string>& getSubscriptionDatums( int id ) const throw ( h_exception );
+    std::vector<double> getSubscriptionDates( int id ) const throw ( h_exception );
+    std::vector<unit_types> getSubscriptionUnits( int id ) const throw ( h_exception );
+
+    //! Run only the components needed to produce these outputs
+    void setTargetOutputs( const std::vector<std::string>& datums ) throw ( h_exception );
+
+    //! Stop conditions: end a run early once one of them is met
+    typedef std::function<bool ( Core&, double )> stop_callback;
+    int addStopCondition( const std::string& datum, double threshold,
+                          bool above=true ) throw ( h_exception );
+    int addStopCondition( const stop_callback& callback ) throw ( h_exception );
+    void clearStopConditions();
+    double getStopDate() const { return stopDate; }
+    int getStopCondition() const { return stopCondition; }
+
+    //! Run budget and cancellation: abort runs that take too long
+    typedef std::shared_ptr<std::atomic<bool> > cancel_token;
+    void setRunBudget( double seconds, long evaluations=0 );
+    void setCancelToken( const cancel_token& token );
+    const cancel_token& getCancelToken() const { return cancelToken; }
+    void cancel() { *cancelToken = true; }
+    void checkRunBudget( long evaluations=0 ) throw ( h_run_aborted );
+
+protected:
+    //! The components in the order they run
+    const std::vector<IModelComponent*>& getSchedule() const { return componentSchedule; }
+
+    //! Called whenever the schedule has been rebuilt
+    virtual void scheduleChanged() {}
+
+    //! Run every scheduled component for one date
+    virtual void runSchedule( double date ) throw ( h_exception );
+
+    //! Run one spinup step of the scheduled components
+    virtual bool runScheduleSpinup( int step ) throw ( h_exception );
+
 private:
     //! Registry of instantiated cores
     //! \details This is used when you are instantiating hector cores
@@ -116,6 +198,10 @@ private:
 
     Logger glog;
 
+    //! Memory pool for the components' time series, if the core has one
+    //! (see h_arena)
+    std::shared_ptr<h_arena> arena;
+
     // indicator for whether setup has been completed.  See notes in the body of
     // prepareToRun.
     bool setup_complete;
@@ -124,6 +210,9 @@ private:
     //! Cause all components to run their spinup procedure.
     bool run_spinup();
 
+    double nextStepDate( double date ) const;
+    double previousStepDate( double date ) const;
+
 
     //------------------------------------------------------------------------------
     //! Current run name.
@@ -141,6 +230,11 @@ private:
     //! The last date we've run up to
     double lastDate;
 
+    //------------------------------------------------------------------------------
+    //! Years per model time step.  Time steps fall on startDate plus a
+    //! multiple of this.
+    int timeStep;
+
     //------------------------------------------------------------------------------
     //! A flag to indicate that the core has been initialized.
     bool isInited;
@@ -153,46 +247,31 @@ private:
     //! Maximum number of spinup steps allowed.
     int max_spinup;
 
-    //------------------------------------------------------------------------------
-    //! A comparison object to ensure modelComponents are ordered according to
-    //! dependencies.
-    class DependencyOrderingComparator {
-    public:
-        DependencyOrderingComparator(){
-        }
-        DependencyOrderingComparator( std::vector<std::string> ordering ):orderedComponents( ordering )
-        {
-        }
-
-        bool operator()( const std::string& lhs, const std::string& rhs ) const {
-            std::vector<std::string>::const_iterator lhsIt =
-            find( orderedComponents.begin(), orderedComponents.end(), lhs );
-            std::vector<std::string>::const_iterator rhsIt =
-            find( orderedComponents.begin(), orderedComponents.end(), rhs );
-
-            // If both sides are not explicitly ordered then just order by name
-            if( lhsIt == orderedComponents.end() && rhsIt == orderedComponents.end() ) {
-                return lhs < rhs;
-            }
-
-            return lhsIt < rhsIt;
-        }
-    private:
-        //! An inorder list of model components by name.  Note that this list
-        //! is not exhaustive.  Model components not in this list are assumed to
-        //! be independent.
-        std::vector<std::string> orderedComponents;
-    };
+    // A named list of model components.
+    std::map<std::string, IModelComponent*> modelComponents;
 
-    // A named list of model components to run.
-    std::map<std::string, IModelComponent*, DependencyOrderingComparator> modelComponents;
+    // The model components in the order they run: each one after the
+    // components it depends on.  Filled in by init() and put in dependency
+    // order by prepareToRun().
+    std::vector<IModelComponent*> componentSchedule;
 
     // A map of component capabilities (as reported by the components).
     std::multimap<std::string, std::string> componentCapabilities;
 
+    // The component answering getData for each datum that has been asked
+    // for, so that repeated requests skip parsing the datum name and the
+    // capability lookup.  Cleared when components are removed.
+    std::unordered_map<std::string, IModelComponent*> datumProviders;
+
     // A map of component dependencies (depending on CAPABILITY, not component name).
     std::multimap<std::string, std::string> componentDependencies;
 
+    // Capabilities a component reads without needing their provider to run
+    // first (see registerLaggedDependency).  Like componentDependencies,
+    // keyed by component name.  These don't affect the run order; they only
+    // keep the providers from being pruned.
+    std::multimap<std::string, std::string> componentLaggedDependencies;
+
     // Map of component inputs, as reported by the components.  This
     // map doesn't play any role in establishing the dependency graph
     // (see capabilities for that).  Instead it's used by outside
@@ -208,17 +287,157 @@ private:
     // A list of components whose output has been disabled
     std::vector<std::string> disabledOutputComponents;
 
+    // The outputs the caller needs (see setTargetOutputs).  If non-empty,
+    // components these don't depend on are removed in prepareToRun.
+    std::vector<std::string> targetOutputs;
+
     // Some helpful typedefs to clean up syntax
     typedef std::multimap<std::string, std::string>::iterator componentMapIterator;
-    typedef std::map<std::string, IModelComponent*,
-    DependencyOrderingComparator>::iterator NameComponentIterator;
-    typedef std::map<std::string, IModelComponent*,
-    DependencyOrderingComparator>::const_iterator CNameComponentIterator;
+    typedef std::map<std::string, IModelComponent*>::iterator NameComponentIterator;
+    typedef std::map<std::string, IModelComponent*>::const_iterator CNameComponentIterator;
+    typedef std::vector<IModelComponent*>::const_iterator ScheduleIterator;
 
 
     //! Flag: are we currently in spinup mode?
     bool in_spinup;
 
+    //------------------------------------------------------------------------------
+    /*! \brief An external array registered through the coupling interface.
+     *
+     *  The array covers the dates bufferStart, bufferStart+1, ...,
+     *  bufferStart+len-1.  The components it is exchanged with are looked up
+     *  once (see resolveCouplingBuffers) so that the per-step exchange does no
+     *  string lookups and no allocation in the core.
+     */
+    struct coupling_buffer {
+        std::string datum;
+        //! Caller's array for inputs (NULL for outputs)
+        const double* source;
+        //! Caller's array for outputs (NULL for inputs)
+        double* dest;
+        size_t len;
+        double bufferStart;
+        unit_types units;
+        //! Components the data is exchanged with (resolved lazily)
+        std::vector<IModelComponent*> components;
+        //! Each component's series for the input, where it exposes one
+        //! (inputs only; see IModelComponent::getInputSeriesPtr)
+        std::vector<tseries<unitval>*> series;
+        //! The providing component's current value, if it exposes it (outputs only)
+        const unitval* current;
+    };
+
+    //! Buffers pushed into the model before each time step (e.g. emissions)
+    std::vector<coupling_buffer> couplingInputs;
+
+    //! Buffers filled from the model after each time step (e.g. temperature)
+    std::vector<coupling_buffer> couplingOutputs;
+
+    //! Flag: have the coupling buffers been bound to their components?
+    bool coupling_resolved;
+
+    //------------------------------------------------------------------------------
+    /*! \brief A set of outputs recorded at regular dates (see subscribeOutputs).
+     *
+     *  values holds one row per recorded date, with one column per datum, in
+     *  the units the providing components report.  Like the coupling buffers,
+     *  the providing components are looked up once.
+     */
+    struct output_subscription {
+        std::vector<std::string> datums;
+        double start;
+        double end;
+        int stride;
+        std::vector<double> values;
+        std::vector<unit_types> units;
+        //! Components providing each datum (resolved lazily)
+        std::vector<IModelComponent*> components;
+        //! Their current values, where they expose them
+        std::vector<const unitval*> currents;
+    };
+
+    //! Output subscriptions, by id; unsubscribed ids are left empty
+    std::vector<output_subscription> outputSubscriptions;
+
+    const output_subscription& getSubscription( int id ) const throw ( h_exception );
+
+    //------------------------------------------------------------------------------
+    /*! \brief A condition that ends a run (see addStopCondition).
+     *
+     *  Either a threshold on a datum, or, if callback is set, an arbitrary
+     *  test.
+     */
+    struct stop_condition {
+        std::string datum;
+        double threshold;
+        bool above;
+        stop_callback callback;
+        //! Component providing datum (resolved lazily)
+        IModelComponent* component;
+        //! Its current value, if it exposes it
+        const unitval* current;
+    };
+
+    //! Stop conditions, by id
+    std::vector<stop_condition> stopConditions;
+
+    //! Date at which the last run was stopped, or -1 if it wasn't
+    double stopDate;
+
+    //! Id of the condition that stopped the last run, or -1
+    int stopCondition;
+
+    int checkStopConditions( double date ) throw ( h_exception );
+
+    //! Wall-clock seconds allowed per run (0 for no limit)
+    double budgetSeconds;
+
+    //! Derivative evaluations allowed per run (0 for no limit)
+    long budgetEvaluations;
+
+    //! When the current run's budget started
+    std::chrono::steady_clock::time_point budgetStart;
+
+    //! Derivative evaluations so far in the current run
+    long evaluationCount;
+
+    //! Set to abort runs; may be shared with other cores
+    cancel_token cancelToken;
+
+    void startRunBudget();
+
+    void resolveCouplingBuffers() throw ( h_exception );
+    void pushCouplingInputs( double date ) throw ( h_exception );
+    void pullCouplingOutputs( double date ) throw ( h_exception );
+
+    //------------------------------------------------------------------------------
+    //! Invalidation class declared for each (component, parameter) pair.
+    //! Parameters not listed here are assumed to invalidate the spinup.
+    std::map<std::pair<std::string, std::string>, Invalidation> parameterInvalidation;
+
+    //! Flag: a change since the last run requires the spinup to be rerun
+    bool spinup_invalid;
+
+    //! Earliest date whose results are invalidated by changes since the last
+    //! run.  Results through this date are still good.
+    double runInvalidDate;
+
+    //! Components whose derived constants must be recomputed (by calling
+    //! their prepareToRun) before rerunning from the start date
+    std::set<std::string> prepareComponents;
+
+    //! Components whose diagnostic parameters have changed
+    std::set<std::string> diagnosticComponents;
+
+    void noteChange( const std::string& componentName, const std::string& datum,
+                     double date );
+    std::set<std::string> getDependentComponents( const std::set<std::string>& components ) const;
+    void clearChanges();
+
+    std::set<std::string> getUpstreamComponents( const std::set<std::string>& components ) const;
+    void pruneComponents() throw ( h_exception );
+    void removeComponent( const std::string& componentName );
+
     //! List of visitors which may need to take action after a model time-step.
     std::vector<AVisitor*> modelVisitors;
     // Some helpful typedefs to clean up syntax
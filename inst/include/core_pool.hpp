@@ -0,0 +1,63 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+#ifndef CORE_POOL_H
+#define CORE_POOL_H
+/*
+ *  core_pool.hpp - spun-up cores kept for reuse
+ *  hector
+ *
+ */
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "core.hpp"
+#include "h_exception.hpp"
+#include "logger.hpp"
+
+namespace Hector {
+
+/*! \brief A collection of cores, set up and spun up, ready to be run.
+ *
+ *  Cores are kept by configuration (input file name).  Setting up a core
+ *  means reading its inputs and running its spinup, which usually takes far
+ *  longer than the run itself, so a program answering many requests should
+ *  borrow cores from a pool rather than create a new one for each.  The pool
+ *  may be used from any number of threads; each borrowed core is used by one
+ *  thread at a time.
+ */
+class CorePool {
+public:
+    CorePool( Logger::LogLevel loglvl = Logger::SEVERE );
+    ~CorePool();
+
+    Core* acquire( const std::string& inifile ) throw ( h_exception );
+    void release( const std::string& inifile, Core* core, bool reusable );
+
+    void forEach( const std::string& inifile, int units, int threads,
+                  const std::function<bool( Core*, int, int )>& work ) throw ( h_exception );
+
+    size_t idleCount( const std::string& inifile );
+
+private:
+    Logger::LogLevel loglvl;
+
+    std::mutex mutex;
+
+    //! Cores not in use, by input file
+    std::map<std::string, std::vector<Core*> > idle;
+
+    CorePool( const CorePool& );
+    CorePool& operator=( const CorePool& );
+};
+
+}
+
+#endif // CORE_POOL_H
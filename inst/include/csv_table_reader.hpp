@@ -15,8 +15,10 @@
  */
 
 #include <fstream>
+#include <vector>
 
 #include "h_exception.hpp"
+#include "unitval.hpp"
 
 namespace Hector {
 
@@ -46,6 +48,9 @@ public:
     void process( Core* core, const std::string& componentName,
                   const std::string& varName ) throw ( h_exception );
 
+    void readSeries( const std::string& varName, std::vector<double>& dates,
+                     std::vector<unitval>& values ) throw ( h_exception );
+
 private:
     //! The file name to read data from.  Kept around for error reporting.
     const std::string fileName;
@@ -59,6 +64,10 @@ private:
     // Helper function to find next non-commented line
     std::string csv_getline();
 
+    void readColumn( const std::string& varName, std::vector<double>& dates,
+                     std::vector<std::string>& values,
+                     std::vector<std::string>& units ) throw ( h_exception );
+
 };
 
 }
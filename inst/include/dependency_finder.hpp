@@ -40,12 +40,12 @@ namespace Hector {
 *          createOrdering has completed, the user can then call getOrdering to
 *          return an ordered list of objects, starting with the object which has
 *          no dependencies.
-*          The two key data structures are mDependencyMatrix and mObjectIndices.
-*          mDependencyMatrix is a two-dimensional matrix where each cell
-*          represents whether there is a dependency from the column object to
-*          the row object. mObjectIndices contains a mapping of object name to
-*          the index in mDependencyMatrix. Both of these data structures are
-*          updated by the addDependency function.
+*          The two key data structures are mDependencies and mObjectIndices.
+*          mDependencies is an adjacency list giving, for each object, the
+*          indices of the objects it depends on. mObjectIndices contains a
+*          mapping of object name to the index in mDependencies, and
+*          mObjectNames the reverse. These data structures are updated by the
+*          addDependency function.
 * \author Josh Lurz
 */
 
@@ -59,7 +59,6 @@ public:
     const std::vector<std::string>& getOrdering() const;
 private:
     void removeDependency( const size_t aObject, const size_t aDependency );
-    const std::string& getNameFromIndex( const size_t aIndex ) const;
 
     // Need the typedef here as addTrackedItem returns a ObjectIndexMap
     // iterator.
@@ -69,13 +68,15 @@ private:
     //! indicator for whether or not the ordering has been computed.
     bool ordcomputed;
 
-    //! Mapping of sector name to matrix index to avoid storing all names as
-    //! strings within the matrix.
+    //! Mapping of sector name to index to avoid storing all names as
+    //! strings within the dependency lists.
     ObjectIndexMap mObjectIndices;
 
-    //! A square matrix where each cell contains whether the column sector
-    //! depends on the row sector.
-    std::vector<std::vector<bool> > mDependencyMatrix;
+    //! Sector names by index.
+    std::vector<std::string> mObjectNames;
+
+    //! For each sector, the indices of the sectors it depends on.
+    std::vector<std::vector<size_t> > mDependencies;
 
     //! The correctly ordered list of sectors.
     std::vector<std::string> mOrdering;
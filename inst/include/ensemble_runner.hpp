@@ -0,0 +1,105 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+#ifndef ENSEMBLE_RUNNER_H
+#define ENSEMBLE_RUNNER_H
+/*
+ *  ensemble_runner.hpp - runs the members of a parameter ensemble
+ *  hector
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#include "core_pool.hpp"
+#include "ensemble_stats.hpp"
+#include "h_exception.hpp"
+#include "unitval.hpp"
+
+namespace Hector {
+
+/*! \brief Runs an ensemble whose members differ in their parameter values.
+ *
+ *  Members are run in any number of threads, each with its own core set up
+ *  from the input file (cores are kept between calls to run()).  Each
+ *  member's outputs are folded into a per-thread EnsembleStats as soon as
+ *  it finishes, so no member's trajectory is kept unless it is asked for.
+ *
+ *  Members are run in chunks of consecutive members; the per-thread
+ *  summaries are merged at the end of each chunk, and the chunk's outputs,
+ *  if an output file is set, are appended to it.  If a journal is set, the
+ *  summary is then checkpointed and the chunk recorded in the journal, an
+ *  append-only text file.  A run that finds a journal from an earlier,
+ *  interrupted run of the same members picks up after the last chunk it
+ *  records: the summary is reloaded from that chunk's checkpoint and the
+ *  output file cut back to the length recorded with it, so members that
+ *  were under way are neither lost nor counted twice.  Files are flushed
+ *  after each chunk, which survives the death of the process but not
+ *  necessarily of the machine.
+ *
+ *  A member whose run fails (because of bad parameter values, say, or an
+ *  exhausted run budget) doesn't stop the others.  It is left out of the
+ *  summary and the output file and listed by getFailures() with the
+ *  reason.  The journal records it with its chunk, so a resumed run
+ *  doesn't try it again.
+ */
+class EnsembleRunner {
+public:
+    EnsembleRunner( const std::string& inifile );
+
+    void addParameter( const std::string& datum, unit_types units );
+    void addMember( const std::vector<double>& values ) throw ( h_exception );
+    size_t size() const;
+
+    void setChunkSize( int members ) throw ( h_exception );
+    void setJournal( const std::string& fileName ) { journalFile = fileName; };
+    void setOutputFile( const std::string& fileName ) { outputFile = fileName; };
+
+    void run( EnsembleStats& stats, int threads=1 ) throw ( h_exception );
+
+    //! A member whose run failed
+    struct failure {
+        size_t member;
+        std::string reason;
+    };
+    const std::vector<failure>& getFailures() const { return failures; };
+
+private:
+    //! A parameter the members set
+    struct parameter {
+        std::string datum;
+        unit_types units;
+    };
+
+    std::string inifile;
+    std::vector<parameter> parameters;
+    //! Parameter values, [ member * parameters + parameter ]
+    std::vector<double> members;
+
+    //! Members per chunk
+    int chunkSize;
+    std::string journalFile;
+    //! Per-member outputs, as CSV; not written if empty
+    std::string outputFile;
+
+    //! Members that failed in the last run, in order
+    std::vector<failure> failures;
+
+    //! Cores for the worker threads
+    CorePool pool;
+
+    std::string journalHeader() const;
+    std::string checkpointFile( int chunk ) const;
+    int resume( EnsembleStats& stats, long& outputEnd ) throw ( h_exception );
+
+    EnsembleRunner( const EnsembleRunner& );
+    EnsembleRunner& operator=( const EnsembleRunner& );
+};
+
+}
+
+#endif // ENSEMBLE_RUNNER_H
@@ -0,0 +1,89 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+#ifndef ENSEMBLE_STATS_H
+#define ENSEMBLE_STATS_H
+/*
+ *  ensemble_stats.hpp - running summaries of ensemble outputs
+ *  hector
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core.hpp"
+#include "h_exception.hpp"
+#include "quantile_sketch.hpp"
+
+namespace Hector {
+
+/*! \brief Per-date summaries of model outputs over the members of an ensemble.
+ *
+ *  Each member's outputs are folded in as it finishes, and then no longer
+ *  needed: for each output and date the summary keeps the mean and variance
+ *  (Welford's method), a quantile sketch, and the number of members above
+ *  each of the output's thresholds.  Memory does not depend on the number of
+ *  members.  Summaries of parts of an ensemble (run in different threads or
+ *  processes, say) can be merged, and a summary can be written out and read
+ *  back to carry on later.
+ */
+class EnsembleStats {
+public:
+    EnsembleStats( const std::vector<std::string>& outputs, const std::vector<double>& dates,
+                   double compression=100.0 );
+
+    void addThreshold( const std::string& datum, double threshold ) throw ( h_exception );
+
+    void fetch( Core* core, std::vector<double>& values ) const throw ( h_exception );
+    void add( Core* core ) throw ( h_exception );
+    void add( const std::vector<double>& values ) throw ( h_exception );
+    void merge( const EnsembleStats& other ) throw ( h_exception );
+    void clear();
+
+    double getMembers() const { return members; };
+    double getMean( size_t output, size_t date ) const;
+    double getVariance( size_t output, size_t date ) const;
+    double getQuantile( size_t output, size_t date, double q ) const;
+    const std::vector<double>& getThresholds( size_t output ) const { return thresholds[ output ]; };
+    double getExceedance( size_t output, size_t date, size_t threshold ) const;
+
+    const std::vector<std::string>& getOutputs() const { return outputs; };
+    const std::vector<double>& getDates() const { return dates; };
+
+    void write( std::ostream& out ) const;
+    void read( std::istream& in ) throw ( h_exception );
+
+private:
+    //! Running summary of one output at one date
+    struct summary {
+        double mean;
+        //! Sum of squared deviations from the mean
+        double m2;
+        QuantileSketch sketch;
+        //! Members above each threshold
+        std::vector<double> exceed;
+
+        summary( double compression ) : mean( 0.0 ), m2( 0.0 ), sketch( compression ) {}
+    };
+
+    std::vector<std::string> outputs;
+    std::vector<double> dates;
+    double compression;
+    //! Thresholds, by output
+    std::vector<std::vector<double> > thresholds;
+
+    double members;
+    //! Summaries, [ output * dates + date ]
+    std::vector<summary> summaries;
+
+    const summary& get( size_t output, size_t date ) const;
+};
+
+}
+
+#endif // ENSEMBLE_STATS_H
@@ -14,6 +14,8 @@
  *
  */
 
+#include <boost/array.hpp>
+
 #include "imodel_component.hpp"
 #include "ch4_component.hpp"
 #include "n2o_component.hpp"
@@ -68,18 +70,44 @@ public:
     //! IVisitable methods
     virtual void accept( AVisitor* visitor );
 
-    //! A list (map) of all computed forcings, with associated iterator
-    typedef std::map<std::string, unitval > forcings_t;
-    typedef std::map<std::string, unitval >::iterator forcingsIterator;
+    //! Index of each forcing agent in the per-year forcing arrays.  The
+    //! halocarbons follow F_HALO in the order of halo_forcing_names.
+    enum forcing_agent {
+        F_TOTAL,
+        F_CO2,
+        F_T_ALBEDO,
+        F_CH4,
+        F_N2O,
+        F_H2O_STRAT,
+        F_O3_TROP,
+        F_BC,
+        F_OC,
+        F_SO2D,
+        F_SO2I,
+        F_VOL,
+        F_HALO,
+        N_FORCINGS = F_HALO + N_HALO_FORCINGS
+    };
+
+    //! All computed forcings for one year, indexed by forcing_agent
+    typedef boost::array<unitval, N_FORCINGS> forcings_t;
 
 private:
     virtual unitval getData( const std::string& varName,
                             const double valueIndex ) throw ( h_exception );
 
+    const forcings_t& getForcings( double date ) const throw ( h_exception );
+
+    static const char* getForcingName( int agent ) {
+        return agent < F_HALO ? forcing_names[agent] : halo_forcing_names[agent-F_HALO];
+    }
+
+    //! Which agents are computed in this run (depends on the enabled components)
+    boost::array<bool, N_FORCINGS> forcing_present;
     //! Base year forcings
     forcings_t baseyear_forcings;
-    //! Forcings by year
-    tvector<forcings_t> forcings_ts;
+    //! Forcings by year, starting at the base year
+    std::vector<forcings_t> forcings_ts;
 
     double baseyear;        //! Year which forcing calculations will start
     double currentYear;     //! Tracks current year
@@ -90,9 +118,13 @@ private:
     Core* core;             //! Core
     Logger logger;          //! Logger
 
+    static const char *forcing_names[F_HALO];    //! Names of the forcings that aren't halocarbons
     static const char *adjusted_halo_forcings[]; //! Capability strings for halocarbon forcings
     static const char *halo_forcing_names[];  //! Internal names of halocarbon forcings
-    static std::map<std::string, std::string> forcing_name_map;
+    //! Agent index for each forcing name, including the adjusted halocarbon names
+    static const std::map<std::string, int>& forcing_index();
+    //! Agents sorted by name; totals are summed and output in this order
+    static const std::vector<int>& forcing_order();
 };
 
 }
@@ -0,0 +1,184 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+#ifndef H_ARENA_H
+#define H_ARENA_H
+/*
+ *  h_arena.hpp - memory pool for the small objects owned by one core
+ *  hector
+ *
+ */
+
+#include <map>
+#include <memory>
+#include <new>
+#include <vector>
+#include <cstddef>
+
+namespace Hector {
+
+/*! \brief A pool of memory for the many small objects a core allocates.
+ *
+ *  Memory is carved from large blocks and recycled through one free list per
+ *  size class, so after the first pass through the run, allocation and
+ *  deallocation are a few pointer operations and never touch the global
+ *  heap.  Cores that each have their own arena don't compete for the heap
+ *  when they run in different threads.  The blocks are all released at once
+ *  when the arena is destroyed.  Requests bigger than the largest size class
+ *  go to the global heap.
+ *
+ *  An arena takes no locks, so only one thread at a time may use it: the one
+ *  running its core.  Data that cores share (see tseries::share) are kept on
+ *  the global heap instead.
+ *
+ *  Containers reach an arena through arena_allocator, which picks up the
+ *  arena that is current in its thread when it is constructed (see scope).
+ *  Containers hold a reference to their arena, so it lives as long as any
+ *  of them do, even if its core is gone.
+ */
+class h_arena {
+public:
+    h_arena() : next( NULL ), end( NULL ) {
+        for( size_t i=0; i<NCLASSES; ++i )
+            freelist[ i ] = NULL;
+    }
+    ~h_arena() {
+        for( size_t i=0; i<blocks.size(); ++i )
+            ::operator delete( blocks[ i ] );
+    }
+
+    void* allocate( size_t bytes );
+    void deallocate( void* p, size_t bytes );
+
+    //! The arena new containers in this thread allocate from (may be null)
+    static std::shared_ptr<h_arena>& current() {
+        static thread_local std::shared_ptr<h_arena> arena;
+        return arena;
+    }
+
+    /*! \brief Make an arena current for the lifetime of this object.
+     *
+     *  Scopes nest; the previous arena is restored on exit.  A null arena
+     *  means containers use the global heap.
+     */
+    class scope {
+        std::shared_ptr<h_arena> previous;
+    public:
+        explicit scope( const std::shared_ptr<h_arena>& arena ) : previous( current() ) {
+            current() = arena;
+        }
+        ~scope() { current() = previous; }
+    };
+
+private:
+    static const size_t GRAIN = 16;             // size classes are multiples of this
+    static const size_t NCLASSES = 16;          // largest pooled size is GRAIN*NCLASSES
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    struct free_node { free_node* next; };
+
+    std::vector<char*> blocks;
+    char* next;                 // unused part of the newest block
+    char* end;
+    free_node* freelist[ NCLASSES ];
+
+    h_arena( const h_arena& );
+    h_arena& operator=( const h_arena& );
+};
+
+//-----------------------------------------------------------------------
+/*! \brief Get memory for an object of the given size.
+ */
+inline void* h_arena::allocate( size_t bytes ) {
+    if( bytes == 0 || bytes > GRAIN * NCLASSES )
+        return ::operator new( bytes );
+    const size_t c = ( bytes - 1 ) / GRAIN;
+    if( freelist[ c ] ) {
+        free_node* p = freelist[ c ];
+        freelist[ c ] = p->next;
+        return p;
+    }
+    const size_t size = ( c + 1 ) * GRAIN;
+    if( size_t( end - next ) < size ) {
+        blocks.push_back( static_cast<char*>( ::operator new( BLOCK_SIZE ) ) );
+        next = blocks.back();
+        end = next + BLOCK_SIZE;
+    }
+    void* p = next;
+    next += size;
+    return p;
+}
+
+//-----------------------------------------------------------------------
+/*! \brief Return memory from allocate() to the arena.
+ *  \param bytes The size that was requested from allocate().
+ */
+inline void h_arena::deallocate( void* p, size_t bytes ) {
+    if( bytes == 0 || bytes > GRAIN * NCLASSES ) {
+        ::operator delete( p );
+        return;
+    }
+    const size_t c = ( bytes - 1 ) / GRAIN;
+    free_node* node = static_cast<free_node*>( p );
+    node->next = freelist[ c ];
+    freelist[ c ] = node;
+}
+
+
+//-----------------------------------------------------------------------
+/*! \brief Standard allocator that draws on an h_arena.
+ *
+ *  A default-constructed allocator uses the thread's current arena, or the
+ *  global heap if there is none.  Copies use the same arena as the original.
+ *  heap() gives one that always uses the global heap.
+ */
+template <class T>
+class arena_allocator {
+public:
+    typedef T value_type;
+
+    arena_allocator() : arena( h_arena::current() ) {}
+    template <class U>
+    arena_allocator( const arena_allocator<U>& other ) : arena( other.arena ) {}
+
+    static arena_allocator heap() {
+        return arena_allocator( std::shared_ptr<h_arena>() );
+    }
+
+    T* allocate( size_t n ) {
+        if( arena )
+            return static_cast<T*>( arena->allocate( n * sizeof( T ) ) );
+        return static_cast<T*>( ::operator new( n * sizeof( T ) ) );
+    }
+    void deallocate( T* p, size_t n ) {
+        if( arena )
+            arena->deallocate( p, n * sizeof( T ) );
+        else
+            ::operator delete( p );
+    }
+
+    std::shared_ptr<h_arena> arena;
+
+private:
+    explicit arena_allocator( const std::shared_ptr<h_arena>& a ) : arena( a ) {}
+};
+
+template <class T, class U>
+bool operator==( const arena_allocator<T>& a, const arena_allocator<U>& b ) {
+    return a.arena == b.arena;
+}
+template <class T, class U>
+bool operator!=( const arena_allocator<T>& a, const arena_allocator<U>& b ) {
+    return a.arena != b.arena;
+}
+
+//! A map whose nodes come from the current arena
+template <class K, class V>
+using arena_map = std::map<K, V, std::less<K>, arena_allocator<std::pair<const K, V> > >;
+
+}
+
+#endif // H_ARENA_H
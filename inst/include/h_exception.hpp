@@ -51,6 +51,28 @@ class h_exception : public std::exception {
 };
 
 
+//-----------------------------------------------------------------------
+/*! \brief Exception for a run that was cancelled or ran over its budget.
+ *
+ *  The model isn't necessarily wrong when this happens, so callers running
+ *  many members can catch it separately from other errors, record the
+ *  member as failed, and move on.
+ */
+class h_run_aborted : public h_exception {
+  public:
+    enum reason { CANCELLED, TIME_BUDGET, EVALUATION_BUDGET };
+
+    h_run_aborted(reason why_p, std::string msg_p, std::string func_p,
+                  std::string file_p, int linenum_p)
+            : h_exception(msg_p, func_p, file_p, linenum_p), why(why_p) {
+    }
+    reason getReason() const { return why; }
+
+  private:
+    reason why;
+};
+
+
 //-----------------------------------------------------------------------
 /*! \brief Insertion operator for h_exception objects
  *
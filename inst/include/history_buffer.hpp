@@ -0,0 +1,82 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+#ifndef HISTORY_BUFFER_H
+#define HISTORY_BUFFER_H
+/*
+ *  history_buffer.hpp - fixed-capacity record of recent values
+ *  hector
+ *
+ */
+
+#include <vector>
+#include <algorithm>
+
+namespace Hector {
+
+/*! \brief A bounded history of recent values, most recent first.
+ *
+ *  Implemented as a ring buffer.  Once the buffer is full, adding a value
+ *  drops the oldest one, so adding is constant time and the memory used
+ *  doesn't grow with the length of the run.  Element 0 is the most recently
+ *  added value, element 1 the one before that, and so on.
+ */
+template <class T_data>
+class history_buffer {
+    std::vector<T_data> data;
+    size_t head;                // position of the most recent value
+    size_t count;               // number of values held
+public:
+    history_buffer() : head( 0 ), count( 0 ) {}
+
+    void push_front( const T_data& d );
+
+    const T_data& operator[]( size_t i ) const {
+        return data[ ( head + i ) % data.size() ];
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return data.size(); }
+
+    void set_capacity( size_t n );
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+};
+
+/*! \brief Add a value, dropping the oldest one if the buffer is full.
+ */
+template <class T_data>
+void history_buffer<T_data>::push_front( const T_data& d ) {
+    if( data.empty() )
+        return;
+    head = ( head + data.size() - 1 ) % data.size();
+    data[ head ] = d;
+    count = std::min( count + 1, data.size() );
+}
+
+/*! \brief Change how many values the buffer holds.
+ *
+ *  The most recent values, up to the new capacity, are kept.
+ */
+template <class T_data>
+void history_buffer<T_data>::set_capacity( size_t n ) {
+    if( n == data.size() )
+        return;
+    std::vector<T_data> newdata( n );
+    size_t newcount = std::min( count, n );
+    for( size_t i=0; i<newcount; ++i )
+        newdata[ i ] = (*this)[ i ];
+    data.swap( newdata );
+    head = 0;
+    count = newcount;
+}
+
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include "unitval.hpp"
 #include "message_data.hpp"
 #include "h_exception.hpp"
+#include "tseries.hpp"
 
 namespace Hector {
 
@@ -125,6 +126,39 @@ public:
      */
     virtual bool run_spinup( const int step ) throw ( h_exception ) { return true; }
 
+    //------------------------------------------------------------------------------
+    /*! \brief Where the component keeps the current value of a variable.
+     *
+     *  The core reads some outputs after every time step (coupling buffers,
+     *  output subscriptions, stop conditions).  Components can let it read
+     *  them directly instead of through sendMessage and getData, which
+     *  compare names on every call.  Most components don't, and simply
+     *  inherit the implementation below.
+     *
+     *  \param varName The name of the variable.
+     *  \return A pointer to the member holding what getData( varName,
+     *          Core::undefinedIndex() ) returns, valid for the lifetime of the
+     *          component; or NULL if the variable must be read with getData.
+     */
+    virtual const unitval* getCurrentValuePtr( const std::string& varName ) const { return NULL; }
+
+    //------------------------------------------------------------------------------
+    /*! \brief Where the component keeps a dated input.
+     *
+     *  Coupling buffers set inputs (emissions, mostly) before every time
+     *  step.  Components can let the core write them directly instead of
+     *  through sendMessage and setData.  Only inputs that setData stores
+     *  without further processing may be exposed this way.
+     *
+     *  \param varName The name of the input.
+     *  \param units Set to the units the series holds, which values written
+     *         to it must have.
+     *  \return A pointer to the series, valid for the lifetime of the
+     *          component; or NULL if the input must be set with setData.
+     */
+    virtual tseries<unitval>* getInputSeriesPtr( const std::string& varName,
+                                                 unit_types& units ) { return NULL; }
+
     //------------------------------------------------------------------------------
     /*! \brief Reset the component's state to what it was at some previous time.
      *
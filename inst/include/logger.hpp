@@ -16,14 +16,58 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <mutex>
 
 #include "h_exception.hpp"
 
 #define LOG_DIRECTORY "logs/"
 #define LOG_EXTENSION ".log"
+#define LOG_SINK_BUFSIZE 65536
 
 namespace Hector {
 
+//------------------------------------------------------------------------------
+/*! \brief A log destination shared by all of the loggers in a process.
+ *
+ *  Normally every logger writes its own file, so a core holds a file handle
+ *  for each of its components.  Once the shared sink has been opened, loggers
+ *  that log to file send their messages here instead, each line tagged with
+ *  the core and component it came from.  Lines are collected in memory and
+ *  written out in large blocks.
+ */
+class LogSink {
+public:
+    static LogSink& getSink();
+
+    void open( const std::string& logName ) throw ( h_exception );
+    bool isOpen() const {
+        return isInitialized;
+    }
+    void write( const std::string& tag, const std::string& text );
+    void flush();
+    void close();
+
+private:
+    LogSink();
+    ~LogSink();
+    LogSink( const LogSink& );
+    LogSink& operator=( const LogSink& );
+
+    void flushPending();
+
+    //! Flag to indicate that the sink has been opened.
+    bool isInitialized;
+    //! The log file.
+    std::filebuf logFile;
+    //! Tagged lines not yet written to the log file.
+    std::string pending;
+    //! Serializes access from loggers of cores in different threads.
+    std::mutex sinkMutex;
+};
+
 //------------------------------------------------------------------------------
 /*! \brief Logger class
  *
@@ -32,6 +76,7 @@ namespace Hector {
  *  with a high enough priority will actually be processed.
  */
 class Logger {
+    friend class LogSink;
 public:
     /*! \brief Enumeration to describe available logging priority levels.
      */
@@ -61,8 +106,15 @@ private:
     //! If false this logger does not log regardless of log level provided.
     bool enabled;
 
-    //! The actual output stream which will handle the logging.
-    std::ostream loggerStream;
+    //! The actual output stream which will handle the logging.  This is
+    //! only allocated for loggers that are enabled.
+    std::ostream* loggerStream;
+
+    //! Prefix identifying the core, shared by all of its loggers.
+    std::string tagPrefix;
+
+    //! Tag identifying this logger's messages in the shared sink.
+    std::string tag;
 
     static const std::string& logLevelToStr( const LogLevel logLevel );
 
@@ -95,12 +147,34 @@ private:
         virtual std::streamsize xsputn( const char* s, std::streamsize n );
     };
 
+    /*! \brief A stream buffer which passes complete messages on to the
+     *         shared log sink, optionally echoing them to a console.
+     */
+    class SinkStreamBuf : public std::stringbuf {
+    private:
+        //! The tag attached to each line sent to the sink.
+        std::string tag;
+
+        //! A pointer to the streambuf of the console output stream, or null
+        //! if echoToScreen was set to false during construction.
+        std::streambuf* consoleBuf;
+
+    public:
+        SinkStreamBuf( const std::string& tag, const bool echoToScreen );
+
+    protected:
+        // std::streambuf methods
+        virtual int sync();
+    };
+
 public:
     Logger();
     ~Logger();
 
     void open( const std::string& logName, bool echoToScreen,
-               bool echoToFile, LogLevel minLogLevel ) throw ( h_exception );
+               bool echoToFile, LogLevel minLogLevel,
+               const std::string& tagPrefix="" ) throw ( h_exception );
+    void open( const std::string& logName, const Logger& parent ) throw ( h_exception );
 
     bool shouldWrite( const LogLevel writeLevel ) const;
 
@@ -117,6 +191,10 @@ public:
         return echoToFile;
     }
 
+    const std::string& getTagPrefix() const {
+        return tagPrefix;
+    }
+
     bool isEnabled() const {
         return enabled;
     }
@@ -98,6 +98,7 @@ private:
 
     // Atmosphere-ocean flux
     unitval annualflux_sum, annualflux_sumHL, annualflux_sumLL;     //!< Running annual totals atm-ocean flux, for output reporting
+    double annualflux_years;            //!< Years the running totals cover (more than one for a multi-year time step)
     unitval lastflux_annualized;        //!< Last atm-ocean flux when solver ordered us to 'stash' C values
 
     // Spinup mode flag
@@ -142,25 +143,30 @@ private:
      * These are used to record the component state over time so that
      * we can reset to a previous time.
      *****************************************************************/
-    // Ocean boxes over time
-    tvector<oceanbox> surfaceHL_tv;
-    tvector<oceanbox> surfaceLL_tv;
-    tvector<oceanbox> inter_tv;
-    tvector<oceanbox> deep_tv;
-
-    // Ocean conditions over time
-    tseries<unitval> Tgav_ts;
-    tseries<unitval> Ca_ts;
-
-    // Atmosphere-ocean flux
-    tseries<unitval> annualflux_sum_ts;
-    tseries<unitval> annualflux_sumHL_ts;
-    tseries<unitval> annualflux_sumLL_ts;
-    tseries<unitval> lastflux_annualized_ts;
-
-    // timestep control
-    tseries<double> max_timestep_ts;
-    tseries<int> reduced_timestep_timeout_ts;
+    //! Component state at the end of a year
+    struct ocean_state {
+        // Ocean boxes
+        oceanbox_state surfaceHL;
+        oceanbox_state surfaceLL;
+        oceanbox_state inter;
+        oceanbox_state deep;
+
+        // Ocean conditions
+        unitval Tgav;
+        unitval Ca;
+
+        // Atmosphere-ocean flux
+        unitval annualflux_sum;
+        unitval annualflux_sumHL;
+        unitval annualflux_sumLL;
+        double annualflux_years;
+        unitval lastflux_annualized;
+
+        // timestep control
+        double max_timestep;
+        int reduced_timestep_timeout;
+    };
+    tvector<ocean_state> state_tv;
 
     //! logger
     Logger logger;
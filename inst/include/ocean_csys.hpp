@@ -42,7 +42,7 @@ public:
 	unitval OmegaCa;
 	unitval OmegaAr;
 	double U;       //<! average wind speed over each surface box
-	double H;
+	double H;       //<! H+ concentration from the last run (mol/kg); 0=none, solve from scratch
 
 	//<! output variables
 	unitval TCO2o;  //<! total CO2 (umol/kg)
@@ -54,6 +54,7 @@ public:
 	unitval convertToDIC( const unitval carbon );
 	void ocean_csys_run( unitval tbox, unitval carbon );
     unitval calc_annual_surface_flux( const unitval& Ca, const double cpoolscale=1.0 ) const;
+    double calc_alk_for_flux( unitval tbox, unitval carbon, const unitval& Ca, const unitval& flux );
     unitval get_K0() const { return K0; };
     unitval get_Tr() const { return Tr; };
 
@@ -62,6 +63,8 @@ public:
 
 private:
     double calc_monthly_surface_flux( const unitval& Ca, const double cpoolscale=1.0 ) const;
+    void calc_constants( const double Tc );
+    void calc_coefficients( const double dic, const double alk, double* a ) const;
 
 	unitval K0;     //<! solubility of CO2 calculated from Weiss 1974 (mol * L-1 * atm-1)
 	unitval Tr;     //<! gas transfer coefficient (gC m-2 month-1 uatm-1)
@@ -79,9 +82,13 @@ private:
     // logger
     Logger* logger;
 
-    // persistent workspace
-    int ncoeffs;
-    std::vector<double> m_a;
+    // The equilibrium constants depend only on temperature and salinity, and
+    // are only recomputed when one of those changes.
+    bool constants_valid;   //<! K0...Kspc are set for constants_Tc and constants_S
+    double constants_Tc;    //<! temperature the constants were computed for (degC)
+    double constants_S;     //<! salinity the constants were computed for
+    double Sc_factor;       //<! Sc^-0.5, for the gas transfer coefficient
+    double bor;             //<! total boron (mol/kg)
 
 };
 
@@ -18,6 +18,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <tuple>
 #include "math.h"
 #include <stdio.h>
 #include <algorithm>
@@ -25,11 +26,45 @@
 #include "logger.hpp"
 #include "unitval.hpp"
 #include "ocean_csys.hpp"
+#include "history_buffer.hpp"
 
 #define MEAN_GLOBAL_TEMP 15
+#define OB_HISTORY_LOOKBACK 10  // past states kept for the (optional) oscillation check
+#define OB_STATE_LOOKBACK 1     // past C states held in a box state; must cover the connection windows
+#define OB_MAX_CONNECTIONS 3    // box-to-box connections a box state can hold
+#define OB_EQUILIBRIUM_MEMO 16  // chem_equilibrate results remembered per box
+#define OB_EQUILIBRIUM_STEP 1e-3 // chem_equilibrate's first bracketing step, relative to its guess
 
 namespace Hector {
 
+/*! \brief The dynamic state of an ocean box at the end of a year.
+ *
+ *  Holds only what changes as the model runs--the connections, parameters,
+ *  and chemistry constants are fixed once the box is set up--so that it's
+ *  cheap to record every year and enough to reset the box from.  Values are
+ *  stored in fixed units (noted below); ones that haven't been computed yet
+ *  are recorded as zero.  The chemistry outputs are only recorded if the
+ *  box's chemistry is active.
+ */
+struct oceanbox_state {
+    double carbon;                                  //!< Pg C
+    double carbon_history[ OB_STATE_LOOKBACK ];     //!< recent past C states, most recent first, Pg C
+    unsigned carbon_history_size;                   //!< number of carbon_history entries in use
+    double atmosphere_flux;                         //!< Pg C
+    double Tbox;                                    //!< degC
+    double dic_lastyear;                            //!< umol/kg
+    double box_fluxes[ OB_MAX_CONNECTIONS ];        //!< Pg C/yr, in connection order
+    bool active_chemistry;
+
+    double alk;                                     //!< mol/kg
+    double H;                                       //!< mol/kg, where the chemistry's root solve starts
+    double pH;                                      //!< pH
+    double PCO2o;                                   //!< uatm
+    double CO3;                                     //!< umol/kg
+    double OmegaCa;                                 //!< unitless
+    double OmegaAr;                                 //!< unitless
+};
+
 class oceanbox {
     /*! /brief  An ocean box
      *
@@ -42,11 +77,11 @@ private:
 	unitval CarbonToAdd;
 	std::vector<oceanbox*> connection_list;  //<! a vector of ocean box pointers
 	std::vector<double> connection_k;        //<! a vector of ocean k values (fraction)
-	std::vector<double> carbonHistory;       //<! a vector of past C states
-   	std::vector<double> carbonLossHistory;   //<! a vector of past C losses
+	history_buffer<double> carbonHistory;      //<! recent past C states, most recent first
+	history_buffer<double> carbonLossHistory;  //<! recent past C losses, most recent first
 	std::vector<int> connection_window;      //<! a vector of connection windows to average over
 
-    double vectorHistoryMean( std::vector<double> v, int lookback ) const;
+    double vectorHistoryMean( const history_buffer<double>& v, int lookback ) const;
 
     unitval compute_connection_flux( int i, double yf ) const;
 
@@ -60,6 +95,10 @@ private:
     unitval dic_lastyear;   //
     unitval compute_tabsC( const unitval Tgav ) const;
 
+    //! Alkalinities found by chem_equilibrate, keyed by (carbon, Tbox, target flux, Ca)
+    typedef std::tuple<double, double, double, double> equilibrium_key;
+    std::map<equilibrium_key, double> equilibrium_memo;
+
 public:
 	oceanbox (); // constructor
 
@@ -72,6 +111,9 @@ public:
 	void update_state();
 	void new_year( const unitval Tgav );
 
+	oceanbox_state get_state() const;
+	void set_state( const oceanbox_state& state );
+
 	void set_carbon( const unitval C );
 	unitval get_carbon() const { return carbon; };
 	void add_carbon( unitval C );
@@ -93,7 +135,7 @@ public:
     oceancsys mychemistry;      //<! box chemistry
 	bool active_chemistry;      //<! box has active chemistry model?
 	void chem_equilibrate( const unitval current_Ca );    //<! equilibrate chemistry model to a given flux
-    double fmin( double alk, void *params );
+    double flux_residual( double alk, double f_target );
 
     unitval atmosphere_flux;
 
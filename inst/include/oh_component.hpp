@@ -45,6 +45,9 @@ public:
     virtual void setData( const std::string& varName,
                           const message_data& data ) throw ( h_exception );
 
+    virtual tseries<unitval>* getInputSeriesPtr( const std::string& varName,
+                                                 unit_types& units );
+
     virtual void prepareToRun() throw ( h_exception );
 
     virtual void run( const double runToDate ) throw ( h_exception );
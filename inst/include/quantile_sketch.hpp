@@ -0,0 +1,67 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+/*
+ *  quantile_sketch.hpp - mergeable approximate quantiles of a stream
+ *  hector
+ *
+ */
+
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "h_exception.hpp"
+
+namespace Hector {
+
+/*! \brief Approximate quantiles of a stream of values, in bounded memory.
+ *
+ *  This is a merging t-digest (Dunning & Ertl, 2019).  Values are summarized
+ *  by centroids (a mean and a weight), which are kept small near the tails
+ *  so that extreme quantiles stay accurate.  The compression parameter
+ *  bounds the number of centroids at about its own value.  Sketches of
+ *  separate streams can be merged, and the minimum and maximum are exact.
+ *
+ *  Added values are buffered, and folded into the centroids when the buffer
+ *  fills and on merge().  The const members never change the sketch (while
+ *  values are buffered they work on a folded copy), so they are safe to call
+ *  from several threads at once.
+ */
+class QuantileSketch {
+public:
+    QuantileSketch( double compression=100.0 );
+
+    void add( double x );
+    void merge( const QuantileSketch& other );
+
+    double quantile( double q ) const;
+    double count() const { return total; };
+
+    void write( std::ostream& out ) const;
+    void read( std::istream& in ) throw ( h_exception );
+
+private:
+    //! A centroid: mean and weight
+    typedef std::pair<double, double> centroid;
+
+    double compression;
+    //! Centroids, in order of mean, once compressed
+    std::vector<centroid> centroids;
+    //! Values not yet folded into the centroids
+    std::vector<centroid> buffer;
+    double total;
+    double min;
+    double max;
+
+    void compress();
+};
+
+}
+
+#endif // QUANTILE_SKETCH_H
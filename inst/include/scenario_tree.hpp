@@ -0,0 +1,97 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+#ifndef SCENARIO_TREE_H
+#define SCENARIO_TREE_H
+/*
+ *  scenario_tree.hpp - runs a set of scenarios that share their history
+ *  hector
+ *
+ */
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core.hpp"
+#include "h_exception.hpp"
+#include "unitval.hpp"
+
+namespace Hector {
+
+/*! \brief Runs several scenarios on one core, running their common history once.
+ *
+ *  A scenario is a set of dated input values (emissions, say) that replace
+ *  the core's own inputs.  Scenarios in an ensemble are usually identical up
+ *  to some year and differ afterwards.  The runner finds the first date at
+ *  which any two of them differ (the fork date), runs the model once up to
+ *  the time step before it, and then runs each scenario in turn from there:
+ *  the core is reset to the last date that is still valid for the next
+ *  scenario, which is the fork date or later, so the shared history is never
+ *  recomputed.  The outputs are the same as those of independent runs.
+ *
+ *  When run() returns, the core's inputs are restored to what they were, and
+ *  the core is left marked as needing to apply the restored values
+ *  (Core::changesPending()).  Scenarios may also set parameters (inputs
+ *  without a date); scenarios that differ in one share no history.
+ */
+class ScenarioTree {
+public:
+    ScenarioTree( Core* core );
+
+    int addScenario( const std::string& name );
+    void setInput( int scenario, const std::string& datum, double date,
+                   const unitval& value ) throw ( h_exception );
+
+    double getForkDate() throw ( h_exception );
+
+    void run( const std::vector<std::string>& outputs, const std::vector<double>& dates,
+              double runtodate=-1.0 ) throw ( h_exception );
+
+    size_t size() const { return scenarios.size(); };
+    const std::string& getName( int scenario ) const throw ( h_exception );
+    const std::vector<double>& getValues( int scenario ) const throw ( h_exception );
+    const std::vector<unit_types>& getUnits() const { return units; };
+
+private:
+    //! An input datum at a date
+    typedef std::pair<std::string, double> input_key;
+
+    //! The inputs a scenario sets
+    struct scenario {
+        std::string name;
+        std::map<input_key, unitval> inputs;
+        //! Outputs: one row per date, one value per output datum
+        std::vector<double> values;
+    };
+
+    Core* core;
+    std::vector<scenario> scenarios;
+
+    //! The core's own values of every input some scenario sets
+    std::map<input_key, unitval> baseInputs;
+    //! Inputs some scenario sets that the core has no value for
+    std::set<input_key> baseMissing;
+
+    //! Units of the output datums
+    std::vector<unit_types> units;
+
+    void readBaseInputs() throw ( h_exception );
+    const unitval* inputValue( const scenario* s, const input_key& key ) const;
+    void applyInputs( const scenario* s, double from, double to,
+                      std::map<input_key, const unitval*>& current ) throw ( h_exception );
+    void collectOutputs( scenario& s, const std::vector<std::string>& outputs,
+                         const std::vector<double>& dates ) throw ( h_exception );
+
+    ScenarioTree( const ScenarioTree& );
+    ScenarioTree& operator=( const ScenarioTree& );
+};
+
+}
+
+#endif // SCENARIO_TREE_H
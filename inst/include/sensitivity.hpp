@@ -0,0 +1,102 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+#ifndef SENSITIVITY_H
+#define SENSITIVITY_H
+/*
+ *  sensitivity.hpp - global sensitivity analysis over model parameters
+ *  hector
+ *
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "core_pool.hpp"
+#include "h_exception.hpp"
+#include "unitval.hpp"
+
+namespace Hector {
+
+/*! \brief Global sensitivity analysis of model outputs to parameters.
+ *
+ *  Each parameter is taken to be uniformly distributed between its bounds.
+ *  Two methods are offered:
+ *      - Sobol indices, estimated from a Saltelli design: two independent
+ *        sample matrices A and B, and for each parameter the matrix A with
+ *        that parameter's column taken from B.  First-order indices use the
+ *        Saltelli (2010) estimator and total-order indices Jansen's.
+ *        N samples cost N*(k+2) runs for k parameters.
+ *      - Morris elementary effects, from trajectories on a grid of levels
+ *        that change one parameter at a time.  Effects are in units of the
+ *        output per parameter range.  r trajectories cost r*(k+1) runs.
+ *
+ *  Samples are drawn from a seeded pseudo-random generator, so an analysis
+ *  is repeatable.  The runs are shared among threads, each with its own core
+ *  set up from the input file; cores are kept between analyses.  Only the
+ *  sums the estimators need are kept, per thread, so memory does not grow
+ *  with the number of samples.  Results are reproducible for a given number
+ *  of threads.
+ */
+class SensitivityAnalysis {
+public:
+    //! The indices an analysis computes
+    enum Index {
+        FIRST_ORDER,    //!< Sobol first-order index
+        TOTAL_ORDER,    //!< Sobol total-order index
+        MU,             //!< Morris mean elementary effect
+        MU_STAR,        //!< Morris mean absolute elementary effect
+        SIGMA           //!< Morris standard deviation of the elementary effects
+    };
+
+    SensitivityAnalysis( const std::string& inifile );
+
+    void addParameter( const std::string& datum, double lower, double upper,
+                       unit_types units ) throw ( h_exception );
+    void addOutput( const std::string& datum );
+    void setDates( const std::vector<double>& newDates ) { dates = newDates; };
+
+    void runSobol( int samples, int threads=1, unsigned long seed=0 ) throw ( h_exception );
+    void runMorris( int trajectories, int levels=4, int threads=1,
+                    unsigned long seed=0 ) throw ( h_exception );
+
+    int getRuns() const { return runs; };
+    double getIndex( Index index, size_t parameter, size_t output,
+                     size_t date ) const throw ( h_exception );
+
+private:
+    //! A parameter varied in the analysis
+    struct parameter {
+        std::string datum;
+        double lower;
+        double upper;
+        unit_types units;
+    };
+
+    std::string inifile;
+    std::vector<parameter> parameters;
+    std::vector<std::string> outputs;
+    std::vector<double> dates;
+
+    //! Cores for the worker threads
+    CorePool pool;
+
+    //! Results: for each index, [ (output * dates + date) * parameters + parameter ]
+    std::map<Index, std::vector<double> > results;
+    int runs;
+
+    size_t outputSize() const { return outputs.size() * dates.size(); };
+    void evaluate( Core* core, const double* x, double* out ) const throw ( h_exception );
+    void checkSetup() const throw ( h_exception );
+
+    SensitivityAnalysis( const SensitivityAnalysis& );
+    SensitivityAnalysis& operator=( const SensitivityAnalysis& );
+};
+
+}
+
+#endif // SENSITIVITY_H
@@ -68,6 +68,11 @@ public:
 
     virtual void shutDown();
 
+    virtual const unitval* getCurrentValuePtr( const std::string& varName ) const;
+
+    virtual tseries<unitval>* getInputSeriesPtr( const std::string& varName,
+                                                 unit_types& units );
+
     // IVisitable methods
     virtual void accept( AVisitor* visitor );
 
@@ -79,6 +84,7 @@ public:
     void record_state(double t);                        //!< record the state variables at the end of the time step
 
     void createBiome(const std::string& biome);
+    void createBiomes(const std::vector<std::string>& biomes);
     void deleteBiome(const std::string& biome);
     void renameBiome(const std::string& oldname, const std::string& newname);
 
@@ -88,8 +94,8 @@ private:
 
     // typedefs for two map types, to make things easier
     // TODO: these should probably be defined in h_util.hpp or someplace similar?
-    typedef std::map<std::string, unitval> unitval_stringmap;
-    typedef std::map<std::string, double> double_stringmap;
+    typedef arena_map<std::string, unitval> unitval_stringmap;
+    typedef arena_map<std::string, double> double_stringmap;
 
     /*****************************************************************
      * Component state
@@ -213,25 +219,28 @@ private:
 
     CarbonCycleModel *omodel;           //!< pointer to the ocean model in use
 
-    // Add a biome to a time-series map variable (e.g. veg_c_tv)
+    // Add biomes to a time-series map variable (e.g. veg_c_tv). Each
+    // time step's map is modified in place, so adding any number of
+    // biomes takes one pass over the time series.
     template <class T_data>
-    void add_biome_to_ts(tvector<std::map<std::string, T_data>>& ts,
-                         const std::string& biome,
-                         T_data init_value) {
-        // First, check if a biome of this name already exists in the data
-        if ( ts.get(ts.firstdate()).count( biome ) ) {
-            H_THROW( "Biome '" + biome + "' already exists in data." );
+    void add_biomes_to_ts(tvector<arena_map<std::string, T_data>>& ts,
+                          const std::vector<std::string>& biomes,
+                          T_data init_value) {
+        // First, check if a biome of any of these names already exists in the data
+        if ( ts.size() > 0 ) {
+            for ( size_t j = 0; j < biomes.size(); j++ ) {
+                if ( ts.get(ts.firstdate()).count( biomes[j] ) ) {
+                    H_THROW( "Biome '" + biomes[j] + "' already exists in data." );
+                }
+            }
         }
 
-        // Loop over time steps, and set the variable to the provided `init_value`
-        std::map<std::string, T_data> newval;
-        for ( double i = ts.firstdate(); i < ts.lastdate(); i++ ) {
-            if (ts.exists(i)) {
-                newval = ts.get(i);
-                newval[ biome ] = init_value;
-                ts.set(i, newval);
+        // Set the variable to the provided `init_value` at every time step
+        ts.for_each( [&]( arena_map<std::string, T_data>& currval ) {
+            for ( size_t j = 0; j < biomes.size(); j++ ) {
+                currval[ biomes[j] ] = init_value;
             }
-        }
+        } );
     }
 
     // Remove a biome from a time-series map variable
@@ -241,14 +250,9 @@ private:
         // We don't need to check for presence of `biome` here because the
         // `<std::map>.erase()` method is effectively a no-op when given a
         // non-existent key.
-        T_map currval;
-        for ( double i = ts.firstdate(); i < ts.lastdate(); i++ ) {
-            if (ts.exists(i)) {
-                currval = ts.get(i);
-                currval.erase(biome);
-                ts.set(i, currval);
-            }
-        }
+        ts.for_each( [&]( T_map& currval ) {
+            currval.erase(biome);
+        } );
     }
 
     // Rename a biome in a time-series map variable. At each time
@@ -266,15 +270,10 @@ private:
             H_THROW( "Biome '" + newname + "' already exists in data.");
         }
 
-        T_map currval;
-        for ( double i = ts.firstdate(); i < ts.lastdate(); i++ ) {
-            if (ts.exists(i)) {
-                currval = ts.get(i);
-                currval[newname] = currval.at(oldname);
-                currval.erase(oldname);
-                ts.set(i, currval);
-            }
-        }
+        ts.for_each( [&]( T_map& currval ) {
+            currval[newname] = currval.at(oldname);
+            currval.erase(oldname);
+        } );
     }
 
 
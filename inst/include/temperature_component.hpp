@@ -62,6 +62,8 @@ public:
 
     virtual void shutDown();
 
+    virtual const unitval* getCurrentValuePtr( const std::string& varName ) const;
+
     //! IVisitable methods
     virtual void accept( AVisitor* visitor );
 
@@ -70,9 +72,10 @@ private:
                             const double date ) throw ( h_exception );
     void invert_1d_2x2_matrix( double * x, double * y);
     void setoutputs(int tstep);
+    int timestepIndex( double date ) const;
 
     // Hard-coded DOECLIM parameters
-    const int dt = 1;                     // years per timestep (this is implicit in Hector)
+    int dt;                               // years per timestep (the core's time step)
     int ns;                               // number of timesteps
     const double ak = 0.31;               // slope in climate feedback - land-sea heat exchange linear relationship
     const double bk = 1.59;               // offset in climate feedback - land-sea heat exchange linear relationship, W/m2/K
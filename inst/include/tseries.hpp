@@ -15,10 +15,16 @@
  */
 
 #include <map>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+#include <iterator>
 #include <limits>
 #include <sstream>
 
 #include "logger.hpp"
+#include "h_arena.hpp"
 #include "h_interpolator.hpp"
 #include "unitval.hpp"
 #include "h_exception.hpp"
@@ -27,11 +33,25 @@ namespace Hector {
 
 /*! \brief Time series data type.
  *
- *  Currently implemented as an STL map.
+ *  Currently implemented as an STL map.  Truncating the end of the series
+ *  (as components do when the model is reset) only moves an end marker; the
+ *  truncated entries are hidden and their storage is reused when the series
+ *  is filled in again.
+ *
+ *  The map's nodes come from the arena that was current when the series was
+ *  constructed (see h_arena), or from the global heap.
+ *
+ *  The map is copy-on-write: copies of a series share it until one of them
+ *  changes.  Input data that are identical across cores (e.g. emissions read
+ *  by every member of an ensemble) can be handed to share(), which swaps the
+ *  series' map for a single process-wide copy.
  */
 template <class T_data>
 class tseries {
-    std::map<double, T_data> mapdata;
+    std::shared_ptr<arena_map<double, T_data> > mapdata;
+    arena_allocator<T_data> alloc;      // where new maps are allocated
+    bool pooled;                        // is mapdata the process-wide copy?
+    double enddate;                     // entries after this date are truncated
     double lastInterpYear;
 	bool endinterp_allowed;
     mutable bool dirty;                 // does series need re-interpolating?
@@ -39,6 +59,10 @@ class tseries {
     h_interpolator interpolator;
     void set_interp( double, bool, interpolation_methods );
     void fit_spline();
+    void reclaim( double );
+    void compact();
+    void own();
+    bool single() const;
 
 public:
     tseries();
@@ -58,6 +82,9 @@ public:
 
     void truncate(double t, bool after=true);
 
+    void share();
+    bool sharesData( const tseries<T_data>& other ) const { return mapdata == other.mapdata; }
+
     std::string name;
 };
 
@@ -78,7 +105,7 @@ template<class T_data>
 struct interp_helper {
     // TODO: we might want to consider re-organizing this to not have to pass
     // info around, discuss with Ben
-    static void error_check( const std::map<double, T_data>& userData,
+    static void error_check( const arena_map<double, T_data>& userData,
                              h_interpolator& interpolator, std::string name,
                              bool& isDirty, bool endinterp_allowed,
                              const double index ) throw( h_exception )
@@ -89,7 +116,7 @@ struct interp_helper {
             double *x = new double[ userData.size() ];   // allocate
             double *y = new double[ userData.size() ];
 
-            typename std::map<double,T_data>::const_iterator itr;    // ...and fill
+            typename arena_map<double,T_data>::const_iterator itr;    // ...and fill
             int i=0;
             for ( itr=userData.begin(); itr != userData.end(); itr++ ) {
                 x[ i ] = (*itr).first;
@@ -107,7 +134,7 @@ struct interp_helper {
         if( index < (*userData.begin()).first || index > (*userData.rbegin()).first )       // beyond-end interpolation
             H_ASSERT( endinterp_allowed, "In time series '" + name + "', end interpolation not allowed" );
     }
-    static T_data interp( const std::map<double, T_data>& userData,
+    static T_data interp( const arena_map<double, T_data>& userData,
                           h_interpolator& interpolator, std::string name,
                           bool& isDirty, bool endinterp_allowed,
                           const double index ) throw( h_exception )
@@ -116,7 +143,7 @@ struct interp_helper {
 
         return interpolator.f( index );
     }
-    static T_data calc_deriv( const std::map<double, T_data>& userData,
+    static T_data calc_deriv( const arena_map<double, T_data>& userData,
                               h_interpolator& interpolator, std::string name,
                               bool& isDirty, bool endinterp_allowed,
                               const double index ) throw( h_exception )
@@ -141,7 +168,7 @@ struct interp_helper<unitval> {
     typedef unitval T_unit_type;
     // TODO: we might want to consider re-organizing this to not have to pass
     // info around, discuss with Ben
-    static void error_check( const std::map<double, T_unit_type>& userData,
+    static void error_check( const arena_map<double, T_unit_type>& userData,
                              h_interpolator& interpolator, std::string name,
                              bool& isDirty, bool endinterp_allowed,
                              const double index ) throw( h_exception )
@@ -152,7 +179,7 @@ struct interp_helper<unitval> {
             double *x = new double[ userData.size() ];   // allocate
             double *y = new double[ userData.size() ];
 
-            std::map<double,T_unit_type>::const_iterator itr;    // ...and fill
+            arena_map<double,T_unit_type>::const_iterator itr;    // ...and fill
             int i=0;
             for ( itr=userData.begin(); itr != userData.end(); itr++ ) {
                 x[ i ] = (*itr).first;
@@ -170,7 +197,7 @@ struct interp_helper<unitval> {
         if( index < (*userData.begin()).first || index > (*userData.rbegin()).first )       // beyond-end interpolation
             H_ASSERT( endinterp_allowed, "end interpolation not allowed" );
     }
-    static T_unit_type interp( const std::map<double, T_unit_type>& userData,
+    static T_unit_type interp( const arena_map<double, T_unit_type>& userData,
                                h_interpolator& interpolator, std::string name,
                                bool& isDirty, bool endinterp_allowed,
                                const double index ) throw( h_exception )
@@ -179,7 +206,7 @@ struct interp_helper<unitval> {
 
         return unitval( interpolator.f( index ), (*(userData.begin())).second.units() );
     }
-    static T_unit_type calc_deriv( const std::map<double, T_unit_type>& userData,
+    static T_unit_type calc_deriv( const arena_map<double, T_unit_type>& userData,
                                    h_interpolator& interpolator, std::string name,
                                    bool& isDirty, bool endinterp_allowed,
                                    const double index ) throw( h_exception )
@@ -191,6 +218,53 @@ struct interp_helper<unitval> {
 };
 
 
+//-----------------------------------------------------------------------
+/*! \brief A helper class to compare series contents for sharing.
+ *
+ *  Like interp_helper, specialized for types that aren't double convertible.
+ */
+template<class T_data>
+struct share_helper {
+    static size_t hash( const arena_map<double, T_data>& userData ) {
+        size_t h = userData.size();
+        typename arena_map<double,T_data>::const_iterator itr;
+        for( itr=userData.begin(); itr != userData.end(); itr++ ) {
+            h = h * 31 + std::hash<double>()( (*itr).first );
+            h = h * 31 + std::hash<double>()( (*itr).second );
+        }
+        return h;
+    }
+    static bool equal( const arena_map<double, T_data>& a, const arena_map<double, T_data>& b ) {
+        return a == b;
+    }
+};
+
+template<>
+struct share_helper<unitval> {
+    static size_t hash( const arena_map<double, unitval>& userData ) {
+        size_t h = userData.size();
+        arena_map<double,unitval>::const_iterator itr;
+        for( itr=userData.begin(); itr != userData.end(); itr++ ) {
+            h = h * 31 + std::hash<double>()( (*itr).first );
+            h = h * 31 + std::hash<double>()( (*itr).second.value( (*itr).second.units() ) );
+            h = h * 31 + size_t( (*itr).second.units() );
+        }
+        return h;
+    }
+    static bool equal( const arena_map<double, unitval>& a, const arena_map<double, unitval>& b ) {
+        if( a.size() != b.size() )
+            return false;
+        arena_map<double,unitval>::const_iterator ia, ib;
+        for( ia=a.begin(), ib=b.begin(); ia != a.end(); ia++, ib++ ) {
+            if( (*ia).first != (*ib).first || (*ia).second.units() != (*ib).second.units() ||
+                (*ia).second.value( (*ia).second.units() ) != (*ib).second.value( (*ib).second.units() ) )
+                return false;
+        }
+        return true;
+    }
+};
+
+
 /*  "Because templates are compiled when required, this forces a restriction
     for multi-file projects: the implementation (definition) of a template
     class or function must be in the same file as its declaration. That
@@ -205,7 +279,9 @@ struct interp_helper<unitval> {
  *  Initializes internal variables.
  */
 template <class T_data>
-tseries<T_data>::tseries( ) {
+tseries<T_data>::tseries( ) : pooled( false ) {
+    mapdata = std::allocate_shared<arena_map<double, T_data> >( alloc, std::less<double>(), alloc );
+    enddate = std::numeric_limits<double>::max();
     set_interp( std::numeric_limits<double>::min(), false, DEFAULT );         // default values
     dirty = false;
     name = "?";
@@ -218,7 +294,10 @@ tseries<T_data>::tseries( ) {
  */
 template <class T_data>
 void tseries<T_data>::set( double t, T_data d ) {
-    mapdata[ t ] = d;
+    own();
+    if( t > enddate )
+        reclaim( t );
+    (*mapdata)[ t ] = d;
     if( t < lastInterpYear ) {
         dirty = true;
     }
@@ -231,7 +310,116 @@ void tseries<T_data>::set( double t, T_data d ) {
  */
 template <class T_data>
 bool tseries<T_data>::exists( double t ) const {
-    return ( mapdata.find( t ) != mapdata.end() );
+    return ( t <= enddate && mapdata->find( t ) != mapdata->end() );
+}
+
+//-----------------------------------------------------------------------
+/*! \brief Make room for a new value after the truncation point.
+ *
+ *  Truncated entries are reused in date order as the series is filled back
+ *  in.  If the new date would skip over some of them, they are discarded for
+ *  good so that they can't reappear in the middle of the new data.
+ */
+template <class T_data>
+void tseries<T_data>::reclaim( double t ) {
+    typename arena_map<double,T_data>::iterator itr = mapdata->upper_bound( enddate );
+    if( itr == mapdata->end() )
+        enddate = std::numeric_limits<double>::max();
+    else if( itr->first >= t )
+        enddate = t;
+    else {
+        mapdata->erase( itr, mapdata->end() );
+        enddate = std::numeric_limits<double>::max();
+    }
+}
+
+//-----------------------------------------------------------------------
+/*! \brief Free any truncated entries.
+ *
+ *  Needed before the whole map is handed to the interpolator.
+ */
+template <class T_data>
+void tseries<T_data>::compact() {
+    if( enddate != std::numeric_limits<double>::max() ) {
+        own();
+        mapdata->erase( mapdata->upper_bound( enddate ), mapdata->end() );
+        enddate = std::numeric_limits<double>::max();
+    }
+}
+
+//-----------------------------------------------------------------------
+/*! \brief Make sure no other series sees changes to the map.
+ *
+ *  Called before any change.  A map shared with other series is copied
+ *  first.  A map from the process-wide pool is always copied, even if this
+ *  is its only user, because share() may hand it out again at any time.
+ */
+template <class T_data>
+void tseries<T_data>::own() {
+    if( pooled || mapdata.use_count() > 1 ) {
+        mapdata = std::allocate_shared<arena_map<double, T_data> >( alloc, mapdata->begin(), mapdata->end(),
+                                                                    std::less<double>(), alloc );
+        pooled = false;
+    }
+}
+
+//-----------------------------------------------------------------------
+/*! \brief Replace the map with an identical process-wide copy.
+ *
+ *  \details Components call this once their input data are complete.  If
+ *           another series anywhere in the process already holds the same
+ *           data (typically the same input in another core), both now use
+ *           one copy, and this series' own copy is freed.  Otherwise this
+ *           series' map becomes the copy that later calls find.  Changing
+ *           the series afterward gives it a private copy again.
+ */
+template <class T_data>
+void tseries<T_data>::share() {
+    if( pooled )
+        return;
+    compact();
+
+    typedef arena_map<double, T_data> data_type;
+    static std::mutex pool_mutex;
+    static std::multimap<size_t, std::weak_ptr<data_type> > pool;
+
+    const size_t h = share_helper<T_data>::hash( *mapdata );
+    std::lock_guard<std::mutex> lock( pool_mutex );
+    typedef typename std::multimap<size_t, std::weak_ptr<data_type> >::iterator pool_iterator;
+    std::pair<pool_iterator, pool_iterator> range = pool.equal_range( h );
+    for( pool_iterator itr = range.first; itr != range.second; ) {
+        std::shared_ptr<data_type> candidate = itr->second.lock();
+        if( !candidate ) {
+            pool.erase( itr++ );        // all of its users are gone
+        } else if( share_helper<T_data>::equal( *candidate, *mapdata ) ) {
+            mapdata = candidate;
+            pooled = true;
+            return;
+        } else {
+            ++itr;
+        }
+    }
+    // The process-wide copy can outlive this series' core and be freed by
+    // whichever thread drops it last, so it can't come from the core's arena
+    // (see h_arena).  Nor can it be a map other series can change.
+    if( alloc.arena || mapdata.use_count() > 1 ) {
+        const arena_allocator<T_data> heap = arena_allocator<T_data>::heap();
+        mapdata = std::allocate_shared<data_type>( heap, mapdata->begin(), mapdata->end(),
+                                                   std::less<double>(), heap );
+    }
+    pool.insert( std::make_pair( h, std::weak_ptr<data_type>( mapdata ) ) );
+    pooled = true;
+}
+
+//-----------------------------------------------------------------------
+/*! \brief Does the series hold exactly one (untruncated) value?
+ */
+template <class T_data>
+bool tseries<T_data>::single() const {
+    if( mapdata->empty() || mapdata->begin()->first > enddate )
+        return false;
+    typename arena_map<double,T_data>::const_iterator itr = ++mapdata->begin();
+    return itr == mapdata->end() || itr->first > enddate;
 }
 
 //-----------------------------------------------------------------------
@@ -245,15 +433,17 @@ bool tseries<T_data>::exists( double t ) const {
  */
 template <class T_data>
 T_data tseries<T_data>::get( double t ) const throw( h_exception ) {
-    if(mapdata.size() == 1)
-        return mapdata.begin()->second;
-    typename std::map<double,T_data>::const_iterator itr = mapdata.find( t );
-    if( itr != mapdata.end() )
+    if(single())
+        return mapdata->begin()->second;
+    typename arena_map<double,T_data>::const_iterator itr = mapdata->find( t );
+    if( itr != mapdata->end() && t <= enddate )
         return (*itr).second;
-    else if( t < lastInterpYear )
-        return interp_helper<T_data>::interp( mapdata,
+    else if( t < lastInterpYear ) {
+        const_cast<tseries*>( this )->compact();
+        return interp_helper<T_data>::interp( *mapdata,
                                               const_cast<tseries*>( this )->interpolator,
                                               name, dirty, endinterp_allowed, t );
+    }
 	else {
             std::ostringstream errmsg;
             errmsg << "Interpolation requested but not allowed (" << name << ") date: " << t << "\n";
@@ -269,12 +459,13 @@ T_data tseries<T_data>::get( double t ) const throw( h_exception ) {
  */
 template <class T_data>
 T_data tseries<T_data>::get_deriv( double t ) const throw( h_exception ) {
-    if(mapdata.size() == 1) {
+    if(single()) {
         H_THROW( "More than one data point needed to calculate a derivative" );
     }
 
     if( t < lastInterpYear ) {
-        return interp_helper<T_data>::calc_deriv( mapdata,
+        const_cast<tseries*>( this )->compact();
+        return interp_helper<T_data>::calc_deriv( *mapdata,
                                                   const_cast<tseries*>( this )->interpolator,
                                                   name, dirty, endinterp_allowed, t );
     }
@@ -327,8 +518,8 @@ void tseries<T_data>::allowPartialInterp( bool eia ) {
  */
 template <class T_data>
 double tseries<T_data>::firstdate() const {
-    H_ASSERT( !mapdata.empty(), "no mapdata" );
-    return (*mapdata.begin()).first;
+    H_ASSERT( !mapdata->empty() && mapdata->begin()->first <= enddate, "no mapdata" );
+    return (*mapdata->begin()).first;
 }
 
 //-----------------------------------------------------------------------
@@ -338,8 +529,10 @@ double tseries<T_data>::firstdate() const {
  */
 template <class T_data>
 double tseries<T_data>::lastdate() const {
-    H_ASSERT( !mapdata.empty(), "no mapdata" );
-    return (*mapdata.rbegin()).first;
+    H_ASSERT( !mapdata->empty() && mapdata->begin()->first <= enddate, "no mapdata" );
+    if( enddate == std::numeric_limits<double>::max() )
+        return (*mapdata->rbegin()).first;
+    return (*--mapdata->upper_bound( enddate )).first;
 }
 
 //-----------------------------------------------------------------------
@@ -349,7 +542,9 @@ double tseries<T_data>::lastdate() const {
  */
 template <class T_data>
 int tseries<T_data>::size() const {
-    return int( mapdata.size() );
+    if( enddate == std::numeric_limits<double>::max() )
+        return int( mapdata->size() );
+    return int( std::distance( mapdata->begin(), mapdata->upper_bound( enddate ) ) );
 }
 
 /*! \brief truncate a time series
@@ -357,7 +552,9 @@ int tseries<T_data>::size() const {
  *  \details The default is to wipe all of the data in the time series
  *           after the input date.  By setting the optional after
  *           argument to false, you can wipe data before the input
- *           date instead.
+ *           date instead.  Truncating after a date takes constant time:
+ *           the data are only hidden, and their storage is reused as the
+ *           series is filled in again.
  *  \note If you're going to overwrite previously read-in data, and
  *        you're not supplying input at every year, then you need to
  *        trigger this function (probably by sending a M_TRUNCATE
@@ -379,16 +576,13 @@ int tseries<T_data>::size() const {
 template <class T>
 void tseries<T>::truncate(double t, bool after)
 {
-    typename std::map<double, T>::iterator it1, it2;
     if(after) {
-        it1 = mapdata.upper_bound(t);
-        it2 = mapdata.end();
+        enddate = std::min(enddate, t);
     }
     else {
-        it1 = mapdata.begin();
-        it2 = mapdata.lower_bound(t);
+        own();
+        mapdata->erase(mapdata->begin(), mapdata->lower_bound(t));
     }
-    mapdata.erase(it1,it2);
 }
 
 }
@@ -27,24 +27,31 @@
  */
 
 #include <map>
+#include <algorithm>
+#include <iterator>
 #include <limits>
 #include <string>
 #include <cmath>
 #include <sstream>
 
 #include "logger.hpp"
+#include "h_arena.hpp"
 #include "h_exception.hpp"
 
 namespace Hector {
 
 /*! \brief Time vector data type.
  *
- *  Currently implemented as an STL map.
+ *  Currently implemented as an STL map.  As with `tseries`, truncating the
+ *  end of the vector only hides the entries, and they are reused (assigned
+ *  in place) when the vector is filled in again.
  */
 template <class T_data>
 class tvector {
-    std::map<double, T_data> mapdata;
+    arena_map<double, T_data> mapdata;
+    double enddate;             // entries after this date are truncated
 public:
+    tvector() : enddate( std::numeric_limits<double>::max() ) {}
 
     void set(double, const T_data &);
     const T_data &get(double) const throw( h_exception );
@@ -66,8 +73,13 @@ public:
 
     int size() const;
 
+    template <class T_func>
+    void for_each(T_func f);
+
     void truncate(double t, bool after=true);
 private:
+    void reclaim(double t);
+
     static double round(double t) {
         // round time values to prevent minute differences in
         // representation from resulting in a misidentificaiton.
@@ -85,7 +97,28 @@ private:
  */
 template <class T_data>
 void tvector<T_data>::set(double t, const T_data &d) {
-    mapdata[round(t)] = d;
+    t = round(t);
+    if( t > enddate )
+        reclaim( t );
+    mapdata[t] = d;
+}
+
+//-----------------------------------------------------------------------
+/*! \brief Make room for a new value after the truncation point.
+ *
+ *  See tseries::reclaim.
+ */
+template <class T_data>
+void tvector<T_data>::reclaim(double t) {
+    typename arena_map<double,T_data>::iterator itr = mapdata.upper_bound( enddate );
+    if( itr == mapdata.end() )
+        enddate = std::numeric_limits<double>::max();
+    else if( itr->first >= t )
+        enddate = t;
+    else {
+        mapdata.erase( itr, mapdata.end() );
+        enddate = std::numeric_limits<double>::max();
+    }
 }
 
 //-----------------------------------------------------------------------
@@ -95,7 +128,8 @@ void tvector<T_data>::set(double t, const T_data &d) {
  */
 template <class T_data>
 bool tvector<T_data>::exists( double t ) const {
-    return ( mapdata.find( round(t) ) != mapdata.end() );
+    t = round(t);
+    return ( t <= enddate && mapdata.find( t ) != mapdata.end() );
 }
 
 //-----------------------------------------------------------------------
@@ -106,8 +140,8 @@ bool tvector<T_data>::exists( double t ) const {
  */
 template <class T_data>
 const T_data &tvector<T_data>::get( double t ) const throw( h_exception ) {
-    typename std::map<double,T_data>::const_iterator itr = mapdata.find( round(t) );
-    if( itr != mapdata.end() )
+    typename arena_map<double,T_data>::const_iterator itr = mapdata.find( round(t) );
+    if( itr != mapdata.end() && itr->first <= enddate )
         return (*itr).second;
     else {
         std::ostringstream errmsg;
@@ -123,8 +157,8 @@ const T_data &tvector<T_data>::get( double t ) const throw( h_exception ) {
  */
 template <class T_data>
 T_data &tvector<T_data>::get( double t ) throw( h_exception ) {
-    typename std::map<double,T_data>::iterator itr = mapdata.find( round(t) );
-    if( itr != mapdata.end() )
+    typename arena_map<double,T_data>::iterator itr = mapdata.find( round(t) );
+    if( itr != mapdata.end() && itr->first <= enddate )
         return itr->second;
     else {
         std::ostringstream errmsg;
@@ -154,7 +188,7 @@ T_data &tvector<T_data>::operator[](double t) {
  */
 template <class T_data>
 double tvector<T_data>::firstdate() const {
-    H_ASSERT( !mapdata.empty(), "no mapdata" );
+    H_ASSERT( !mapdata.empty() && mapdata.begin()->first <= enddate, "no mapdata" );
     return (*mapdata.begin()).first;
 }
 
@@ -165,8 +199,10 @@ double tvector<T_data>::firstdate() const {
  */
 template <class T_data>
 double tvector<T_data>::lastdate() const {
-    H_ASSERT( !mapdata.empty(), "no mapdata" );
-    return (*mapdata.rbegin()).first;
+    H_ASSERT( !mapdata.empty() && mapdata.begin()->first <= enddate, "no mapdata" );
+    if( enddate == std::numeric_limits<double>::max() )
+        return (*mapdata.rbegin()).first;
+    return (*--mapdata.upper_bound( enddate )).first;
 }
 
 //-----------------------------------------------------------------------
@@ -176,7 +212,22 @@ double tvector<T_data>::lastdate() const {
  */
 template <class T_data>
 int tvector<T_data>::size() const {
-    return int( mapdata.size() );
+    if( enddate == std::numeric_limits<double>::max() )
+        return int( mapdata.size() );
+    return int( std::distance( mapdata.begin(), mapdata.upper_bound( enddate ) ) );
+}
+
+/*! \brief Apply a function to every value, in date order
+ *
+ *  \details The function is called with a reference to each value that
+ *           hasn't been truncated, so it can modify it in place.
+ */
+template <class T_data>
+template <class T_func>
+void tvector<T_data>::for_each(T_func f) {
+    typename arena_map<double,T_data>::iterator end = mapdata.upper_bound( enddate );
+    for( typename arena_map<double,T_data>::iterator itr = mapdata.begin(); itr != end; ++itr )
+        f( itr->second );
 }
 
 /*! \brief truncate a time vector
@@ -184,22 +235,19 @@ int tvector<T_data>::size() const {
  *  \details The default is to wipe all of the data in the time vector
  *           after the input date.  By setting the optional after
  *           argument to false, you can wipe data before the input
- *           date instead.
+ *           date instead.  Truncating after a date takes constant
+ *           time (see the class notes).
  */
 template <class T>
 void tvector<T>::truncate(double t, bool after)
 {
     t = round(t);
-    typename std::map<double, T>::iterator it1, it2;
     if(after) {
-        it1 = mapdata.upper_bound(t);
-        it2 = mapdata.end();
+        enddate = std::min(enddate, t);
     }
     else {
-        it1 = mapdata.begin();
-        it2 = mapdata.lower_bound(t);
+        mapdata.erase(mapdata.begin(), mapdata.lower_bound(t));
     }
-    mapdata.erase(it1,it2);
 }
 
 }
@@ -46,7 +46,7 @@ int main (int argc, char * const argv[]) {
     try {
 
         // Create the global log
-        Logger& glog = Logger::getGlobalLogger();
+        Logger glog;
         glog.open( string( MODEL_NAME ), true, true, Logger::DEBUG );
         H_LOG( glog, Logger::NOTICE ) << MODEL_NAME << " wrapper start" << endl;
 
@@ -143,7 +143,34 @@ int main (int argc, char * const argv[]) {
                 << "\tca old= " << cats.get(newt) << "\tca new= " << ca << "\tdiff= " << ca-cats.get(newt) << "\n"
                 << "\tforc old= " << forcts.get(newt) << "\tforc new= " << forc << "\tdiff= " << forc-forcts.get(newt) << "\n";
         }
-        
+
+        // Tightly coupled drivers can skip the string-based messages
+        // entirely: register arrays for the inputs and outputs once,
+        // and the core will exchange data with them on every step.
+        // Here we rerun with fossil emissions cut in half after 2020.
+        core.reset(0);
+        double tstart = core.getStartDate() + 1.0;
+        size_t nyear = size_t(core.getEndDate() - core.getStartDate());
+        vector<double> ffi(nyear), temp_out(nyear), ca_out(nyear);
+        for(size_t i=0; i<nyear; ++i) {
+            double t = tstart + i;
+            ffi[i] = core.sendMessage(M_GETDATA, D_FFI_EMISSIONS, message_data(t)).value(U_PGC_YR);
+            if(t > 2020.0)
+                ffi[i] *= 0.5;
+        }
+        core.registerInputBuffer(D_FFI_EMISSIONS, &ffi[0], nyear, tstart, U_PGC_YR);
+        core.registerOutputBuffer(D_GLOBAL_TEMP, &temp_out[0], nyear, tstart, U_DEGC);
+        core.registerOutputBuffer(D_ATMOSPHERIC_CO2, &ca_out[0], nyear, tstart, U_PPMV_CO2);
+        while(core.getCurrentDate() < core.getEndDate()) {
+            core.step();
+        }
+        for(double t = core.getStartDate()+5.0; t<=core.getEndDate(); t+=5.0) {
+            size_t i = size_t(t - tstart);
+            H_LOG(glog, Logger::NOTICE)
+                << "t= " << t << "\tffi= " << ffi[i] << "\ttemp= " << temp_out[i]
+                << "\tCO2= " << ca_out[i] << "\n";
+        }
+        core.clearCouplingBuffers();
 
         H_LOG(glog, Logger::NOTICE) << "Shutting down all components.\n";
         core.shutDown();
@@ -196,7 +223,7 @@ void read_and_set_co2(double tstrt, double tend, Core &core, istream &sim_gcam_e
                              message_data(t, unitval(oc, U_TG)));
             core.sendMessage(M_SETDATA, D_EMISSIONS_CF4,
                              message_data(t, unitval(cf4, U_GG)));
-            core.sendMessage(M_SETDATA, D_EMISSIONS_HCF22,
+            core.sendMessage(M_SETDATA, D_EMISSIONS_HCFC22,
                              message_data(t, unitval(hcf22, U_GG)));
 
             std::cout << "t= " << t << "\n"
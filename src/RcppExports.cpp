@@ -1796,8 +1796,8 @@ BEGIN_RCPP
 END_RCPP
 }
 // newcore_impl
-Environment newcore_impl(String inifile, int loglevel, bool suppresslogging, String name);
-RcppExport SEXP _hector_newcore_impl(SEXP inifileSEXP, SEXP loglevelSEXP, SEXP suppressloggingSEXP, SEXP nameSEXP) {
+Environment newcore_impl(String inifile, int loglevel, bool suppresslogging, String name, std::vector<std::string> targets, bool arena);
+RcppExport SEXP _hector_newcore_impl(SEXP inifileSEXP, SEXP loglevelSEXP, SEXP suppressloggingSEXP, SEXP nameSEXP, SEXP targetsSEXP, SEXP arenaSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -1805,7 +1805,9 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type loglevel(loglevelSEXP);
     Rcpp::traits::input_parameter< bool >::type suppresslogging(suppressloggingSEXP);
     Rcpp::traits::input_parameter< String >::type name(nameSEXP);
-    rcpp_result_gen = Rcpp::wrap(newcore_impl(inifile, loglevel, suppresslogging, name));
+    Rcpp::traits::input_parameter< std::vector<std::string> >::type targets(targetsSEXP);
+    Rcpp::traits::input_parameter< bool >::type arena(arenaSEXP);
+    rcpp_result_gen = Rcpp::wrap(newcore_impl(inifile, loglevel, suppresslogging, name, targets, arena));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -1833,14 +1835,42 @@ BEGIN_RCPP
 END_RCPP
 }
 // run
-Environment run(Environment core, double runtodate);
-RcppExport SEXP _hector_run(SEXP coreSEXP, SEXP runtodateSEXP) {
+Environment run(Environment core, double runtodate, Nullable<NumericVector> stop_above, Nullable<NumericVector> stop_below, Nullable<Function> stop_fun);
+RcppExport SEXP _hector_run(SEXP coreSEXP, SEXP runtodateSEXP, SEXP stop_aboveSEXP, SEXP stop_belowSEXP, SEXP stop_funSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< Environment >::type core(coreSEXP);
     Rcpp::traits::input_parameter< double >::type runtodate(runtodateSEXP);
-    rcpp_result_gen = Rcpp::wrap(run(core, runtodate));
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type stop_above(stop_aboveSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type stop_below(stop_belowSEXP);
+    Rcpp::traits::input_parameter< Nullable<Function> >::type stop_fun(stop_funSEXP);
+    rcpp_result_gen = Rcpp::wrap(run(core, runtodate, stop_above, stop_below, stop_fun));
+    return rcpp_result_gen;
+END_RCPP
+}
+// setbudget
+Environment setbudget(Environment core, double seconds, double evaluations);
+RcppExport SEXP _hector_setbudget(SEXP coreSEXP, SEXP secondsSEXP, SEXP evaluationsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Environment >::type core(coreSEXP);
+    Rcpp::traits::input_parameter< double >::type seconds(secondsSEXP);
+    Rcpp::traits::input_parameter< double >::type evaluations(evaluationsSEXP);
+    rcpp_result_gen = Rcpp::wrap(setbudget(core, seconds, evaluations));
+    return rcpp_result_gen;
+END_RCPP
+}
+// cancelrun
+Environment cancelrun(Environment core, bool cancel);
+RcppExport SEXP _hector_cancelrun(SEXP coreSEXP, SEXP cancelSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Environment >::type core(coreSEXP);
+    Rcpp::traits::input_parameter< bool >::type cancel(cancelSEXP);
+    rcpp_result_gen = Rcpp::wrap(cancelrun(core, cancel));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -1855,6 +1885,45 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// subscribe
+int subscribe(Environment core, std::vector<std::string> vars, double start, double end, int stride);
+RcppExport SEXP _hector_subscribe(SEXP coreSEXP, SEXP varsSEXP, SEXP startSEXP, SEXP endSEXP, SEXP strideSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Environment >::type core(coreSEXP);
+    Rcpp::traits::input_parameter< std::vector<std::string> >::type vars(varsSEXP);
+    Rcpp::traits::input_parameter< double >::type start(startSEXP);
+    Rcpp::traits::input_parameter< double >::type end(endSEXP);
+    Rcpp::traits::input_parameter< int >::type stride(strideSEXP);
+    rcpp_result_gen = Rcpp::wrap(subscribe(core, vars, start, end, stride));
+    return rcpp_result_gen;
+END_RCPP
+}
+// unsubscribe
+Environment unsubscribe(Environment core, int id);
+RcppExport SEXP _hector_unsubscribe(SEXP coreSEXP, SEXP idSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Environment >::type core(coreSEXP);
+    Rcpp::traits::input_parameter< int >::type id(idSEXP);
+    rcpp_result_gen = Rcpp::wrap(unsubscribe(core, id));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fetchsubscription_impl
+DataFrame fetchsubscription_impl(Environment core, int id);
+RcppExport SEXP _hector_fetchsubscription_impl(SEXP coreSEXP, SEXP idSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Environment >::type core(coreSEXP);
+    Rcpp::traits::input_parameter< int >::type id(idSEXP);
+    rcpp_result_gen = Rcpp::wrap(fetchsubscription_impl(core, id));
+    return rcpp_result_gen;
+END_RCPP
+}
 // get_biome_list
 std::vector<std::string> get_biome_list(Environment core);
 RcppExport SEXP _hector_get_biome_list(SEXP coreSEXP) {
@@ -1878,6 +1947,18 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// create_biomes_impl
+Environment create_biomes_impl(Environment core, std::vector<std::string> biomes);
+RcppExport SEXP _hector_create_biomes_impl(SEXP coreSEXP, SEXP biomesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Environment >::type core(coreSEXP);
+    Rcpp::traits::input_parameter< std::vector<std::string> >::type biomes(biomesSEXP);
+    rcpp_result_gen = Rcpp::wrap(create_biomes_impl(core, biomes));
+    return rcpp_result_gen;
+END_RCPP
+}
 // delete_biome_impl
 Environment delete_biome_impl(Environment core, std::string biome);
 RcppExport SEXP _hector_delete_biome_impl(SEXP coreSEXP, SEXP biomeSEXP) {
@@ -1919,6 +2000,92 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// runscenarios_impl
+DataFrame runscenarios_impl(Environment core, List scenarios, std::vector<std::string> vars, NumericVector dates, double runtodate);
+RcppExport SEXP _hector_runscenarios_impl(SEXP coreSEXP, SEXP scenariosSEXP, SEXP varsSEXP, SEXP datesSEXP, SEXP runtodateSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Environment >::type core(coreSEXP);
+    Rcpp::traits::input_parameter< List >::type scenarios(scenariosSEXP);
+    Rcpp::traits::input_parameter< std::vector<std::string> >::type vars(varsSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type dates(datesSEXP);
+    Rcpp::traits::input_parameter< double >::type runtodate(runtodateSEXP);
+    rcpp_result_gen = Rcpp::wrap(runscenarios_impl(core, scenarios, vars, dates, runtodate));
+    return rcpp_result_gen;
+END_RCPP
+}
+// runcoupled_impl
+DataFrame runcoupled_impl(Environment core, DataFrame inputs, std::vector<std::string> vars, double runtodate);
+RcppExport SEXP _hector_runcoupled_impl(SEXP coreSEXP, SEXP inputsSEXP, SEXP varsSEXP, SEXP runtodateSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Environment >::type core(coreSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type inputs(inputsSEXP);
+    Rcpp::traits::input_parameter< std::vector<std::string> >::type vars(varsSEXP);
+    Rcpp::traits::input_parameter< double >::type runtodate(runtodateSEXP);
+    rcpp_result_gen = Rcpp::wrap(runcoupled_impl(core, inputs, vars, runtodate));
+    return rcpp_result_gen;
+END_RCPP
+}
+// calibrate_impl
+List calibrate_impl(Environment core, DataFrame parameters, DataFrame targets, NumericVector weights, int maxeval, double tol);
+RcppExport SEXP _hector_calibrate_impl(SEXP coreSEXP, SEXP parametersSEXP, SEXP targetsSEXP, SEXP weightsSEXP, SEXP maxevalSEXP, SEXP tolSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Environment >::type core(coreSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type parameters(parametersSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type targets(targetsSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type weights(weightsSEXP);
+    Rcpp::traits::input_parameter< int >::type maxeval(maxevalSEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    rcpp_result_gen = Rcpp::wrap(calibrate_impl(core, parameters, targets, weights, maxeval, tol));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sensitivity_impl
+DataFrame sensitivity_impl(String inifile, DataFrame parameters, std::vector<std::string> vars, NumericVector dates, String method, int n, int levels, int threads, double seed);
+RcppExport SEXP _hector_sensitivity_impl(SEXP inifileSEXP, SEXP parametersSEXP, SEXP varsSEXP, SEXP datesSEXP, SEXP methodSEXP, SEXP nSEXP, SEXP levelsSEXP, SEXP threadsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< String >::type inifile(inifileSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type parameters(parametersSEXP);
+    Rcpp::traits::input_parameter< std::vector<std::string> >::type vars(varsSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type dates(datesSEXP);
+    Rcpp::traits::input_parameter< String >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< int >::type levels(levelsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< double >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(sensitivity_impl(inifile, parameters, vars, dates, method, n, levels, threads, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// runensemble_impl
+DataFrame runensemble_impl(String inifile, DataFrame members, CharacterVector units, std::vector<std::string> vars, NumericVector dates, NumericVector probs, List thresholds, int threads, double compression, String journal, String output, int chunksize);
+RcppExport SEXP _hector_runensemble_impl(SEXP inifileSEXP, SEXP membersSEXP, SEXP unitsSEXP, SEXP varsSEXP, SEXP datesSEXP, SEXP probsSEXP, SEXP thresholdsSEXP, SEXP threadsSEXP, SEXP compressionSEXP, SEXP journalSEXP, SEXP outputSEXP, SEXP chunksizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< String >::type inifile(inifileSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type members(membersSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type units(unitsSEXP);
+    Rcpp::traits::input_parameter< std::vector<std::string> >::type vars(varsSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type dates(datesSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type probs(probsSEXP);
+    Rcpp::traits::input_parameter< List >::type thresholds(thresholdsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< double >::type compression(compressionSEXP);
+    Rcpp::traits::input_parameter< String >::type journal(journalSEXP);
+    Rcpp::traits::input_parameter< String >::type output(outputSEXP);
+    Rcpp::traits::input_parameter< int >::type chunksize(chunksizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(runensemble_impl(inifile, members, units, vars, dates, probs, thresholds, threads, compression, journal, output, chunksize));
+    return rcpp_result_gen;
+END_RCPP
+}
 // chk_core_valid
 bool chk_core_valid(Environment core);
 RcppExport SEXP _hector_chk_core_valid(SEXP coreSEXP) {
@@ -1930,6 +2097,19 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// shares_input
+bool shares_input(Environment core, Environment other, String var);
+RcppExport SEXP _hector_shares_input(SEXP coreSEXP, SEXP otherSEXP, SEXP varSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Environment >::type core(coreSEXP);
+    Rcpp::traits::input_parameter< Environment >::type other(otherSEXP);
+    Rcpp::traits::input_parameter< String >::type var(varSEXP);
+    rcpp_result_gen = Rcpp::wrap(shares_input(core, other, var));
+    return rcpp_result_gen;
+END_RCPP
+}
 
 static const R_CallMethodDef CallEntries[] = {
     {"_hector_GETDATA", (DL_FUNC) &_hector_GETDATA, 0},
@@ -2110,17 +2290,29 @@ static const R_CallMethodDef CallEntries[] = {
     {"_hector_FLUX_INTERIOR", (DL_FUNC) &_hector_FLUX_INTERIOR, 0},
     {"_hector_HEAT_FLUX", (DL_FUNC) &_hector_HEAT_FLUX, 0},
     {"_hector_BIOME_SPLIT_CHAR", (DL_FUNC) &_hector_BIOME_SPLIT_CHAR, 0},
-    {"_hector_newcore_impl", (DL_FUNC) &_hector_newcore_impl, 4},
+    {"_hector_newcore_impl", (DL_FUNC) &_hector_newcore_impl, 6},
     {"_hector_shutdown", (DL_FUNC) &_hector_shutdown, 1},
     {"_hector_reset", (DL_FUNC) &_hector_reset, 2},
-    {"_hector_run", (DL_FUNC) &_hector_run, 2},
+    {"_hector_run", (DL_FUNC) &_hector_run, 5},
+    {"_hector_setbudget", (DL_FUNC) &_hector_setbudget, 3},
+    {"_hector_cancelrun", (DL_FUNC) &_hector_cancelrun, 2},
     {"_hector_getdate", (DL_FUNC) &_hector_getdate, 1},
+    {"_hector_subscribe", (DL_FUNC) &_hector_subscribe, 5},
+    {"_hector_unsubscribe", (DL_FUNC) &_hector_unsubscribe, 2},
+    {"_hector_fetchsubscription_impl", (DL_FUNC) &_hector_fetchsubscription_impl, 2},
     {"_hector_get_biome_list", (DL_FUNC) &_hector_get_biome_list, 1},
     {"_hector_create_biome_impl", (DL_FUNC) &_hector_create_biome_impl, 2},
+    {"_hector_create_biomes_impl", (DL_FUNC) &_hector_create_biomes_impl, 2},
     {"_hector_delete_biome_impl", (DL_FUNC) &_hector_delete_biome_impl, 2},
     {"_hector_rename_biome", (DL_FUNC) &_hector_rename_biome, 3},
     {"_hector_sendmessage", (DL_FUNC) &_hector_sendmessage, 6},
+    {"_hector_runscenarios_impl", (DL_FUNC) &_hector_runscenarios_impl, 5},
+    {"_hector_runcoupled_impl", (DL_FUNC) &_hector_runcoupled_impl, 4},
+    {"_hector_calibrate_impl", (DL_FUNC) &_hector_calibrate_impl, 6},
+    {"_hector_sensitivity_impl", (DL_FUNC) &_hector_sensitivity_impl, 9},
+    {"_hector_runensemble_impl", (DL_FUNC) &_hector_runensemble_impl, 12},
     {"_hector_chk_core_valid", (DL_FUNC) &_hector_chk_core_valid, 1},
+    {"_hector_shares_input", (DL_FUNC) &_hector_shares_input, 3},
     {NULL, NULL, 0}
 };
 
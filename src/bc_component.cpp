@@ -46,7 +46,7 @@ string BlackCarbonComponent::getComponentName() const {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void BlackCarbonComponent::init( Core* coreptr ) {
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
     core = coreptr;
 
@@ -103,15 +103,28 @@ void BlackCarbonComponent::prepareToRun() throw ( h_exception ) {
 
     H_LOG( logger, Logger::DEBUG ) << "prepareToRun " << std::endl;
     oldDate = core->getStartDate();
+
+    BC_emissions.share();
 }
 
 //------------------------------------------------------------------------------
 // documentation is inherited
 void BlackCarbonComponent::run( const double runToDate ) throw ( h_exception ) {
-    H_ASSERT( !core->inSpinup() && runToDate-oldDate == 1, "timestep must equal 1" );
+    H_ASSERT( !core->inSpinup() && runToDate-oldDate <= core->getTimeStep(), "timestep must not exceed the core timestep" );
     oldDate = runToDate;
 }
 
+//------------------------------------------------------------------------------
+// documentation is inherited
+tseries<unitval>* BlackCarbonComponent::getInputSeriesPtr( const std::string& varName,
+                                                           unit_types& units ) {
+    if( varName == D_EMISSIONS_BC ) {
+        units = U_TG;
+        return &BC_emissions;
+    }
+    return NULL;
+}
+
 //------------------------------------------------------------------------------
 // documentation is inherited
 unitval BlackCarbonComponent::getData( const std::string& varName,
@@ -0,0 +1,287 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+/*
+ *  calibrator.cpp
+ *  hector
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "calibrator.hpp"
+#include "component_data.hpp"
+#include "csv_table_reader.hpp"
+#include "message_data.hpp"
+
+namespace Hector {
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/*! \brief Constructor
+ *  \param core The core to calibrate.  It must have been prepared to run.
+ */
+Calibrator::Calibrator( Core* core )
+: core( core ), maxEvaluations( 500 ), tolerance( 1e-4 ), evaluations( 0 ),
+  hasConverged( false )
+{
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add a parameter to fit
+ *
+ *  \details The search starts from the parameter's current value in the core,
+ *           moved inside the bounds if need be.
+ *  \param datum The parameter name (e.g. D_ECS).
+ *  \param lower Lower bound.
+ *  \param upper Upper bound.
+ *  \param units Units of the bounds.
+ *  \exception h_exception If the bounds are empty or the core has no such
+ *              parameter.
+ */
+void Calibrator::addParameter( const string& datum, double lower, double upper,
+                               unit_types units ) throw ( h_exception )
+{
+    H_ASSERT( lower < upper, "lower bound of " + datum + " must be below the upper bound" );
+    const unitval current = core->sendMessage( M_GETDATA, datum );
+
+    parameter p;
+    p.datum = datum;
+    p.lower = lower;
+    p.upper = upper;
+    p.units = units;
+    parameters.push_back( p );
+    best.push_back( min( upper, max( lower, current.value( units ) ) ) );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add an observed series to fit
+ *  \param datum The model output it is compared to (e.g. D_GLOBAL_TEMP).
+ *  \param dates Dates of the observations.
+ *  \param values The observations.  Observations with undefined units are
+ *         taken to be in the model's units.
+ *  \param weight Weight of the series' mean squared error in the objective.
+ *  \exception h_exception If the series is empty or outside of the model run.
+ */
+void Calibrator::addTarget( const string& datum, const vector<double>& dates,
+                            const vector<unitval>& values, double weight ) throw ( h_exception )
+{
+    H_ASSERT( !dates.empty() && dates.size() == values.size(),
+              "target " + datum + " needs one value per date" );
+    H_ASSERT( weight >= 0.0, "target weights must not be negative" );
+    for( size_t i = 0; i < dates.size(); ++i ) {
+        H_ASSERT( dates[ i ] >= core->getStartDate() && dates[ i ] <= core->getEndDate(),
+                  "target " + datum + " has dates outside of the model run" );
+    }
+
+    target t;
+    t.datum = datum;
+    t.dates = dates;
+    t.values = values;
+    t.weight = weight;
+    targets.push_back( t );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add an observed series read from a CSV table
+ *  \param datum The model output it is compared to (e.g. D_GLOBAL_TEMP).
+ *  \param fileName The table, laid out as CSVTableReader expects.
+ *  \param column The column holding the observations.
+ *  \param weight Weight of the series' mean squared error in the objective.
+ *  \exception h_exception If the table can't be read, or see the other
+ *              addTarget().
+ */
+void Calibrator::addTarget( const string& datum, const string& fileName,
+                            const string& column, double weight ) throw ( h_exception )
+{
+    vector<double> dates;
+    vector<unitval> values;
+    CSVTableReader( fileName ).readSeries( column, dates, values );
+    addTarget( datum, dates, values, weight );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief The date the model must be run to for the objective
+ */
+double Calibrator::lastTargetDate() const
+{
+    double end = core->getStartDate();
+    for( vector<target>::const_iterator t = targets.begin(); t != targets.end(); ++t )
+        end = max( end, *max_element( t->dates.begin(), t->dates.end() ) );
+    return end;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Evaluate the objective at a set of parameter values
+ *
+ *  \details The parameters are set in the core, which is then run as far as
+ *           the last target date.  The core keeps the parameter values.
+ *  \param values One value per parameter, in the order they were added and
+ *         in the units given there.
+ *  \return Sum over targets of weight times mean squared error.
+ *  \exception h_exception If the run fails or an observation's units don't
+ *              match the model's.
+ */
+double Calibrator::objective( const vector<double>& values ) throw ( h_exception )
+{
+    H_ASSERT( values.size() == parameters.size(), "need one value per parameter" );
+    H_ASSERT( !targets.empty(), "no targets to calibrate to" );
+
+    for( size_t i = 0; i < parameters.size(); ++i ) {
+        core->sendMessage( M_SETDATA, parameters[ i ].datum,
+                           message_data( unitval( values[ i ], parameters[ i ].units ) ) );
+    }
+    if( core->changesPending() )
+        core->applyChanges();
+    const double end = lastTargetDate();
+    if( core->getCurrentDate() < end )
+        core->run( end );
+    ++evaluations;
+
+    double sum = 0.0;
+    for( vector<target>::const_iterator t = targets.begin(); t != targets.end(); ++t ) {
+        double sse = 0.0;
+        for( size_t i = 0; i < t->dates.size(); ++i ) {
+            const unitval model = core->sendMessage( M_GETDATA, t->datum, message_data( t->dates[ i ] ) );
+            const unitval& obs = t->values[ i ];
+            const unit_types units = obs.units() == U_UNDEFINED ? model.units() : obs.units();
+            const double diff = model.value( units ) - obs.value( obs.units() );
+            sse += diff * diff;
+        }
+        sum += t->weight * sse / t->dates.size();
+    }
+    return sum;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Map a point in the unit cube to parameter values
+ */
+vector<double> Calibrator::unscale( const vector<double>& x ) const
+{
+    vector<double> values( x.size() );
+    for( size_t i = 0; i < x.size(); ++i )
+        values[ i ] = parameters[ i ].lower + x[ i ] * ( parameters[ i ].upper - parameters[ i ].lower );
+    return values;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief The objective at a point in the unit cube, which is first projected
+ *         onto the cube
+ */
+double Calibrator::scaledObjective( vector<double>& x ) throw ( h_exception )
+{
+    for( size_t i = 0; i < x.size(); ++i )
+        x[ i ] = min( 1.0, max( 0.0, x[ i ] ) );
+    return objective( unscale( x ) );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Fit the parameters to the targets
+ *
+ *  \details Stops when the objective values and the points of the simplex
+ *           both agree to within the tolerance (the points in units of the
+ *           parameters' ranges), or after the maximum number of evaluations.
+ *  \return The objective at the best parameter values, which the core is left
+ *          set to and run with.
+ *  \exception h_exception If a run fails.
+ *  \sa getBestValues, converged
+ */
+double Calibrator::calibrate() throw ( h_exception )
+{
+    H_ASSERT( !parameters.empty(), "no parameters to calibrate" );
+    const size_t n = parameters.size();
+    evaluations = 0;
+    hasConverged = false;
+
+    // Starting simplex: the start point and a step along each axis
+    vector<vector<double> > simplex( n + 1, vector<double>( n ) );
+    for( size_t i = 0; i < n; ++i )
+        simplex[ 0 ][ i ] = ( best[ i ] - parameters[ i ].lower ) / ( parameters[ i ].upper - parameters[ i ].lower );
+    for( size_t j = 1; j <= n; ++j ) {
+        simplex[ j ] = simplex[ 0 ];
+        simplex[ j ][ j - 1 ] += simplex[ 0 ][ j - 1 ] > 0.9 ? -0.1 : 0.1;
+    }
+    vector<double> f( n + 1 );
+    for( size_t j = 0; j <= n; ++j )
+        f[ j ] = scaledObjective( simplex[ j ] );
+
+    vector<size_t> order( n + 1 );
+    while( true ) {
+        for( size_t j = 0; j <= n; ++j )
+            order[ j ] = j;
+        sort( order.begin(), order.end(), [&f]( size_t a, size_t b ) { return f[ a ] < f[ b ]; } );
+        const size_t lo = order[ 0 ], hi = order[ n ], next = order[ n - 1 ];
+
+        double size = 0.0;
+        for( size_t j = 0; j <= n; ++j )
+            for( size_t i = 0; i < n; ++i )
+                size = max( size, fabs( simplex[ j ][ i ] - simplex[ lo ][ i ] ) );
+        if( f[ hi ] - f[ lo ] <= tolerance * max( 1.0, fabs( f[ lo ] ) ) && size <= tolerance ) {
+            hasConverged = true;
+            break;
+        }
+        if( evaluations >= maxEvaluations )
+            break;
+
+        vector<double> centroid( n, 0.0 );
+        for( size_t j = 0; j <= n; ++j ) {
+            if( j == hi )
+                continue;
+            for( size_t i = 0; i < n; ++i )
+                centroid[ i ] += simplex[ j ][ i ] / n;
+        }
+        // The point at distance t along the line from the centroid away
+        // from the worst point
+        vector<double> trial( n );
+        const auto along = [&]( double t ) {
+            for( size_t i = 0; i < n; ++i )
+                trial[ i ] = centroid[ i ] + t * ( centroid[ i ] - simplex[ hi ][ i ] );
+            return scaledObjective( trial );
+        };
+
+        const double fr = along( 1.0 );
+        const vector<double> reflected = trial;
+        if( fr < f[ lo ] ) {
+            const double fe = along( 2.0 );
+            if( fe < fr ) {
+                simplex[ hi ] = trial;
+                f[ hi ] = fe;
+            }
+            else {
+                simplex[ hi ] = reflected;
+                f[ hi ] = fr;
+            }
+        }
+        else if( fr < f[ next ] ) {
+            simplex[ hi ] = reflected;
+            f[ hi ] = fr;
+        }
+        else {
+            const double fc = along( fr < f[ hi ] ? 0.5 : -0.5 );
+            if( fc < min( fr, f[ hi ] ) ) {
+                simplex[ hi ] = trial;
+                f[ hi ] = fc;
+            }
+            else {
+                // Shrink toward the best point
+                for( size_t j = 0; j <= n; ++j ) {
+                    if( j == lo )
+                        continue;
+                    for( size_t i = 0; i < n; ++i )
+                        simplex[ j ][ i ] = simplex[ lo ][ i ] + 0.5 * ( simplex[ j ][ i ] - simplex[ lo ][ i ] );
+                    f[ j ] = scaledObjective( simplex[ j ] );
+                }
+            }
+        }
+    }
+
+    best = unscale( simplex[ order[ 0 ] ] );
+    return objective( best );
+}
+
+}
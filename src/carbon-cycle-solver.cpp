@@ -44,7 +44,8 @@ void CarbonCycleSolver::init( Core* coreptr ) {
     // This component is very verbose at the debug and notice levels, so limit
     // output to the warning level, even if the rest of the model is configured
     // for something lower.
-    logger.open(getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), Logger::WARNING);
+    logger.open(getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), Logger::WARNING,
+                coreptr->getGlobalLogger().getTagPrefix());
     H_LOG( logger, Logger::DEBUG ) << getComponentName() << " initialized." << std::endl;
 
     core = coreptr;
@@ -149,8 +150,13 @@ unitval CarbonCycleSolver::getData( const std::string& varName,
 
 void CarbonCycleSolver::reset(double time) throw(h_exception)
 {
-    // Only state maintained by this component is the time counter
+    // Only state maintained by this component is the time counter and the
+    // stepsize, which is shortened when the carbon model requests a retry
     t = time;
+    if( dt_ts.exists( time ) ) {
+        dt = dt_ts.get( time );
+    }
+    dt_ts.truncate( time );
     in_spinup = false;          // reset this in case we will be expected to rerun the spinup.
     H_LOG(logger, Logger::NOTICE)
         << getComponentName() << " reset to time= " << time << "\n";
@@ -173,12 +179,16 @@ void CarbonCycleSolver::shutDown()
  *  \param[in] dydt     pool changes
  *  \param[in] t        time
  *  \exception          If the carbon model returned failure flag we must throw
- *                      an exception to stop the ODE solver.
+ *                      an exception to stop the ODE solver.  h_run_aborted if
+ *                      the run was cancelled or is over budget.
  */
 void CarbonCycleSolver::ODEEvalFunctor::operator()( const std::vector<double>& y,
                                                     std::vector<double>& dydt,
-                                                    double t ) throw ( bad_derivative_exception )
+                                                    double t ) throw ( bad_derivative_exception, h_exception )
 {
+    // A member stuck taking tiny steps shows up here first.
+    core->checkRunBudget( 1 );
+
     // Note the std garuntees vetors are contigous so we can convert to array by
     // taking the address of the first value.
     int status = modelptr->calcderivs( t, &y[0], &dydt[0] );
@@ -246,13 +256,17 @@ void CarbonCycleSolver::run( const double tnew ) throw ( h_exception )
 
         H_LOG( logger, Logger::DEBUG ) << "Resetting evolver and stepper" << std::endl;
         double t_start = t;
-        double t_target = tnew;
+        // The ocean takes at most a year at a time, so a longer time step
+        // is integrated one year after another.
+        double t_target = std::min( tnew, floor( t ) + 1.0 );
+        if( t != t0 && t == floor( t ) )
+            cmodel->slowparameval( t, &c[0] );
 
         while( t < t_target && retry < MAX_CARBON_MODEL_RETRIES ) {
             H_LOG( logger, Logger::NOTICE ) << "Attempting ODE solver " << t << "->" << t_target << " (" << t0 << "->" << tnew << ")" << std::endl;
 
             int stat = ODE_SUCCESS;
-            ODEEvalFunctor odeFunctor( cmodel, &t );
+            ODEEvalFunctor odeFunctor( cmodel, &t, core );
             try {
                 using namespace boost::numeric::odeint;
                 typedef runge_kutta_dopri5<std::vector<double> > error_stepper_type;
@@ -292,6 +306,7 @@ void CarbonCycleSolver::run( const double tnew ) throw ( h_exception )
     H_LOG( logger, Logger::DEBUG ) << "cvals\terrors\n";
 
     cmodel->record_state(tnew);
+    dt_ts.set( tnew, dt );
 
     H_LOG( logger, Logger::NOTICE ) << std::endl;
 }
@@ -320,6 +335,7 @@ bool CarbonCycleSolver::run_spinup( const int step ) throw( h_exception )
 
         cmodel->getCValues( t, &c_original[0] );
         cmodel->record_state(t);
+        dt_ts.set( t, dt );
     }
 
     cmodel->getCValues( t, &c_old[0] );
@@ -349,6 +365,7 @@ bool CarbonCycleSolver::run_spinup( const int step ) throw( h_exception )
             << " (delta=" << c_new[ i ]-c_original[ i ] << ")" << std::endl;
         }
         t = core->getStartDate();
+        dt_ts.set( t, dt );
         H_LOG( logger, Logger::NOTICE ) << "Resetting solver time counter to t= " << t << std::endl;
     }
 
@@ -49,7 +49,7 @@ string CH4Component::getComponentName() const {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void CH4Component::init( Core* coreptr ) {
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
     core = coreptr;
 
@@ -133,32 +133,37 @@ void CH4Component::prepareToRun() throw ( h_exception ) {
         M0 = CH4_constrain.get( oldDate );
     }
     CH4.set( oldDate, M0 );  // set the first year's value
+
+    CH4_emissions.share();
+    CH4_constrain.share();
  }
 
 //------------------------------------------------------------------------------
 // documentation is inherited
 void CH4Component::run( const double runToDate ) throw ( h_exception ) {
-	H_ASSERT( !core->inSpinup() && runToDate-oldDate == 1, "timestep must equal 1" );
-
-    if ( CH4_constrain.size() && CH4_constrain.exists( runToDate ) ) {
-        CH4.set( runToDate,  CH4_constrain.get( runToDate ) );
-    } else {
+	H_ASSERT( !core->inSpinup() && runToDate-oldDate <= core->getTimeStep(), "timestep must not exceed the core timestep" );
+
+    // The OH lifetime is only computed for the end of a time step; over a
+    // time step of several years it is held at that value while the
+    // concentration is stepped through each year.
+    const double current_toh = core->sendMessage( M_GETDATA, D_LIFETIME_OH, runToDate ).value( U_YRS );
+    H_LOG( logger, Logger::DEBUG ) << "Year " << runToDate << " current_toh = " << current_toh << std::endl;
+
+    for( double year = oldDate+1; year <= runToDate; year += 1 ) {
+        if ( CH4_constrain.size() && CH4_constrain.exists( year ) ) {
+            CH4.set( year,  CH4_constrain.get( year ) );
+            continue;
+        }
 
         // modified from Wigley et al, 2002
         // https://doi.org/10.1175/1520-0442(2002)015%3C2690:RFDTRG%3E2.0.CO;2
-        const double current_ch4em = CH4_emissions.get( runToDate ).value( U_TG_CH4 );
-        const double current_toh = core->sendMessage( M_GETDATA, D_LIFETIME_OH, runToDate ).value( U_YRS );
-        H_LOG( logger, Logger::DEBUG ) << "Year " << runToDate << " current_toh = " << current_toh << std::endl;
+        const double current_ch4em = CH4_emissions.get( year ).value( U_TG_CH4 );
 
         const double ch4n =  CH4N.value( U_TG_CH4 );
         const double emisTocon = ( current_ch4em + ch4n ) / UC_CH4.value( U_TG_PPBV );
-        double previous_ch4 = M0.value( U_PPBV_CH4 );
-
-        H_LOG( logger, Logger::DEBUG ) << "Year " << runToDate << " previous CH4 = " << previous_ch4 << std::endl;
+        const double previous_ch4 = CH4.get( year-1 ).value( U_PPBV_CH4 );
 
-        if (runToDate!=oldDate) {
-            previous_ch4 = CH4.get( oldDate );
-        }
+        H_LOG( logger, Logger::DEBUG ) << "Year " << year << " previous CH4 = " << previous_ch4 << std::endl;
 
         const double soil_sink = previous_ch4 / Tsoil.value( U_YRS );
         const double strat_sink = previous_ch4 / Tstrat.value( U_YRS );
@@ -166,14 +171,24 @@ void CH4Component::run( const double runToDate ) throw ( h_exception ) {
 
         const double dCH4 = emisTocon - soil_sink - strat_sink - oh_sink; // change in CH4 concentration to be added to previous_ch4
 
-        CH4.set( runToDate, unitval( previous_ch4 + dCH4, U_PPBV_CH4 ) );
-
+        CH4.set( year, unitval( previous_ch4 + dCH4, U_PPBV_CH4 ) );
     }
 
     oldDate = runToDate;
     H_LOG( logger, Logger::DEBUG ) << runToDate << " CH4 concentration = " << CH4.get( runToDate ) << std::endl;
 }
 
+//------------------------------------------------------------------------------
+// documentation is inherited
+tseries<unitval>* CH4Component::getInputSeriesPtr( const std::string& varName,
+                                                   unit_types& units ) {
+    if( varName == D_EMISSIONS_CH4 ) {
+        units = U_TG_CH4;
+        return &CH4_emissions;
+    }
+    return NULL;
+}
+
 //------------------------------------------------------------------------------
 // documentation is inherited
 unitval CH4Component::getData( const std::string& varName,
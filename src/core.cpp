@@ -12,6 +12,10 @@
  *
  */
 
+#include <cmath>
+#include <limits>
+#include <sstream>
+
 #include "boost/algorithm/string.hpp"
 
 #include "imodel_component.hpp"
@@ -28,7 +32,7 @@
 #include "onelineocean_component.hpp"
 #include "o3_component.hpp"
 #include "temperature_component.hpp"
-#include "core.hpp"
+#include "composed_core.hpp"
 #include "dependency_finder.hpp"
 #include "logger.hpp"
 #include "carbon-cycle-solver.hpp"
@@ -40,26 +44,75 @@ namespace Hector {
 
 using namespace std;
 
+//------------------------------------------------------------------------------
+/*! \brief Strip an optional biome prefix ("biome.datum") from a datum name.
+ *  \param datum The datum name, possibly with a biome prefix.
+ *  \return The capability name under which the datum is registered.
+ *  \exception h_exception If the datum has more than one separator.
+ */
+static string datumCapability( const string& datum ) throw ( h_exception )
+{
+    std::vector<std::string> datum_split;
+    boost::split( datum_split, datum, boost::is_any_of( SNBOX_PARSECHAR ) );
+    H_ASSERT( datum_split.size() < 3, "max of one separator allowed in variable names" );
+    return datum_split.back();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Current value of a datum read after a time step.
+ *  \param component The component providing the datum.
+ *  \param current Where it keeps the value (see
+ *         IModelComponent::getCurrentValuePtr), or NULL to ask it with a
+ *         message.
+ *  \param datum The datum name.
+ */
+static inline unitval currentValue( IModelComponent* component, const unitval* current,
+                                    const string& datum ) throw ( h_exception )
+{
+    return current ? *current : component->sendMessage( M_GETDATA, datum, message_data() );
+}
+
 //------------------------------------------------------------------------------
 /*! \brief Constructor
  *
  *  Perform only minimal initialization.  More involved initializations should
  *  go in init.
  *
+ *  \param use_arena If true, the time series of this core's components
+ *         allocate from a memory pool owned by the core (see h_arena) instead
+ *         of the global heap.  This avoids heap contention between cores run
+ *         in different threads, and the pool is released in one piece.
+ *
  *  \sa init()
  */
-Core::Core(Logger::LogLevel loglvl, bool echotoscreen, bool echotofile) :
+Core::Core(Logger::LogLevel loglvl, bool echotoscreen, bool echotofile, bool use_arena) :
+    arena( use_arena ? new h_arena : NULL ),
     setup_complete(false),
     run_name( "" ),
     startDate( -1.0 ),
     endDate( -1.0 ),
     lastDate( -1.0),
+    timeStep( 1 ),
     isInited( false ),
     do_spinup( true ),
     max_spinup( 2000 ),
-    in_spinup( false )
+    in_spinup( false ),
+    coupling_resolved( false ),
+    stopDate( -1.0 ),
+    stopCondition( -1 ),
+    budgetSeconds( 0.0 ),
+    budgetEvaluations( 0 ),
+    evaluationCount( 0 ),
+    cancelToken( std::make_shared<std::atomic<bool> >( false ) ),
+    spinup_invalid( false ),
+    runInvalidDate( numeric_limits<double>::max() )
 {
-    glog.open(string(MODEL_NAME), echotoscreen, echotofile, loglvl);
+    // Number the cores so that their messages can be told apart when they
+    // share a log sink.
+    static std::atomic<int> ncores( 0 );
+    std::ostringstream tag;
+    tag << "core" << ++ncores;
+    glog.open(string(MODEL_NAME), echotoscreen, echotofile, loglvl, tag.str());
 }
 
 //------------------------------------------------------------------------------
@@ -90,6 +143,9 @@ const string& Core::getComponentName() const {
 void Core::init() {
     H_ASSERT( !isInited, "core has already been initialized" );
 
+    // Containers the components create from here on allocate from our arena.
+    h_arena::scope arena_scope( arena );
+
     // TODO: maybe some model component factory?
     IModelComponent *temp;
 
@@ -105,9 +161,6 @@ void Core::init() {
     temp = new N2OComponent();
     modelComponents[ temp->getComponentName() ] = temp;
 
-    temp = new OzoneComponent();
-    modelComponents[ temp->getComponentName() ] = temp;
-
     temp = new ForcingComponent();
     modelComponents[ temp->getComponentName() ] = temp;
     temp = new slrComponent();
@@ -189,7 +242,9 @@ void Core::init() {
             H_LOG(glog, Logger::SEVERE) << "error initializing component " << it->first;
             throw;
         }
+        componentSchedule.push_back( it->second );
     }
+    scheduleChanged();
 
     // Set that the core has now been initialized.
     isInited = true;
@@ -222,6 +277,12 @@ void Core::setData( const string& componentName, const string& varName,
             } else if( varName == D_MAX_SPINUP ) {
                 H_ASSERT( data.date == undefinedIndex(), "date not allowed" );
                 max_spinup = data.getUnitval(U_UNDEFINED);
+            } else if( varName == D_TIMESTEP ) {
+                H_ASSERT( data.date == undefinedIndex(), "date not allowed" );
+                H_ASSERT( !setup_complete, "time step can't be changed after prepareToRun()" );
+                const double step = data.getUnitval(U_UNDEFINED);
+                H_ASSERT( step >= 1 && step == floor( step ), "time step must be a whole number of years" );
+                timeStep = step;
             } else {
                 H_THROW( "Unknown variable name while parsing "+ getComponentName() + ": "
                         + varName );
@@ -274,7 +335,8 @@ void Core::addVisitor( AVisitor* visitor ) {
  *           we begin the runs proper.  As such, this subroutine should be called only
  *           once per run.  The steps performed are:
  *
- *           1) Remove disabled components
+ *           1) Remove disabled components, and components not needed for
+ *              the target outputs, if any were set
  *           2) Construct dependency graph
  *           3) Topological sort components over dependency graph
  *           4) Call each component's prepareToRun() subroutine
@@ -299,22 +361,14 @@ void Core::prepareToRun(void) throw (h_exception)
 
         for( vector<string>::iterator it=disabledComponents.begin(); it != disabledComponents.end(); ++it ) {
             H_LOG( glog, Logger::WARNING ) << "Disabling " << *it << endl;
-            IModelComponent * mcomp = getComponentByName( *it );
-            mcomp->shutDown();
-            delete mcomp;
-            modelComponents.erase( *it );
-
-            componentMapIterator it2 = componentCapabilities.begin();
-            while( it2 != componentCapabilities.end() ) {
-                if( it2->second==*it ) {
-                    H_LOG( glog, Logger::DEBUG) << "--erasing " << it2->first << " " << it2->second << endl;
-                    componentCapabilities.erase( it2++ );
-                } else {
-                    ++it2;
-                }
-            } // while
+            removeComponent( *it );
         } // for
 
+        // If the caller named the outputs it needs, remove everything those
+        // outputs don't depend on.
+        if( !targetOutputs.empty() )
+            pruneComponents();
+
         // ------------------------------------
         // 2. At this point all components should have registered both their capabilities
         // and dependencies. The latter are registered as dependencies on capabilities,
@@ -334,22 +388,38 @@ void Core::prepareToRun(void) throw (h_exception)
 
         // ------------------------------------
         // 3. Now that all dependency information has been resolved and entered, create an ordering,
-        // and then re-sort the modelComponents map based on this new ordering
+        // and then rebuild the component schedule from it.  Components that don't appear in the
+        // ordering have no dependency links at all; they run last, by name.
         depFinder.createOrdering();
-        DependencyOrderingComparator comp( depFinder.getOrdering() );
-        modelComponents = map<string, IModelComponent*,
-                              DependencyOrderingComparator>(modelComponents.begin(), modelComponents.end(), comp );
+        const vector<string>& ordering = depFinder.getOrdering();
+        componentSchedule.clear();
+        for( vector<string>::const_iterator it = ordering.begin(); it != ordering.end(); ++it ) {
+            // dependencies of disabled components may still name them
+            if( modelComponents.count( *it ) )
+                componentSchedule.push_back( modelComponents[ *it ] );
+        }
+        set<string> ordered( ordering.begin(), ordering.end() );
+        for( NameComponentIterator it = modelComponents.begin(); it != modelComponents.end(); ++it ) {
+            if( !ordered.count( it->first ) )
+                componentSchedule.push_back( it->second );
+        }
+        scheduleChanged();
 
+        // Disabled components are gone now, so any coupling buffers bound
+        // earlier must be bound again.
+        coupling_resolved = false;
     }
     setup_complete = true;
 
     /* Everything from here on down is ok to run more than once */
+    startRunBudget();
+
     // ------------------------------------
     // 4. Tell model components we are finished sending data and about to start running.
     H_LOG( glog, Logger::NOTICE) << "Preparing to run..." << endl;
-    for( NameComponentIterator it = modelComponents.begin(); it != modelComponents.end(); ++it ) {
-        //       H_LOG( glog, Logger::DEBUG) << "Preparing " << (*it).second->getComponentName() << " to run" << endl;
-        ( *it ).second->prepareToRun();
+    for( ScheduleIterator it = componentSchedule.begin(); it != componentSchedule.end(); ++it ) {
+        //       H_LOG( glog, Logger::DEBUG) << "Preparing " << (*it)->getComponentName() << " to run" << endl;
+        ( *it )->prepareToRun();
     }
 
     // ------------------------------------
@@ -368,9 +438,8 @@ bool Core::run_spinup()
     bool spunup = false;
     int step = 0;
     while( !spunup && ++step<max_spinup ) {
-        spunup = true;
-        for( NameComponentIterator it = modelComponents.begin(); it != modelComponents.end(); ++it )
-            spunup = spunup && ( *it ).second->run_spinup( step );
+        checkRunBudget();
+        spunup = runScheduleSpinup( step );
 
         // Let visitors attempt to collect data if necessary
         for( VisitorIterator visitorIt = modelVisitors.begin(); visitorIt != modelVisitors.end(); ++visitorIt ) {
@@ -391,12 +460,39 @@ bool Core::run_spinup()
 }
 
 //------------------------------------------------------------------------------
-/*! \brief Run the components for one-year time steps through runtodate
+/*! \brief Run every scheduled component for one date, in schedule order.
+ *  \param date The date to run to.
+ */
+void Core::runSchedule( double date ) throw ( h_exception ) {
+    for( ScheduleIterator it = componentSchedule.begin(); it != componentSchedule.end(); ++it ) {
+        ( *it )->run( date );
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Run one spinup step of the scheduled components.
+ *
+ *  \details Once a component reports that it hasn't spun up, the components
+ *           after it are skipped until the next step.
+ *  \param step The spinup step.
+ *  \return True if every component has spun up.
+ */
+bool Core::runScheduleSpinup( int step ) throw ( h_exception ) {
+    bool spunup = true;
+    for( ScheduleIterator it = componentSchedule.begin(); it != componentSchedule.end(); ++it )
+        spunup = spunup && ( *it )->run_spinup( step );
+    return spunup;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Run the components for time steps through runtodate
  *
  *  \details This subroutine runs the model components.  The argument
- *           runtodate determines how far to advance the model.  It's
- *           given as a double, but since the time is advanced in
- *           one-year time steps, it needs to be an integer value.
+ *           runtodate determines how far to advance the model.  The
+ *           time is advanced in steps of timeStep years (one, unless
+ *           the input sets core.timestep), falling on the start date
+ *           plus a multiple of the step; the model is run through the
+ *           last of these no later than runtodate.
  *           For backward compatibility the runtodate argument can be
  *           omitted, in which case we run to the end date configured
  *           for the core.  The end date still serves as a guarantee
@@ -414,6 +510,9 @@ bool Core::run_spinup()
  *           with progressively larger run-to dates to pick up each
  *           time where it left off before.
  *
+ *           If a stop condition is met (see addStopCondition), the run
+ *           ends after the time step in which it happened.
+ *
  *  \exception h_exception An error which may occur at any stage of the process.
  */
 
@@ -424,9 +523,9 @@ void Core::run(double runtodate) throw ( h_exception ) {
         // override the enddate stored in the core object.
         runtodate = endDate;
     }
-    else if(runtodate < lastDate+1) {
+    else if(runtodate < nextStepDate(lastDate)) {
         H_LOG(glog, Logger::WARNING)
-            << "Requested run-to date is less than 1+lastDate.  Models not run." << endl;
+            << "Requested run-to date is before the next time step.  Models not run." << endl;
         return;
     }
     else if(runtodate > endDate) {
@@ -438,10 +537,17 @@ void Core::run(double runtodate) throw ( h_exception ) {
     // ------------------------------------
     // 6. Run all model dates.
     H_LOG( glog, Logger::NOTICE) << "Running..." << endl;
-    for(double currDate = lastDate+1.0; currDate <= runtodate; currDate += 1.0 ) {
-        for( NameComponentIterator it = modelComponents.begin(); it != modelComponents.end(); ++it ) {
-            ( *it ).second->run( currDate );
-        }
+    stopDate = -1.0;
+    stopCondition = -1;
+    startRunBudget();
+    double currDate;
+    for( currDate = nextStepDate(lastDate); currDate <= runtodate; currDate += timeStep ) {
+        checkRunBudget();
+        pushCouplingInputs( currDate );
+
+        runSchedule( currDate );
+
+        pullCouplingOutputs( currDate );
 
         // Let visitors attempt to collect data if necessary
         for( VisitorIterator visitorIt = modelVisitors.begin(); visitorIt != modelVisitors.end(); ++visitorIt ) {
@@ -449,20 +555,67 @@ void Core::run(double runtodate) throw ( h_exception ) {
                 accept( *visitorIt );
             }
         }
+
+        if( !stopConditions.empty() ) {
+            // Stop conditions may query the model at the date just run.
+            lastDate = currDate;
+            stopCondition = checkStopConditions( currDate );
+            if( stopCondition >= 0 ) {
+                H_LOG( glog, Logger::NOTICE ) << "Stop condition " << stopCondition
+                                              << " met at t= " << currDate << endl;
+                stopDate = currDate;
+                return;
+            }
+        }
     }
 
     // Record the last finished date.  We will resume here the next time run is called
-    lastDate = runtodate;
+    lastDate = currDate - timeStep;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief The first time step after a date
+ *  \param date The date, usually the last one run.
+ *  \return The earliest date later than date that falls on the start date
+ *           plus a multiple of the time step.
+ */
+double Core::nextStepDate( double date ) const {
+    return startDate + ( floor( ( date - startDate ) / timeStep ) + 1.0 ) * timeStep;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief The last time step before a date
+ *  \param date The date.
+ *  \return The latest date earlier than date that falls on the start date
+ *           plus a multiple of the time step.
+ */
+double Core::previousStepDate( double date ) const {
+    return startDate + ( ceil( ( date - startDate ) / timeStep ) - 1.0 ) * timeStep;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Whether a date is one the model runs at
+ *  \param date The date.
+ *  \return True if date is the start date plus a multiple of the time step.
+ */
+bool Core::isStepDate( double date ) const {
+    return previousStepDate( date ) + timeStep == date;
 }
 
 
 void Core::reset(double resetdate)
 {
-    bool rerun_spinup = false;
+    bool rerun_setup = resetdate < getStartDate();
+    if(!rerun_setup && !isStepDate(resetdate)) {
+        // Components keep their state only at the time steps, so go back to
+        // the last one; rerunning from an earlier date is always safe.
+        H_LOG(glog, Logger::NOTICE) << "Reset date " << resetdate
+                                    << " is not a time step; using the one before it.\n";
+        resetdate = previousStepDate(resetdate);
+    }
     H_LOG(glog, Logger::NOTICE) << "Resetting model to t= " << resetdate << endl;
-    if(resetdate < getStartDate()) {
+    if(rerun_setup) {
         if(do_spinup) {
-            rerun_spinup = true;
             resetdate = 0;      // t=0 is the first iteration of the spinup.
             H_LOG(glog, Logger::NOTICE) << "Rerunning spinup.\n";
         }
@@ -473,22 +626,563 @@ void Core::reset(double resetdate)
         }
     }
 
-    for(NameComponentIterator it = modelComponents.begin(); it != modelComponents.end(); ++it) {
-        H_LOG(glog, Logger::DEBUG) << "Resetting component: " << it->first << endl;
-        it->second->reset(resetdate);
+    for(ScheduleIterator it = componentSchedule.begin(); it != componentSchedule.end(); ++it) {
+        H_LOG(glog, Logger::DEBUG) << "Resetting component: " << (*it)->getComponentName() << endl;
+        (*it)->reset(resetdate);
     }
 
-    // The prepareToRun function reruns all of the initial setup, including the
-    // spinup.  This is necessary because we may have changed some of the model
-    // parameters, and for many components the parameters produce their effect
-    // by influencing the initial state.
-    if(rerun_spinup)
+    if(rerun_setup) {
+        // The prepareToRun function reruns all of the initial setup, including
+        // the spinup.  This is necessary because we may have changed some of
+        // the model parameters, and for many components the parameters
+        // produce their effect by influencing the initial state.
         prepareToRun();
-
-    if(rerun_spinup)
+        clearChanges();
         lastDate = getStartDate();
-    else
+    }
+    else {
+        // Parameters that only act from the start date onward still have to
+        // reach the derived constants their components compute in
+        // prepareToRun.
+        if(resetdate <= getStartDate()) {
+            for(set<string>::const_iterator it = prepareComponents.begin(); it != prepareComponents.end(); ++it) {
+                H_LOG(glog, Logger::DEBUG) << "Re-preparing component: " << *it << endl;
+                getComponentByName(*it)->prepareToRun();
+            }
+            prepareComponents.clear();
+            diagnosticComponents.clear();
+        }
+        if(resetdate <= runInvalidDate)
+            runInvalidDate = numeric_limits<double>::max();
         lastDate = resetdate;
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Recompute what parameter changes made since the last run invalidate
+ *
+ *  \details Changes that invalidate the spinup reset the model to t=0.
+ *           Otherwise, components whose diagnostic parameters changed, along
+ *           with every component depending on them, are rerun by themselves
+ *           through the last date that stays valid; then the whole model is
+ *           reset to the earliest date invalidated by changed run parameters
+ *           or by dated inputs.  A subsequent call to run() picks up from
+ *           there.
+ *
+ *  \exception h_exception An error which may occur at any stage of the process.
+ *  \sa registerInvalidation
+ */
+void Core::applyChanges() throw ( h_exception )
+{
+    H_ASSERT( setup_complete, "applyChanges() called before prepareToRun()" );
+    startRunBudget();
+
+    if( spinup_invalid ) {
+        reset( 0 );
+        return;
+    }
+
+    if( !diagnosticComponents.empty() ) {
+        set<string> rerun = getDependentComponents( diagnosticComponents );
+        double rerunDate = min( lastDate, runInvalidDate );
+        H_LOG( glog, Logger::NOTICE ) << "Rerunning " << rerun.size()
+                                      << " components through t= " << rerunDate << endl;
+
+        vector<IModelComponent*> schedule;
+        for( ScheduleIterator it = componentSchedule.begin(); it != componentSchedule.end(); ++it ) {
+            if( rerun.count( ( *it )->getComponentName() ) ) {
+                ( *it )->prepareToRun();
+                ( *it )->reset( getStartDate() );
+                schedule.push_back( *it );
+            }
+        }
+        for( double currDate = nextStepDate( getStartDate() ); currDate <= rerunDate; currDate += timeStep ) {
+            checkRunBudget();
+            for( ScheduleIterator it = schedule.begin(); it != schedule.end(); ++it )
+                ( *it )->run( currDate );
+        }
+        diagnosticComponents.clear();
+    }
+
+    if( runInvalidDate <= lastDate )
+        reset( runInvalidDate );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Advance the model by a single time step
+ *
+ *  \details This is the entry point for tightly coupled drivers.  Before the
+ *           components run, every registered input buffer is pushed into the
+ *           model for the new date; afterwards every registered output buffer
+ *           is filled in.  The core must have been prepared to run.
+ *
+ *  \return The date the model has been run to.
+ *  \exception h_exception An error which may occur at any stage of the process.
+ *  \sa registerInputBuffer, registerOutputBuffer
+ */
+double Core::step() throw ( h_exception ) {
+    H_ASSERT( setup_complete, "step() called before prepareToRun()" );
+    run( nextStepDate( lastDate ) );
+    return lastDate;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Register an array of input values to be pushed into the model
+ *
+ *  \details Before each time step with date d, the value
+ *           buffer[d-bufferStart] is sent to every component that accepts
+ *           datum (as with sendMessage(M_SETDATA, ...)).  Dates outside of the
+ *           buffer are left alone.  The caller owns the memory and may update
+ *           the values between steps; the core keeps only the pointer.
+ *
+ *  \param datum The input name (e.g. D_FFI_EMISSIONS).
+ *  \param buffer The caller's array.  Must stay valid until the buffers are
+ *         cleared or the core is destroyed.
+ *  \param len Number of entries in buffer.
+ *  \param bufferStart Date of buffer[0].
+ *  \param units Units of the values in buffer.
+ *  \exception h_exception If the core is not initialized or no component
+ *              accepts the input.
+ */
+void Core::registerInputBuffer( const string& datum, const double* buffer,
+                                size_t len, double bufferStart, unit_types units ) throw ( h_exception )
+{
+    H_ASSERT( isInited, "registerInputBuffer not available until core is initialized" );
+    H_ASSERT( buffer != NULL, "input buffer for " + datum + " is NULL" );
+    H_ASSERT( componentInputs.count( datumCapability( datum ) ), "No such input: " + datum );
+
+    coupling_buffer cb = { datum, buffer, NULL, len, bufferStart, units };
+    couplingInputs.push_back( cb );
+    coupling_resolved = false;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Register an array to be filled with model output
+ *
+ *  \details After each time step with date d, the current value of datum is
+ *           written to buffer[d-bufferStart], converted to units.  Dates
+ *           outside of the buffer are not recorded.
+ *
+ *  \param datum The output name (e.g. D_GLOBAL_TEMP).
+ *  \param buffer The caller's array.  Must stay valid until the buffers are
+ *         cleared or the core is destroyed.
+ *  \param len Number of entries in buffer.
+ *  \param bufferStart Date of buffer[0].
+ *  \param units Units in which to record the values.
+ *  \exception h_exception If the core is not initialized or the datum is not
+ *              provided by any component.
+ */
+void Core::registerOutputBuffer( const string& datum, double* buffer,
+                                 size_t len, double bufferStart, unit_types units ) throw ( h_exception )
+{
+    H_ASSERT( isInited, "registerOutputBuffer not available until core is initialized" );
+    H_ASSERT( buffer != NULL, "output buffer for " + datum + " is NULL" );
+    H_ASSERT( checkCapability( datumCapability( datum ) ), "Unknown model datum: " + datum );
+
+    coupling_buffer cb = { datum, NULL, buffer, len, bufferStart, units };
+    couplingOutputs.push_back( cb );
+    coupling_resolved = false;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Forget all registered coupling buffers
+ */
+void Core::clearCouplingBuffers()
+{
+    couplingInputs.clear();
+    couplingOutputs.clear();
+    coupling_resolved = false;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Subscribe to a set of model outputs
+ *
+ *  \details After each time step with date d, where d is in [start, end] and
+ *           d-start is a multiple of stride, the current value of each datum
+ *           is copied into a buffer kept by the core.  Nothing else about the
+ *           model's outputs is touched, so a run that needs only a few
+ *           outputs can use a subscription instead of visitors.  After a
+ *           reset, rows for dates that are run again are overwritten; rows
+ *           after getCurrentDate() are left over from the earlier run.
+ *
+ *  \param datums The output names (e.g. D_GLOBAL_TEMP).
+ *  \param start First date to record.  Default (<0) is the first date run
+ *         after the start date.
+ *  \param end Last date to record.  Default (<0) is the end date.
+ *  \param stride Record every stride'th date.
+ *  \return An id for the subscription.
+ *  \exception h_exception If the core is not initialized, the date range is
+ *              empty, or a datum is not provided by any component.
+ *  \sa getSubscriptionValues
+ */
+int Core::subscribeOutputs( const vector<string>& datums, double start, double end,
+                            int stride ) throw ( h_exception )
+{
+    H_ASSERT( isInited, "subscribeOutputs not available until core is initialized" );
+    H_ASSERT( !datums.empty(), "subscription has no outputs" );
+    H_ASSERT( stride > 0, "subscription stride must be positive" );
+    for( vector<string>::const_iterator it = datums.begin(); it != datums.end(); ++it ) {
+        H_ASSERT( checkCapability( datumCapability( *it ) ), "Unknown model datum: " + *it );
+    }
+    if( start < 0.0 )
+        start = nextStepDate( getStartDate() );
+    if( end < 0.0 )
+        end = getEndDate();
+    H_ASSERT( end >= start, "subscription date range is empty" );
+
+    output_subscription sub;
+    sub.datums = datums;
+    sub.start = start;
+    sub.end = end;
+    sub.stride = stride;
+    const size_t nrows = size_t( ( end - start ) / stride ) + 1;
+    sub.values.assign( nrows * datums.size(), 0.0 );
+    sub.units.assign( datums.size(), U_UNDEFINED );
+    outputSubscriptions.push_back( sub );
+    coupling_resolved = false;
+    return int( outputSubscriptions.size() ) - 1;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Stop recording a subscription and free its buffer
+ *  \param id The id returned by subscribeOutputs.
+ */
+void Core::unsubscribeOutputs( int id ) throw ( h_exception )
+{
+    getSubscription( id );
+    outputSubscriptions[ id ] = output_subscription();
+    outputSubscriptions[ id ].stride = 0;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Look up a subscription by id
+ *  \exception h_exception If there's no such subscription.
+ */
+const Core::output_subscription& Core::getSubscription( int id ) const throw ( h_exception )
+{
+    H_ASSERT( id >= 0 && size_t( id ) < outputSubscriptions.size() &&
+              outputSubscriptions[ id ].stride > 0, "no such output subscription" );
+    return outputSubscriptions[ id ];
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Values recorded for a subscription
+ *  \param id The id returned by subscribeOutputs.
+ *  \return One row per subscription date (see getSubscriptionDates), each with
+ *          one value per datum, in the order the datums were given.
+ */
+const vector<double>& Core::getSubscriptionValues( int id ) const throw ( h_exception )
+{
+    return getSubscription( id ).values;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Outputs recorded by a subscription
+ *  \param id The id returned by subscribeOutputs.
+ *  \return The datums, in the order their values appear in each row.
+ */
+const vector<string>& Core::getSubscriptionDatums( int id ) const throw ( h_exception )
+{
+    return getSubscription( id ).datums;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Dates of the rows of a subscription's values
+ *  \param id The id returned by subscribeOutputs.
+ */
+vector<double> Core::getSubscriptionDates( int id ) const throw ( h_exception )
+{
+    const output_subscription& sub = getSubscription( id );
+    vector<double> dates;
+    for( double date = sub.start; date <= sub.end; date += sub.stride )
+        dates.push_back( date );
+    return dates;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Units of each of a subscription's datums
+ *  \param id The id returned by subscribeOutputs.
+ *  \return The units of each datum; U_UNDEFINED until a value has been recorded.
+ */
+vector<unit_types> Core::getSubscriptionUnits( int id ) const throw ( h_exception )
+{
+    return getSubscription( id ).units;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Stop runs once a datum crosses a threshold
+ *
+ *  \details After each time step, once the components and visitors are done,
+ *           the datum is compared to the threshold.  If it is at or above the
+ *           threshold (or at or below it, if above is false), run() returns
+ *           right away, leaving the model at that date; getStopDate() and
+ *           getStopCondition() report what happened.  Conditions stay in
+ *           force for later runs until clearStopConditions() is called, so a
+ *           run continued past a stop will usually stop again at once.
+ *
+ *  \param datum The output name (e.g. D_GLOBAL_TEMP).
+ *  \param threshold Threshold, in the units the model reports datum in.
+ *  \param above Stop when the value is >= threshold if true, <= if false.
+ *  \return An id for the condition.
+ *  \exception h_exception If the core is not initialized or the datum is not
+ *              provided by any component.
+ */
+int Core::addStopCondition( const string& datum, double threshold, bool above ) throw ( h_exception )
+{
+    H_ASSERT( isInited, "addStopCondition not available until core is initialized" );
+    H_ASSERT( checkCapability( datumCapability( datum ) ), "Unknown model datum: " + datum );
+
+    stop_condition sc = { datum, threshold, above, stop_callback(), NULL };
+    stopConditions.push_back( sc );
+    coupling_resolved = false;
+    return int( stopConditions.size() ) - 1;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Stop runs once a caller-supplied test passes
+ *
+ *  \details Like the threshold version, except that the test is a function
+ *           called with the core and the date just run.  It can query the
+ *           model with sendMessage; it should not change it.
+ *
+ *  \param callback Returns true to stop the run.
+ *  \return An id for the condition.
+ *  \exception h_exception If callback is empty.
+ */
+int Core::addStopCondition( const stop_callback& callback ) throw ( h_exception )
+{
+    H_ASSERT( static_cast<bool>( callback ), "stop condition callback is empty" );
+
+    stop_condition sc = { "", 0.0, true, callback, NULL };
+    stopConditions.push_back( sc );
+    return int( stopConditions.size() ) - 1;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Forget all stop conditions
+ */
+void Core::clearStopConditions()
+{
+    stopConditions.clear();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Find the first stop condition met at a date
+ *  \param date The date that has just been run.
+ *  \return The id of the condition, or -1 if none is met.
+ */
+int Core::checkStopConditions( double date ) throw ( h_exception )
+{
+    if( !coupling_resolved )
+        resolveCouplingBuffers();
+
+    for( size_t i = 0; i < stopConditions.size(); ++i ) {
+        const stop_condition& sc = stopConditions[ i ];
+        bool met;
+        if( sc.callback ) {
+            met = sc.callback( *this, date );
+        }
+        else {
+            const unitval v = currentValue( sc.component, sc.current, sc.datum );
+            const double x = v.value( v.units() );
+            met = sc.above ? x >= sc.threshold : x <= sc.threshold;
+        }
+        if( met )
+            return int( i );
+    }
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Limit how long runs may take
+ *
+ *  \details Each call to prepareToRun() (which includes the spinup), run(),
+ *           or applyChanges() gets the whole budget.  A run that exceeds it
+ *           is aborted with h_run_aborted, leaving the model partway through
+ *           a time step; the core must be reset before it is run again.
+ *           This keeps a member whose solver is stuck taking tiny steps from
+ *           holding up the rest of an ensemble.
+ *
+ *  \param seconds Wall-clock time allowed (0 for no limit).
+ *  \param evaluations Carbon cycle derivative evaluations allowed (0 for no
+ *         limit).  Unlike the time limit, this gives the same result on any
+ *         machine.
+ */
+void Core::setRunBudget( double seconds, long evaluations )
+{
+    budgetSeconds = seconds;
+    budgetEvaluations = evaluations;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Replace the flag that cancels this core's runs
+ *
+ *  \details Giving several cores the same token lets a batch driver cancel
+ *           them all at once.  Setting the flag (from any thread) aborts the
+ *           current run with h_run_aborted at the next check, and every run
+ *           after it until the flag is cleared.
+ *  \param token The new flag.
+ */
+void Core::setCancelToken( const cancel_token& token )
+{
+    H_ASSERT( static_cast<bool>( token ), "cancel token is null" );
+    cancelToken = token;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Start the budget for a run over
+ */
+void Core::startRunBudget()
+{
+    budgetStart = std::chrono::steady_clock::now();
+    evaluationCount = 0;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Abort the run if it has been cancelled or is over budget
+ *
+ *  \details Called by the core every time step and spinup step, and by
+ *           components with loops that may take a long time.
+ *  \param evaluations Derivative evaluations to count against the budget.
+ *  \exception h_run_aborted If the run must stop.
+ */
+void Core::checkRunBudget( long evaluations ) throw ( h_run_aborted )
+{
+    evaluationCount += evaluations;
+
+    if( *cancelToken ) {
+        throw h_run_aborted( h_run_aborted::CANCELLED, "Run cancelled",
+                             __func__, __FILE__, __LINE__ );
+    }
+    if( budgetEvaluations > 0 && evaluationCount > budgetEvaluations ) {
+        H_LOG( glog, Logger::SEVERE ) << "Run exceeded its budget of " << budgetEvaluations
+                                      << " derivative evaluations" << endl;
+        throw h_run_aborted( h_run_aborted::EVALUATION_BUDGET, "Run exceeded its evaluation budget",
+                             __func__, __FILE__, __LINE__ );
+    }
+    if( budgetSeconds > 0.0 ) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - budgetStart;
+        if( elapsed.count() > budgetSeconds ) {
+            H_LOG( glog, Logger::SEVERE ) << "Run exceeded its time budget of "
+                                          << budgetSeconds << " s" << endl;
+            throw h_run_aborted( h_run_aborted::TIME_BUDGET, "Run exceeded its time budget",
+                                 __func__, __FILE__, __LINE__ );
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Bind each coupling buffer to the components it exchanges data with
+ *  \details Done once, the first time the buffers are used after a change in
+ *           registrations or the component list.  Inputs are bound to the
+ *           components' series where they expose them, and outputs to their
+ *           current values, so the per-step exchange sends no messages.
+ */
+void Core::resolveCouplingBuffers() throw ( h_exception )
+{
+    for( vector<coupling_buffer>::iterator it = couplingInputs.begin(); it != couplingInputs.end(); ++it ) {
+        it->components.clear();
+        it->series.clear();
+        pair<componentMapIterator, componentMapIterator> itpr =
+            componentInputs.equal_range( datumCapability( it->datum ) );
+        for( componentMapIterator cit = itpr.first; cit != itpr.second; ++cit ) {
+            // Inputs to disabled components have nowhere to go
+            if( !modelComponents.count( cit->second ) )
+                continue;
+            IModelComponent* component = getComponentByName( cit->second );
+            unit_types units = U_UNDEFINED;
+            tseries<unitval>* series = component->getInputSeriesPtr( it->datum, units );
+            // Values in other units would fail setData's check every step.
+            // Values without units take the component's, so leave those to
+            // setData.
+            H_ASSERT( !series || it->units == U_UNDEFINED || units == it->units,
+                      "Units: " + unitval::unitsName( it->units ) + " do not match expected: " +
+                      unitval::unitsName( units ) + " for " + it->datum );
+            if( it->units == U_UNDEFINED )
+                series = NULL;
+            it->components.push_back( component );
+            it->series.push_back( series );
+        }
+    }
+    for( vector<coupling_buffer>::iterator it = couplingOutputs.begin(); it != couplingOutputs.end(); ++it ) {
+        it->components.assign( 1, getComponentByCapability( datumCapability( it->datum ) ) );
+        it->current = it->components.front()->getCurrentValuePtr( it->datum );
+    }
+    for( vector<output_subscription>::iterator it = outputSubscriptions.begin(); it != outputSubscriptions.end(); ++it ) {
+        it->components.clear();
+        it->currents.clear();
+        for( vector<string>::const_iterator dit = it->datums.begin(); dit != it->datums.end(); ++dit ) {
+            it->components.push_back( getComponentByCapability( datumCapability( *dit ) ) );
+            it->currents.push_back( it->components.back()->getCurrentValuePtr( *dit ) );
+        }
+    }
+    for( vector<stop_condition>::iterator it = stopConditions.begin(); it != stopConditions.end(); ++it ) {
+        if( !it->callback ) {
+            it->component = getComponentByCapability( datumCapability( it->datum ) );
+            it->current = it->component->getCurrentValuePtr( it->datum );
+        }
+    }
+    coupling_resolved = true;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Send the values of all input buffers for date to their components
+ *  \param date The date about to be run.
+ */
+void Core::pushCouplingInputs( double date ) throw ( h_exception )
+{
+    if( couplingInputs.empty() )
+        return;
+    if( !coupling_resolved )
+        resolveCouplingBuffers();
+
+    for( vector<coupling_buffer>::const_iterator it = couplingInputs.begin(); it != couplingInputs.end(); ++it ) {
+        double idx = date - it->bufferStart;
+        if( idx < 0 || idx >= it->len )
+            continue;
+        const unitval value( it->source[ size_t( idx ) ], it->units );
+        for( size_t i = 0; i < it->components.size(); ++i ) {
+            if( it->series[ i ] )
+                it->series[ i ]->set( date, value );
+            else
+                it->components[ i ]->sendMessage( M_SETDATA, it->datum, message_data( date, value ) );
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Copy the current model values into all output buffers and
+ *         subscriptions
+ *  \param date The date that has just been run.
+ */
+void Core::pullCouplingOutputs( double date ) throw ( h_exception )
+{
+    if( couplingOutputs.empty() && outputSubscriptions.empty() )
+        return;
+    if( !coupling_resolved )
+        resolveCouplingBuffers();
+
+    for( vector<coupling_buffer>::const_iterator it = couplingOutputs.begin(); it != couplingOutputs.end(); ++it ) {
+        double idx = date - it->bufferStart;
+        if( idx < 0 || idx >= it->len )
+            continue;
+        it->dest[ size_t( idx ) ] = currentValue( it->components.front(), it->current, it->datum ).value( it->units );
+    }
+
+    for( vector<output_subscription>::iterator it = outputSubscriptions.begin(); it != outputSubscriptions.end(); ++it ) {
+        if( it->stride == 0 || date < it->start || date > it->end )
+            continue;
+        const int offset = int( date - it->start );
+        if( offset % it->stride )
+            continue;
+        const size_t ndatums = it->datums.size();
+        double* row = &it->values[ size_t( offset / it->stride ) * ndatums ];
+        for( size_t i = 0; i < ndatums; ++i ) {
+            const unitval v = currentValue( it->components[ i ], it->currents[ i ], it->datums[ i ] );
+            row[ i ] = v.value( v.units() );
+            it->units[ i ] = v.units();
+        }
+    }
 }
 
 
@@ -500,8 +1194,8 @@ void Core::shutDown()
 {
     // ------------------------------------
     // 7. Tell model components we are finished.
-    for( NameComponentIterator it = modelComponents.begin(); it != modelComponents.end(); ++it ) {
-        ( *it ).second->shutDown();
+    for( ScheduleIterator it = componentSchedule.begin(); it != componentSchedule.end(); ++it ) {
+        ( *it )->shutDown();
     }
 }
 
@@ -591,6 +1285,246 @@ void Core::registerInput(const string& inputName, const string& componentName) {
     registerCapability(inputName, componentName, false);
 }
 
+//------------------------------------------------------------------------------
+/*! \brief Do this core and another use the same storage for an input?
+ *
+ *  \details Input series are shared across cores copy-on-write (see
+ *           tseries::share()), so this is true for an input both cores read
+ *           from the same data until one of them changes it.
+ *
+ *  \param datum The input name (e.g. D_FFI_EMISSIONS).
+ *  \param other The other core.
+ *  \returns Whether every component that accepts the input holds it in the
+ *           same storage as its counterpart in the other core.
+ *  \exception h_exception If no component in this core keeps the input in
+ *              a series.
+ */
+bool Core::sharesInput( const string& datum, const Core& other ) const throw ( h_exception )
+{
+    bool found = false;
+    typedef multimap<string, string>::const_iterator CComponentMapIterator;
+    pair<CComponentMapIterator, CComponentMapIterator> itpr =
+        componentInputs.equal_range( datumCapability( datum ) );
+    for( CComponentMapIterator it = itpr.first; it != itpr.second; ++it ) {
+        if( !modelComponents.count( it->second ) || !other.modelComponents.count( it->second ) )
+            continue;
+        unit_types units;
+        const tseries<unitval>* series = getComponentByName( it->second )->getInputSeriesPtr( datum, units );
+        const tseries<unitval>* otherSeries = other.getComponentByName( it->second )->getInputSeriesPtr( datum, units );
+        if( !series || !otherSeries )
+            continue;
+        if( !series->sharesData( *otherSeries ) )
+            return false;
+        found = true;
+    }
+    H_ASSERT( found, "No series holds input: " + datum );
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Declare how much of a run a change to a parameter invalidates
+ *
+ *  \details Components call this from their init() for parameters that can
+ *           be changed without rerunning the spinup.  Parameters that are
+ *           never declared are assumed to invalidate the spinup.
+ *
+ *  \param paramName The name of the parameter (an input of the component).
+ *  \param componentName The name of the component.
+ *  \param invalidation The invalidation class of the parameter.
+ */
+void Core::registerInvalidation( const string& paramName, const string& componentName,
+                                 Invalidation invalidation ) {
+    H_ASSERT( !isInited, "registerInvalidation not available after core is initialized")
+
+    parameterInvalidation[ make_pair( componentName, paramName ) ] = invalidation;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Record what a new value sent to a component invalidates
+ *  \param componentName The name of the component receiving the value.
+ *  \param datum The datum set, possibly with a biome prefix.
+ *  \param date The date of the value, or undefinedIndex() for parameters.
+ */
+void Core::noteChange( const string& componentName, const string& datum,
+                       double date ) {
+    if( date != undefinedIndex() ) {
+        // Values for dates not yet run don't invalidate anything.  The run
+        // stays valid through the time step before the new value.
+        if( date > lastDate )
+            return;
+        const double valid = previousStepDate( date );
+        if( valid < getStartDate() )
+            spinup_invalid = true;
+        else
+            runInvalidDate = min( runInvalidDate, valid );
+        return;
+    }
+
+    map<pair<string, string>, Invalidation>::const_iterator it =
+        parameterInvalidation.find( make_pair( componentName, datumCapability( datum ) ) );
+    Invalidation invalidation = it == parameterInvalidation.end() ? INVALIDATE_SPINUP : it->second;
+
+    switch( invalidation ) {
+        case INVALIDATE_SPINUP:
+            spinup_invalid = true;
+            break;
+        case INVALIDATE_RUN:
+            prepareComponents.insert( componentName );
+            runInvalidDate = min( runInvalidDate, getStartDate() );
+            break;
+        case INVALIDATE_DIAGNOSTICS:
+            diagnosticComponents.insert( componentName );
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Find the components that depend, directly or not, on any of a set
+ *         of components.
+ *  \param components The names of the components to start from.
+ *  \return The input components together with all of their dependents.
+ */
+set<string> Core::getDependentComponents( const set<string>& components ) const {
+    set<string> closure( components );
+    bool grew = true;
+    while( grew ) {
+        grew = false;
+        for( multimap<string, string>::const_iterator it = componentDependencies.begin();
+             it != componentDependencies.end(); ++it ) {
+            if( closure.count( it->first ) || !modelComponents.count( it->first ) ||
+                !componentCapabilities.count( it->second ) )
+                continue;
+            if( closure.count( getComponentByCapability( it->second )->getComponentName() ) ) {
+                closure.insert( it->first );
+                grew = true;
+            }
+        }
+    }
+    return closure;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Find the components that any of a set of components depend on,
+ *         directly or not.
+ *  \details Both ordinary and lagged dependencies are followed.
+ *  \param components The names of the components to start from.
+ *  \return The input components together with everything upstream of them.
+ */
+set<string> Core::getUpstreamComponents( const set<string>& components ) const {
+    set<string> closure( components );
+    vector<string> pending( components.begin(), components.end() );
+    while( !pending.empty() ) {
+        const string name = pending.back();
+        pending.pop_back();
+        const multimap<string, string>* deps[] = { &componentDependencies, &componentLaggedDependencies };
+        for( int i = 0; i < 2; ++i ) {
+            pair<multimap<string, string>::const_iterator, multimap<string, string>::const_iterator> range =
+                deps[ i ]->equal_range( name );
+            for( multimap<string, string>::const_iterator it = range.first; it != range.second; ++it ) {
+                if( !componentCapabilities.count( it->second ) )
+                    continue;
+                const string provider = getComponentByCapability( it->second )->getComponentName();
+                if( closure.insert( provider ).second )
+                    pending.push_back( provider );
+            }
+        }
+    }
+    return closure;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Remove the components that the target outputs don't need
+ *
+ *  \details Starting from the components that provide the target outputs,
+ *           subscribed outputs, and coupling output buffers, keep everything
+ *           upstream of them.  Components that provide no capabilities at
+ *           all (such as the carbon cycle solver) exist to drive other
+ *           components, so they're kept whenever everything they depend on
+ *           is kept.  All other components are shut down and deleted.
+ *
+ *  \exception h_exception If no component provides one of the outputs.
+ */
+void Core::pruneComponents() throw ( h_exception ) {
+    vector<string> datums( targetOutputs );
+    for( vector<output_subscription>::const_iterator it = outputSubscriptions.begin(); it != outputSubscriptions.end(); ++it )
+        datums.insert( datums.end(), it->datums.begin(), it->datums.end() );
+    for( vector<coupling_buffer>::const_iterator it = couplingOutputs.begin(); it != couplingOutputs.end(); ++it )
+        datums.push_back( it->datum );
+    for( vector<stop_condition>::const_iterator it = stopConditions.begin(); it != stopConditions.end(); ++it ) {
+        if( !it->callback )
+            datums.push_back( it->datum );
+    }
+
+    set<string> roots;
+    for( vector<string>::const_iterator it = datums.begin(); it != datums.end(); ++it ) {
+        H_ASSERT( checkCapability( datumCapability( *it ) ), "Unknown model datum: " + *it );
+        roots.insert( getComponentByCapability( datumCapability( *it ) )->getComponentName() );
+    }
+    set<string> keep = getUpstreamComponents( roots );
+
+    set<string> providers;
+    for( componentMapIterator it = componentCapabilities.begin(); it != componentCapabilities.end(); ++it )
+        providers.insert( it->second );
+    for( NameComponentIterator it = modelComponents.begin(); it != modelComponents.end(); ++it ) {
+        if( providers.count( it->first ) || keep.count( it->first ) )
+            continue;
+        set<string> self;
+        self.insert( it->first );
+        set<string> upstream = getUpstreamComponents( self );
+        upstream.erase( it->first );
+        if( includes( keep.begin(), keep.end(), upstream.begin(), upstream.end() ) )
+            keep.insert( it->first );
+    }
+
+    vector<string> pruned;
+    for( NameComponentIterator it = modelComponents.begin(); it != modelComponents.end(); ++it ) {
+        if( !keep.count( it->first ) )
+            pruned.push_back( it->first );
+    }
+    H_LOG( glog, Logger::NOTICE ) << "Target outputs need " << keep.size() << " components; removing "
+                                  << pruned.size() << endl;
+    for( vector<string>::const_iterator it = pruned.begin(); it != pruned.end(); ++it ) {
+        H_LOG( glog, Logger::DEBUG ) << "Pruning " << *it << endl;
+        removeComponent( *it );
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Shut down and delete a component, and forget its capabilities and
+ *         inputs.
+ *  \param componentName The name of the component.
+ */
+void Core::removeComponent( const string& componentName ) {
+    IModelComponent * mcomp = getComponentByName( componentName );
+    mcomp->shutDown();
+    delete mcomp;
+    modelComponents.erase( componentName );
+    datumProviders.clear();
+
+    multimap<string, string>* maps[] = { &componentCapabilities, &componentInputs };
+    for( int i = 0; i < 2; ++i ) {
+        componentMapIterator it = maps[ i ]->begin();
+        while( it != maps[ i ]->end() ) {
+            if( it->second==componentName ) {
+                H_LOG( glog, Logger::DEBUG) << "--erasing " << it->first << " " << it->second << endl;
+                maps[ i ]->erase( it++ );
+            } else {
+                ++it;
+            }
+        } // while
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Forget all recorded parameter changes.
+ */
+void Core::clearChanges() {
+    spinup_invalid = false;
+    runInvalidDate = numeric_limits<double>::max();
+    prepareComponents.clear();
+    diagnosticComponents.clear();
+}
+
 //------------------------------------------------------------------------------
 /*! \brief Check whether a capability has been registered with the core
  *  \param capabilityName The capability of the component to register.
@@ -614,6 +1548,45 @@ void Core::registerDependency( const string& capabilityName, const string& compo
 }
 
 
+//------------------------------------------------------------------------------
+/*! \brief Register a dependency that doesn't constrain the run order.
+ *  \details Use this when a component reads a capability whose provider
+ *           doesn't have to run before it within a time step, for example
+ *           because it uses the previous step's value to close a feedback
+ *           loop.  The dependency is only used to decide which components
+ *           the target outputs need (see setTargetOutputs).
+ *  \param capabilityName The capability on which the component depends.
+ *  \param componentName The name of the component.
+ */
+void Core::registerLaggedDependency( const string& capabilityName, const string& componentName ) {
+    H_ASSERT( !isInited, "registerLaggedDependency not available after core is initialized")
+
+    componentLaggedDependencies.insert( pair<string, string>( componentName, capabilityName ) );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Set the outputs the caller needs, so that other components can be
+ *         skipped
+ *
+ *  \details When prepareToRun sets up the model, only the components that
+ *           these outputs (and any subscribed or coupled outputs or stop
+ *           conditions) depend on are kept; the rest are shut down and
+ *           deleted.  This saves both memory and time when only a few
+ *           outputs are wanted.  Inputs and parameters of removed components
+ *           are no longer accepted.
+ *  \param datums The output names (e.g. D_GLOBAL_TEMP).
+ *  \exception h_exception If the model has already been set up, or a datum is
+ *              not provided by any component.
+ */
+void Core::setTargetOutputs( const vector<string>& datums ) throw ( h_exception ) {
+    H_ASSERT( isInited, "setTargetOutputs not available until core is initialized" );
+    H_ASSERT( !setup_complete, "setTargetOutputs must be called before prepareToRun" );
+    for( vector<string>::const_iterator it = datums.begin(); it != datums.end(); ++it ) {
+        H_ASSERT( checkCapability( datumCapability( *it ) ), "Unknown model datum: " + *it );
+    }
+    targetOutputs = datums;
+}
+
 //------------------------------------------------------------------------------
 /*! \brief Look up component and send message in one operation without any need
  *         to send message data.
@@ -638,17 +1611,6 @@ unitval Core::sendMessage( const std::string& message,
                           const std::string& datum,
                           const message_data& info ) throw ( h_exception )
 {
-
-    std::vector<std::string> datum_split;
-    boost::split( datum_split, datum, boost::is_any_of( SNBOX_PARSECHAR ) );
-    H_ASSERT( datum_split.size() < 3, "max of one separator allowed in variable names" );
-    std::string datum_capability;
-    if ( datum_split.size() == 2 ) {
-        datum_capability = datum_split[ 1 ];
-    } else {
-        datum_capability = datum_split[ 0 ];
-    }
-
     if (message == M_GETDATA || message == M_DUMP_TO_DEEP_OCEAN) {
         // M_GETDATA is used extensively by components to query each other re state
         // M_DUMP_TO_DEEP_OCEAN is a special message used only to constrain the atmosphere
@@ -661,14 +1623,23 @@ unitval Core::sendMessage( const std::string& message,
             H_THROW("Invalid sendMessage/GETDATA.  Check global log for details.");
         }
         else {
+            unordered_map<string, IModelComponent*>::const_iterator cached = datumProviders.find( datum );
+            if( cached != datumProviders.end() )
+                return cached->second->sendMessage( message, datum, info );
+
+            string datum_capability = datumCapability( datum );
             componentMapIterator it = componentCapabilities.find( datum_capability );
 
             string err = "Unknown model datum: " + datum;
             H_ASSERT( checkCapability( datum_capability ), err );
-            return getComponentByName( ( *it ).second )->sendMessage( message, datum, info );
+            IModelComponent* provider = getComponentByName( ( *it ).second );
+            datumProviders[ datum ] = provider;
+            return provider->sendMessage( message, datum, info );
         }
     }
     else if (message == M_SETDATA ) {
+        std::string datum_capability = datumCapability( datum );
+
         // locate the components that take this kind of input.  If
         // there are multiple, we send the message to all of them.
         pair<componentMapIterator, componentMapIterator> itpr =
@@ -681,6 +1652,13 @@ unitval Core::sendMessage( const std::string& message,
         for(componentMapIterator it=itpr.first; it != itpr.second; ++it)
             getComponentByName(it->second)->sendMessage(message, datum, info);
 
+        // Once the model has been set up, keep track of how much of it the
+        // new values invalidate.
+        if(setup_complete) {
+            for(componentMapIterator it=itpr.first; it != itpr.second; ++it)
+                noteChange(it->second, datum, info.date);
+        }
+
         return info.value_unitval;
     }
     else {
@@ -709,8 +1687,8 @@ void Core::accept( AVisitor* visitor ) {
     visitor->visit( this );
 
     // forward the accept to the contained model components
-    for( NameComponentIterator it = modelComponents.begin(); it != modelComponents.end(); ++it ) {
-        ( *it ).second->accept( visitor );
+    for( ScheduleIterator it = componentSchedule.begin(); it != componentSchedule.end(); ++it ) {
+        ( *it )->accept( visitor );
     }
 }
 
@@ -728,9 +1706,14 @@ std::vector<Core *> Core::core_registry;
 
 /*! Create a core and add it to the registry
  */
-int Core::mkcore(bool logtofile, Logger::LogLevel loglvl, bool logtoscrn)
+int Core::mkcore(bool logtofile, Logger::LogLevel loglvl, bool logtoscrn, bool use_arena)
 {
-    core_registry.push_back(new Core(loglvl, logtoscrn, logtofile));
+    // Cores in the registry all log to a single shared file rather than
+    // opening one for each of their components.
+    if(logtofile && !LogSink::getSink().isOpen())
+        LogSink::getSink().open(MODEL_NAME);
+
+    core_registry.push_back(new StandardCore(loglvl, logtoscrn, logtofile, use_arena));
     return core_registry.size() - 1;
 }
 
@@ -763,6 +1746,9 @@ void Core::delcore(int idx)
         core->shutDown();
         delete core;
         core_registry[idx] = NULL;
+        // Get the core's last messages into the log file now, rather than
+        // when the process exits
+        LogSink::getSink().flush();
     }
     // If core is null, it's already been shutdown, so do nothing.
 }
@@ -785,6 +1771,7 @@ std::vector<std::string> Core::getBiomeList() const
  */
 void Core::createBiome(const std::string& biome)
 {
+    h_arena::scope arena_scope( arena );
     IModelComponent* cmodel_i = getComponentByCapability( D_VEGC );
     CarbonCycleModel* cmodel = dynamic_cast<CarbonCycleModel*>(cmodel_i);
     if (cmodel) {
@@ -794,6 +1781,22 @@ void Core::createBiome(const std::string& biome)
     }
 }
 
+/*! Create several new biomes
+ * \details As `createBiome`, for each biome in turn, but the model's
+ *  time series are restructured once for all of them.
+ */
+void Core::createBiomes(const std::vector<std::string>& biomes)
+{
+    h_arena::scope arena_scope( arena );
+    IModelComponent* cmodel_i = getComponentByCapability( D_VEGC );
+    CarbonCycleModel* cmodel = dynamic_cast<CarbonCycleModel*>(cmodel_i);
+    if (cmodel) {
+        return( cmodel->createBiomes(biomes) );
+    } else {
+        H_THROW("Failed to create biomes because of error in dynamic cast to `SimpleNbox`.")
+    }
+}
+
 /*! Delete a biome
  * \details Remove the biome from `biome_list` and `erase` all
  * associated pool and parameter values.
@@ -0,0 +1,166 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+/*
+ *  core_pool.cpp
+ *  hector
+ *
+ */
+
+#include <atomic>
+#include <exception>
+#include <thread>
+
+#include "core_pool.hpp"
+#include "composed_core.hpp"
+#include "ini_to_core_reader.hpp"
+
+namespace Hector {
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/*! \brief Constructor
+ *  \param loglvl Log level for the cores the pool creates.  They log only
+ *         to the shared log sink, if it is open.
+ */
+CorePool::CorePool( Logger::LogLevel loglvl ) : loglvl( loglvl )
+{
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Destructor
+ *  \note Cores still on loan are not deleted.
+ */
+CorePool::~CorePool()
+{
+    for( map<string, vector<Core*> >::iterator it = idle.begin(); it != idle.end(); ++it ) {
+        for( size_t i = 0; i < it->second.size(); ++i ) {
+            it->second[ i ]->shutDown();
+            delete it->second[ i ];
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Borrow a core set up from an input file
+ *
+ *  \details An idle core is returned if there is one; otherwise a new one is
+ *           created, which takes as long as reading the inputs and running
+ *           the spinup.  Other threads can use the pool meanwhile.
+ *  \param inifile The input file.
+ *  \return A core that has been prepared to run.  It belongs to the caller
+ *          until it is handed to release().
+ *  \exception h_exception If the core could not be set up.
+ */
+Core* CorePool::acquire( const string& inifile ) throw ( h_exception )
+{
+    {
+        lock_guard<std::mutex> lock( mutex );
+        vector<Core*>& cores = idle[ inifile ];
+        if( !cores.empty() ) {
+            Core* core = cores.back();
+            cores.pop_back();
+            return core;
+        }
+    }
+
+    // Each core gets its own arena, so cores in different threads don't
+    // contend for the heap.
+    Core* core = new StandardCore( loglvl, false, false, true );
+    try {
+        core->init();
+        INIToCoreReader( core ).parse( inifile );
+        core->prepareToRun();
+    }
+    catch( h_exception& e ) {
+        delete core;
+        throw;
+    }
+    return core;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Return a borrowed core
+ *  \param inifile The input file it was set up from.
+ *  \param core The core.
+ *  \param reusable If false, the core is in an unknown state (after an error,
+ *         say) and is deleted instead of being kept.
+ */
+void CorePool::release( const string& inifile, Core* core, bool reusable )
+{
+    if( !reusable ) {
+        core->shutDown();
+        delete core;
+        return;
+    }
+    lock_guard<std::mutex> lock( mutex );
+    idle[ inifile ].push_back( core );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Do units of work in parallel
+ *
+ *  \details Thread t does units t, t+threads, t+2*threads, ..., so which
+ *           thread does what does not depend on timing.  Once a unit fails,
+ *           the other threads stop at the end of their current unit.  A unit
+ *           that handles its own error can return false instead, and the
+ *           thread carries on with a fresh core.
+ *  \param inifile The input file the cores are set up from.
+ *  \param units Number of units of work.
+ *  \param threads Number of threads.
+ *  \param work Called as work( core, unit, thread ), with a core for the
+ *         thread's own use, borrowed from the pool.  Returns false if it
+ *         left the core in an unknown state.
+ *  \exception h_exception The first thread's error, if any failed.
+ */
+void CorePool::forEach( const string& inifile, int units, int threads,
+                        const function<bool( Core*, int, int )>& work ) throw ( h_exception )
+{
+    vector<exception_ptr> errors( threads );
+    atomic<bool> failed( false );
+    vector<thread> workers;
+    for( int t = 0; t < threads; ++t ) {
+        workers.push_back( thread( [&, t]() {
+            Core* core = NULL;
+            try {
+                core = acquire( inifile );
+                for( int unit = t; unit < units && !failed; unit += threads ) {
+                    if( !work( core, unit, t ) ) {
+                        Core* spent = core;
+                        core = NULL;
+                        release( inifile, spent, false );
+                        core = acquire( inifile );
+                    }
+                }
+                release( inifile, core, true );
+            }
+            catch( ... ) {
+                errors[ t ] = current_exception();
+                failed = true;
+                if( core )
+                    release( inifile, core, false );
+            }
+        } ) );
+    }
+    for( size_t t = 0; t < workers.size(); ++t )
+        workers[ t ].join();
+    for( size_t t = 0; t < errors.size(); ++t ) {
+        if( errors[ t ] )
+            rethrow_exception( errors[ t ] );
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Number of idle cores for an input file
+ */
+size_t CorePool::idleCount( const string& inifile )
+{
+    lock_guard<std::mutex> lock( mutex );
+    return idle[ inifile ].size();
+}
+
+}
@@ -130,11 +130,13 @@ void CSVOutputStreamVisitor::visit( ForcingComponent* c ) {
     if(c->currentYear < c->baseyear)
         return;
 
-    ForcingComponent::forcings_t  forcings = c->forcings_ts.get(c->currentYear);
+    const ForcingComponent::forcings_t& forcings = c->getForcings(c->currentYear);
 
-    // Walk through the forcings map, outputting everything
-    for( ForcingComponent::forcingsIterator it = forcings.begin(); it != forcings.end(); ++it ) {
-        STREAM_UNITVAL( csvFile, c, ( *it ).first, ( *it ).second );
+    // Walk through the forcings in order of name, outputting everything
+    for( std::vector<int>::const_iterator it = c->forcing_order().begin(); it != c->forcing_order().end(); ++it ) {
+        if( c->forcing_present[ *it ] ) {
+            STREAM_UNITVAL( csvFile, c, ForcingComponent::getForcingName( *it ), forcings[ *it ] );
+        }
     }
 
     csvFile.precision( oldPrecision );
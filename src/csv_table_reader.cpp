@@ -89,14 +89,8 @@ string CSVTableReader::csv_getline() {
 /*! \brief Process the CSV file looking for the given varName and route the data
  *         into the core.
  *
- *  The input stream will be reset to allow to processing multiple times from
- *  this reader.  Next the header row is read and searched to find the column
- *  which varName is contained in.  Then each row of the table is read.  Should the
- *  the first column be UNITS it will use the row to set the units string to pass
- *  along with read data to provide units checking.  Otherwise it will assume
- *  the first column is the time series index and consistent columns for each
- *  row. Each value will be routed through the core as rows are read.  Extra
- *  white space will be removed before sending the value into the core.
+ *  The column is read as described in readColumn().  Each value is then routed
+ *  through the core, together with the units label in effect for its row.
  *
  *  \param core A pointer to the model core to route data through.
  *  \param componentName The model component to set varName in.
@@ -108,6 +102,77 @@ string CSVTableReader::csv_getline() {
 
 void CSVTableReader::process( Core* core, const string& componentName,
                              const string& varName ) throw ( h_exception )
+{
+    vector<double> dates;
+    vector<string> values;
+    vector<string> units;
+    readColumn( varName, dates, values, units );
+
+    for( size_t i = 0; i < dates.size(); ++i ) {
+        message_data data( values[ i ] );
+        data.date = dates[ i ];
+        data.units_str = units[ i ];
+        core->setData( componentName, varName, data );
+    }
+    // h_exceptions from setData should just be passed along
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Read the time series in the column for varName.
+ *
+ *  Reads the column as described in readColumn() and converts the values
+ *  to numbers.
+ *
+ *  \param varName The variable name to look for in the CSV file.
+ *  \param dates The dates of the series are appended here.
+ *  \param values The values, with the units given in the table (U_UNDEFINED if
+ *                there were none), are appended here.
+ *  \exception h_exception For any I/O errors, improper formatting, unknown
+ *                         units, and inability to find varName.
+ */
+void CSVTableReader::readSeries( const string& varName, vector<double>& dates,
+                                 vector<unitval>& values ) throw ( h_exception )
+{
+    vector<double> rowDates;
+    vector<string> rowValues;
+    vector<string> rowUnits;
+    readColumn( varName, rowDates, rowValues, rowUnits );
+
+    for( size_t i = 0; i < rowDates.size(); ++i ) {
+        double value;
+        try {
+            value = boost::lexical_cast<double>( rowValues[ i ] );
+        } catch( boost::bad_lexical_cast& castException ) {
+            H_THROW( "Could not convert "+varName+" value at "+boost::lexical_cast<string>( rowDates[ i ] )
+                    +" in "+fileName+" to double: "+rowValues[ i ] );
+        }
+        const unit_types units = rowUnits[ i ].empty() ? U_UNDEFINED : unitval::parseUnitsName( rowUnits[ i ] );
+        dates.push_back( rowDates[ i ] );
+        values.push_back( unitval( value, units ) );
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Read the column for the given varName.
+ *
+ *  The input stream will be reset to allow to processing multiple times from
+ *  this reader.  Next the header row is read and searched to find the column
+ *  which varName is contained in.  Then each row of the table is read.  Should the
+ *  the first column be UNITS it will use the row to set the units string to pass
+ *  along with read data to provide units checking.  Otherwise it will assume
+ *  the first column is the time series index and consistent columns for each
+ *  row.  Extra white space is removed from the values, and blank values are
+ *  skipped.
+ *
+ *  \param varName The variable name to look for in the CSV file.
+ *  \param dates The index of each value read is appended here.
+ *  \param values The values read are appended here.
+ *  \param units The units label in effect for each value is appended here.
+ *  \exception h_exception For any I/O errors, improper formatting, and inability
+ *                         to find varName.
+ */
+void CSVTableReader::readColumn( const string& varName, vector<double>& dates,
+                                 vector<string>& values, vector<string>& units ) throw ( h_exception )
 {
     using namespace boost;
     try {
@@ -171,12 +236,10 @@ void CSVTableReader::process( Core* core, const string& componentName,
                 // the first column is assumed to be the index
                 double tseriesIndex = lexical_cast<double>( row[ 0 ] );
 
-                // route the data to the appropriate model component
                 if( !row[ columnIndex ].empty() ) {      // ignore blanks
-                    message_data data( row[ columnIndex ] );
-                    data.date = tseriesIndex;
-                    data.units_str = unitsLabel;
-                    core->setData( componentName, varName, data );
+                    dates.push_back( tseriesIndex );
+                    values.push_back( row[ columnIndex ] );
+                    units.push_back( unitsLabel );
                 }
             }
         }
@@ -188,7 +251,6 @@ void CSVTableReader::process( Core* core, const string& componentName,
         H_THROW( "Could not convert index to double on line: "+lexical_cast<string>( lineNum )+", exception: "
                 +castException.what() );
     }
-    // h_exceptions from setData should just be passed along
 }
 
 }
@@ -14,7 +14,8 @@
 
 //#include <cassert>
 #include <algorithm>
-#include <limits>
+#include <functional>
+#include <queue>
 
 #include "dependency_finder.hpp"
 #include "h_exception.hpp"
@@ -37,11 +38,11 @@ DependencyFinder::DependencyFinder() : ordcomputed(false)
  *          to aDependency.
  * \param aObjectName Name of the object which has a new dependency.
  * \param aDependency name of the item aObjectName is dependent on.
- * \return Whether the dependency was added to the matrix.
+ * \return Whether the dependency was added.
  */
 bool DependencyFinder::addDependency( const string& aObjectName,
                                      const string& aDependency ){
-    // Check if the object is already in the mapping of object name to matrix index.
+    // Check if the object is already in the mapping of object name to index.
     ObjectIndexMap::iterator objectLocation = mObjectIndices.find( aObjectName );
     if( objectLocation == mObjectIndices.end() ){
         // Update the object location iterator after the item is added.
@@ -55,16 +56,16 @@ bool DependencyFinder::addDependency( const string& aObjectName,
         dependencyLocation = addTrackedItem( aDependency );
     }
 
-    // The matrix is now set up correctly, add the dependency.
-    H_ASSERT( mDependencyMatrix.size() > objectLocation->second, "addDependency failure" );
-    H_ASSERT( mDependencyMatrix[ objectLocation->second ].size() > dependencyLocation->second, "addDependency failure" );
+    // The lists are now set up correctly, add the dependency.
+    H_ASSERT( mDependencies.size() > objectLocation->second, "addDependency failure" );
+    vector<size_t>& deps = mDependencies[ objectLocation->second ];
 
     // Check if the dependency already exists.
-    if( mDependencyMatrix[ objectLocation->second ][ dependencyLocation->second ] ){
+    if( find( deps.begin(), deps.end(), dependencyLocation->second ) != deps.end() ){
         return false;
     }
     // Add the dependency and return that it was a new dependency.
-    mDependencyMatrix[ objectLocation->second ][ dependencyLocation->second ] = true;
+    deps.push_back( dependencyLocation->second );
     return true;
 }
 
@@ -86,55 +87,49 @@ void DependencyFinder::createOrdering() throw ( h_exception ) {
     // If there is an existing stored ordering, clear it.
     mOrdering.clear();
 
-    // Create a vector which marks the objects that are cleared (not a dependent of
-    // any non-cleared objects).
-    vector<bool> cleared( mDependencyMatrix.size() );
-
-    // Search until the ordering contains all objects in the matrix. Or in other words
-    // until all objects are cleared.
-    while( mOrdering.size() < mDependencyMatrix.size() ){
-        size_t objIndexToClear = numeric_limits<size_t>::max();
-
-        // Search for an object that is not yet cleared and is not a dependent of
-        // any non-cleared object.
-        for( size_t objIndex = 0; objIndex < mDependencyMatrix.size() &&
-             objIndexToClear == numeric_limits<size_t>::max(); ++objIndex )
-        {
-            // Only search the object if it has not already been cleared.
-            if( !cleared[ objIndex ] ){
-                // Check for any dependencies.
-                bool depFound = false;
-                for( size_t depIndex = 0; depIndex < mDependencyMatrix.size() && !depFound; ++depIndex )
-                {
-                    // Check if there is a dependency at this location by and object that has
-                    // not already been cleared.
-                    if( !cleared[ depIndex ] && mDependencyMatrix[ objIndex ][ depIndex ] ){
-                        // Found a dependency on the current object so we can stop searching
-                        // and move on to the next object.
-                        depFound = true;
-                    }
-                }
-                // If we did not find a dependency on the current object so then we can now
-                // clear it then move on.
-                if( !depFound ){
-                    objIndexToClear = objIndex;
-                }
-            }
+    // Kahn's algorithm: count the dependencies of each object that haven't
+    // been cleared yet, and keep a list of the objects depending on each one.
+    const size_t numObjects = mDependencies.size();
+    vector<size_t> numDeps( numObjects );
+    vector<vector<size_t> > dependents( numObjects );
+    for( size_t objIndex = 0; objIndex < numObjects; ++objIndex ){
+        numDeps[ objIndex ] = mDependencies[ objIndex ].size();
+        for( size_t i = 0; i < mDependencies[ objIndex ].size(); ++i ){
+            dependents[ mDependencies[ objIndex ][ i ] ].push_back( objIndex );
         }
+    }
 
-        // Make sure we found an object to clear.
-        if( objIndexToClear == numeric_limits<size_t>::max() ){
-            // Since there was no object with no dependencies, this graph has
-            // a cycle.
-            H_THROW( "Could not sort dependencies; there is a cycle in the graph." );
+    // Objects ready to be cleared, lowest index first, so that among
+    // independent objects the order they were added is kept.
+    priority_queue<size_t, vector<size_t>, greater<size_t> > ready;
+    for( size_t objIndex = 0; objIndex < numObjects; ++objIndex ){
+        if( numDeps[ objIndex ] == 0 ){
+            ready.push( objIndex );
         }
-        else {
-            // Add the object found to the ordering and set it as cleared.
-            mOrdering.push_back( getNameFromIndex( objIndexToClear ) );
-            cleared[ objIndexToClear ] = true;
+    }
+
+    // Clear objects until none are left that don't depend on a non-cleared
+    // object, releasing the objects that depend on each one cleared.
+    while( !ready.empty() ){
+        const size_t objIndexToClear = ready.top();
+        ready.pop();
+        mOrdering.push_back( mObjectNames[ objIndexToClear ] );
+
+        const vector<size_t>& objDependents = dependents[ objIndexToClear ];
+        for( size_t i = 0; i < objDependents.size(); ++i ){
+            if( --numDeps[ objDependents[ i ] ] == 0 ){
+                ready.push( objDependents[ i ] );
+            }
         }
     }
 
+    // Make sure we cleared every object.
+    if( mOrdering.size() < numObjects ){
+        // The objects left over all depend on each other, so this graph
+        // has a cycle.
+        H_THROW( "Could not sort dependencies; there is a cycle in the graph." );
+    }
+
     // Sorting finished, the internal ordering can now be fetched by
     // getOrdering.
     ordcomputed = true;
@@ -156,15 +151,15 @@ const vector<string>& DependencyFinder::getOrdering() const {
 }
 
 /*!
- * \brief Remove a dependency from the matrix.
+ * \brief Remove a dependency.
  * \param aObject Object index for which to remove the dependency.
  * \param aDependency Dependency index to remove.
  */
 void DependencyFinder::removeDependency( const size_t aObject, const size_t aDependency ){
     // Remove the dependency, or edge.
-    H_ASSERT( mDependencyMatrix.size() > aObject, "removeDependency failure" );
-    H_ASSERT( mDependencyMatrix[ aObject ].size() > aDependency, "removeDependency failure" );
-    mDependencyMatrix[ aObject ][ aDependency ] = false;
+    H_ASSERT( mDependencies.size() > aObject, "removeDependency failure" );
+    vector<size_t>& deps = mDependencies[ aObject ];
+    deps.erase( remove( deps.begin(), deps.end(), aDependency ), deps.end() );
 }
 
 /*!
@@ -174,48 +169,22 @@ void DependencyFinder::removeDependency( const size_t aObject, const size_t aDep
  * \return An iterator to the location of the new item.
  */
 DependencyFinder::ObjectIndexMap::iterator DependencyFinder::addTrackedItem( const string& aItem ){
-    // Add the item to the mapping of item name to index within the matrix.
-    const size_t newLocation = mDependencyMatrix.size();
+    // Add the item to the mapping of item name to index.
+    const size_t newLocation = mDependencies.size();
 
-    // Make pair creates a name value pair to insert into the matrix.
+    // Make pair creates a name value pair to insert into the mapping.
     pair<ObjectIndexMap::iterator, bool> newPositionPair = mObjectIndices.insert( make_pair( aItem, newLocation ) );
 
     // Check the precondition that the item does not already exist.
     H_ASSERT( newPositionPair.second, "addTrackedItem failure" );
 
-    // Now add the item to the dependency matrix. Loop through the matrix and
-    // add a new position on the end of each row.
-    for( unsigned int row = 0; row < mDependencyMatrix.size(); ++row ){
-        mDependencyMatrix[ row ].push_back( false );
-    }
-
-    // Add a new row to the matrix for the item. Default to not having any
+    // Add an entry for the item, which defaults to not having any
     // dependencies.
-    mDependencyMatrix.push_back( vector<bool>( newLocation + 1, false ) );
+    mObjectNames.push_back( aItem );
+    mDependencies.push_back( vector<size_t>() );
 
     // Return an iterator to the position within the index map.
     return newPositionPair.first;
 }
 
-/*!
- * \brief Get the name of an object from the matrix index.
- * \param A matrix index to fetch the name for.
- * \note This function is slow as it performs a reverse map lookup and should not
- be used in sections of code which are called frequently.
- * \return The name of the item associated with the index, NO_NAME if it is not
- found.
- */
-const string& DependencyFinder::getNameFromIndex( const size_t aIndex ) const {
-    // Search the map linearly as this is the reverse lookup.
-    for( ObjectIndexMap::const_iterator item = mObjectIndices.begin(); item != mObjectIndices.end(); ++item ){
-        // Check if we found the index we are searching for.
-        if( item->second == aIndex ){
-            return item->first;
-        }
-    }
-    // The index does not exist.
-    const static string& NO_NAME = "NO_NAME";
-    return NO_NAME;
-}
-
 }
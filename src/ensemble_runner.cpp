@@ -0,0 +1,337 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+/*
+ *  ensemble_runner.cpp
+ *  hector
+ *
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdint.h>
+
+#include <boost/filesystem.hpp>
+
+#include "ensemble_runner.hpp"
+#include "component_data.hpp"
+#include "message_data.hpp"
+
+namespace Hector {
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/*! \brief Constructor
+ *  \param inifile The input file the members are set up from.
+ */
+EnsembleRunner::EnsembleRunner( const string& inifile ) : inifile( inifile ), chunkSize( 100 )
+{
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add a parameter that the members set
+ *  \param datum The parameter name (e.g. D_ECS).
+ *  \param units Units of the members' values.
+ *  \note All parameters must be added before the first member.
+ */
+void EnsembleRunner::addParameter( const string& datum, unit_types units )
+{
+    parameter p;
+    p.datum = datum;
+    p.units = units;
+    parameters.push_back( p );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add a member
+ *  \param values The member's parameter values, in the order the parameters
+ *         were added.
+ *  \exception h_exception If there are too few or too many values.
+ */
+void EnsembleRunner::addMember( const vector<double>& values ) throw ( h_exception )
+{
+    H_ASSERT( !parameters.empty() && values.size() == parameters.size(),
+              "need one value per parameter" );
+    members.insert( members.end(), values.begin(), values.end() );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Number of members
+ */
+size_t EnsembleRunner::size() const
+{
+    return parameters.empty() ? 0 : members.size() / parameters.size();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Set the number of members run between flushes of the outputs and
+ *         the journal
+ *  \exception h_exception If it isn't positive.
+ */
+void EnsembleRunner::setChunkSize( int members ) throw ( h_exception )
+{
+    H_ASSERT( members > 0, "chunk size must be positive" );
+    chunkSize = members;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief The first line of the journal, which identifies the ensemble
+ *
+ *  \details A journal can only be resumed by the same members in the same
+ *           chunks, so the header holds their sizes and an FNV-1a hash of the
+ *           input file name, parameters, and member values.
+ */
+string EnsembleRunner::journalHeader() const
+{
+    uint64_t hash = 14695981039346656037ULL;
+    const auto mix = [&]( const void* data, size_t len ) {
+        const unsigned char* bytes = static_cast<const unsigned char*>( data );
+        for( size_t i = 0; i < len; ++i ) {
+            hash ^= bytes[ i ];
+            hash *= 1099511628211ULL;
+        }
+    };
+    mix( inifile.data(), inifile.size() + 1 );
+    for( size_t i = 0; i < parameters.size(); ++i ) {
+        mix( parameters[ i ].datum.c_str(), parameters[ i ].datum.size() + 1 );
+        mix( &parameters[ i ].units, sizeof parameters[ i ].units );
+    }
+    if( !members.empty() )
+        mix( &members[ 0 ], members.size() * sizeof members[ 0 ] );
+
+    ostringstream header;
+    header << "hector-journal 1 " << size() << ' ' << parameters.size() << ' '
+           << chunkSize << ' ' << hex << hash;
+    return header.str();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Name of the file the summary is checkpointed to after a chunk
+ */
+string EnsembleRunner::checkpointFile( int chunk ) const
+{
+    ostringstream name;
+    name << journalFile << ".stats." << chunk;
+    return name.str();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Pick up from the journal of an earlier run
+ *
+ *  \details The journal holds a header line and then, for each chunk in
+ *           turn, a line "failed <member> <reason>" for each of its members
+ *           that failed, and a line "chunk <number> <first member> <last
+ *           member> <length of the output file, or -1>".  Lines after the
+ *           last chunk line, left by a run that died partway through a
+ *           chunk, are dropped from the file.
+ *  \param stats Replaced by the checkpoint of the last chunk, if any.
+ *  \param outputEnd Set to the output file length recorded with it.
+ *  \return The next chunk to run; 0 if there is no journal to resume.
+ *  \exception h_exception If the journal is of a different ensemble, is
+ *              malformed, or its checkpoint is missing.
+ */
+int EnsembleRunner::resume( EnsembleStats& stats, long& outputEnd ) throw ( h_exception )
+{
+    outputEnd = -1;
+    ifstream in( journalFile.c_str() );
+    string line;
+    if( !getline( in, line ) || in.eof() )
+        return 0;
+    H_ASSERT( line == journalHeader(), "journal " + journalFile + " is of a different ensemble" );
+
+    int next = 0;
+    streamoff good = in.tellg();
+    vector<failure> pending;
+    while( getline( in, line ) && !in.eof() ) {
+        istringstream fields( line );
+        string tag;
+        fields >> tag;
+        if( tag == "failed" ) {
+            failure f;
+            fields >> f.member;
+            H_ASSERT( !fields.fail(), "malformed journal " + journalFile );
+            fields.get();
+            getline( fields, f.reason );
+            pending.push_back( f );
+            continue;
+        }
+        int chunk;
+        size_t first, last;
+        long end;
+        fields >> chunk >> first >> last >> end;
+        H_ASSERT( !fields.fail() && tag == "chunk" && chunk == next,
+                  "malformed journal " + journalFile );
+        failures.insert( failures.end(), pending.begin(), pending.end() );
+        pending.clear();
+        outputEnd = end;
+        good = in.tellg();
+        ++next;
+    }
+    in.close();
+    if( next == 0 )
+        return 0;
+    boost::filesystem::resize_file( journalFile, good );
+
+    ifstream checkpoint( checkpointFile( next - 1 ).c_str() );
+    H_ASSERT( checkpoint.is_open(), "missing checkpoint " + checkpointFile( next - 1 ) );
+    stats.read( checkpoint );
+    return next;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Run the members and summarize their outputs
+ *
+ *  \details The summaries of the members are merged into stats, which may
+ *           already hold other members; but if the run resumes from a
+ *           journal, stats is replaced by the journal's last checkpoint.  If
+ *           an output file is set, each member's outputs are written to it
+ *           as rows of member (counting from 0), variable, year, and value.
+ *           Results are reproducible for a given number of threads and chunk
+ *           size, whether or not the run was interrupted.  Members that fail
+ *           are skipped and listed by getFailures().
+ *  \param stats The summary, which names the outputs and dates.
+ *  \param threads Number of threads to run the model in.
+ *  \exception h_exception If a core can't be set up or a file can't be
+ *              written.  stats then holds the chunks finished before the
+ *              failure.
+ */
+void EnsembleRunner::run( EnsembleStats& stats, int threads ) throw ( h_exception )
+{
+    H_ASSERT( threads > 0, "threads must be positive" );
+    H_ASSERT( !stats.getDates().empty(), "no dates to summarize" );
+    const size_t k = parameters.size();
+    const vector<string>& outputs = stats.getOutputs();
+    const vector<double>& dates = stats.getDates();
+    const size_t m = outputs.size() * dates.size();
+    const double end = *max_element( dates.begin(), dates.end() );
+    const size_t n = size();
+    const int chunks = int( ( n + chunkSize - 1 ) / chunkSize );
+
+    failures.clear();
+    long outputEnd = -1;
+    int chunk = journalFile.empty() ? 0 : resume( stats, outputEnd );
+
+    ofstream journal;
+    if( !journalFile.empty() ) {
+        if( chunk == 0 ) {
+            journal.open( journalFile.c_str(), ios::trunc );
+            journal << journalHeader() << '\n';
+        }
+        else
+            journal.open( journalFile.c_str(), ios::app );
+        journal.flush();
+        H_ASSERT( journal.good(), "couldn't write journal " + journalFile );
+    }
+
+    ofstream output;
+    if( !outputFile.empty() ) {
+        if( chunk == 0 ) {
+            output.open( outputFile.c_str(), ios::trunc );
+            output << "member,variable,year,value\n";
+        }
+        else {
+            H_ASSERT( outputEnd >= 0, "journal " + journalFile + " was written without an output file" );
+            H_ASSERT( boost::filesystem::exists( outputFile ) &&
+                      boost::filesystem::file_size( outputFile ) >= uintmax_t( outputEnd ),
+                      "output file " + outputFile + " is shorter than its journal says" );
+            // Drop the rows of a chunk that was under way
+            boost::filesystem::resize_file( outputFile, outputEnd );
+            output.open( outputFile.c_str(), ios::app );
+        }
+        output.precision( numeric_limits<double>::max_digits10 );
+        H_ASSERT( output.good(), "couldn't write output file " + outputFile );
+    }
+
+    EnsembleStats empty( stats );
+    empty.clear();
+    vector<double> values;
+
+    for( ; chunk < chunks; ++chunk ) {
+        const size_t first = size_t( chunk ) * chunkSize;
+        const int count = int( min( n - first, size_t( chunkSize ) ) );
+        vector<EnsembleStats> partial( threads, empty );
+        if( output.is_open() )
+            values.assign( count * m, 0.0 );
+        vector<char> failed( count, false );
+        vector<string> reasons( count );
+
+        pool.forEach( inifile, count, threads, [&]( Core* core, int i, int t ) {
+            const size_t member = first + i;
+            vector<double> v;
+            try {
+                for( size_t j = 0; j < k; ++j ) {
+                    core->sendMessage( M_SETDATA, parameters[ j ].datum,
+                                       message_data( unitval( members[ member * k + j ], parameters[ j ].units ) ) );
+                }
+                if( core->changesPending() )
+                    core->applyChanges();
+                if( core->getCurrentDate() < end )
+                    core->run( end );
+                partial[ t ].fetch( core, v );
+            }
+            catch( h_exception& e ) {
+                // The core may be partway through a change; don't reuse it.
+                // The reason goes on one journal line.
+                failed[ i ] = true;
+                reasons[ i ] = e.what();
+                replace( reasons[ i ].begin(), reasons[ i ].end(), '\n', ' ' );
+                return false;
+            }
+            partial[ t ].add( v );
+            if( output.is_open() )
+                copy( v.begin(), v.end(), values.begin() + i * m );
+            return true;
+        } );
+
+        for( int t = 0; t < threads; ++t )
+            stats.merge( partial[ t ] );
+        const size_t chunkFailures = failures.size();
+        for( int i = 0; i < count; ++i ) {
+            if( failed[ i ] ) {
+                failure f = { first + i, reasons[ i ] };
+                failures.push_back( f );
+            }
+        }
+
+        if( output.is_open() ) {
+            for( int i = 0; i < count; ++i ) {
+                if( failed[ i ] )
+                    continue;
+                for( size_t o = 0; o < outputs.size(); ++o ) {
+                    for( size_t d = 0; d < dates.size(); ++d ) {
+                        output << first + i << ',' << outputs[ o ] << ',' << dates[ d ] << ','
+                               << values[ i * m + o * dates.size() + d ] << '\n';
+                    }
+                }
+            }
+            output.flush();
+            H_ASSERT( output.good(), "couldn't write output file " + outputFile );
+            outputEnd = long( output.tellp() );
+        }
+
+        if( journal.is_open() ) {
+            // The checkpoint is complete before the journal points to it
+            ofstream checkpoint( checkpointFile( chunk ).c_str(), ios::trunc );
+            stats.write( checkpoint );
+            checkpoint.close();
+            H_ASSERT( !checkpoint.fail(), "couldn't write checkpoint " + checkpointFile( chunk ) );
+            for( size_t f = chunkFailures; f < failures.size(); ++f )
+                journal << "failed " << failures[ f ].member << ' ' << failures[ f ].reason << '\n';
+            journal << "chunk " << chunk << ' ' << first << ' ' << first + count - 1 << ' '
+                    << outputEnd << '\n';
+            journal.flush();
+            H_ASSERT( journal.good(), "couldn't write journal " + journalFile );
+            if( chunk > 0 )
+                remove( checkpointFile( chunk - 1 ).c_str() );
+        }
+    }
+}
+
+}
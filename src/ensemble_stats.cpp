@@ -0,0 +1,277 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+/*
+ *  ensemble_stats.cpp
+ *  hector
+ *
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "ensemble_stats.hpp"
+#include "component_data.hpp"
+#include "message_data.hpp"
+
+namespace Hector {
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/*! \brief Constructor
+ *  \param outputs The output names (e.g. D_GLOBAL_TEMP).
+ *  \param dates The dates to summarize them at.
+ *  \param compression Compression of the quantile sketches.
+ */
+EnsembleStats::EnsembleStats( const vector<string>& outputs, const vector<double>& dates,
+                              double compression )
+: outputs( outputs ), dates( dates ), compression( compression ),
+  thresholds( outputs.size() ), members( 0.0 ),
+  summaries( outputs.size() * dates.size(), summary( compression ) )
+{
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Count members above a threshold
+ *  \param datum The output.
+ *  \param threshold The threshold, in the output's units.
+ *  \exception h_exception If there is no such output or members have already
+ *              been added.
+ */
+void EnsembleStats::addThreshold( const string& datum, double threshold ) throw ( h_exception )
+{
+    H_ASSERT( members == 0.0, "thresholds must be added before any members" );
+    const size_t o = find( outputs.begin(), outputs.end(), datum ) - outputs.begin();
+    H_ASSERT( o < outputs.size(), "no output " + datum + " to add a threshold to" );
+    thresholds[ o ].push_back( threshold );
+    for( size_t d = 0; d < dates.size(); ++d )
+        summaries[ o * dates.size() + d ].exceed.push_back( 0.0 );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add the outputs of a member that has been run
+ *  \param core The member's core, run at least to the last date.
+ *  \exception h_exception If an output can't be read.
+ */
+void EnsembleStats::add( Core* core ) throw ( h_exception )
+{
+    vector<double> values;
+    fetch( core, values );
+    add( values );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Read the summarized outputs of a member that has been run
+ *  \param core The member's core, run at least to the last date.
+ *  \param values The outputs, [ output * dates + date ], are written here.
+ *  \exception h_exception If an output can't be read.
+ */
+void EnsembleStats::fetch( Core* core, vector<double>& values ) const throw ( h_exception )
+{
+    values.resize( summaries.size() );
+    for( size_t o = 0; o < outputs.size(); ++o ) {
+        for( size_t d = 0; d < dates.size(); ++d ) {
+            const unitval v = core->sendMessage( M_GETDATA, outputs[ o ], message_data( dates[ d ] ) );
+            values[ o * dates.size() + d ] = v.value( v.units() );
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add the outputs of a member
+ *  \param values The outputs, [ output * dates + date ].
+ *  \exception h_exception If there are too few or too many values.
+ */
+void EnsembleStats::add( const vector<double>& values ) throw ( h_exception )
+{
+    H_ASSERT( values.size() == summaries.size(), "need one value per output and date" );
+    members += 1.0;
+    for( size_t i = 0; i < summaries.size(); ++i ) {
+        summary& s = summaries[ i ];
+        const double x = values[ i ];
+        const double delta = x - s.mean;
+        s.mean += delta / members;
+        s.m2 += delta * ( x - s.mean );
+        s.sketch.add( x );
+        const vector<double>& thr = thresholds[ i / dates.size() ];
+        for( size_t j = 0; j < thr.size(); ++j ) {
+            if( x > thr[ j ] )
+                s.exceed[ j ] += 1.0;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add the members summarized by another summary
+ *  \param other A summary of the same outputs, dates, and thresholds.
+ *  \exception h_exception If the summaries don't match.
+ */
+void EnsembleStats::merge( const EnsembleStats& other ) throw ( h_exception )
+{
+    H_ASSERT( outputs == other.outputs && dates == other.dates && thresholds == other.thresholds,
+              "can only merge summaries of the same outputs, dates, and thresholds" );
+    if( other.members == 0.0 )
+        return;
+    const double n = members + other.members;
+    for( size_t i = 0; i < summaries.size(); ++i ) {
+        summary& s = summaries[ i ];
+        const summary& t = other.summaries[ i ];
+        // Chan et al.'s pairwise update
+        const double delta = t.mean - s.mean;
+        s.mean += delta * other.members / n;
+        s.m2 += t.m2 + delta * delta * members * other.members / n;
+        s.sketch.merge( t.sketch );
+        for( size_t j = 0; j < s.exceed.size(); ++j )
+            s.exceed[ j ] += t.exceed[ j ];
+    }
+    members = n;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Forget all members, keeping the outputs, dates, and thresholds
+ */
+void EnsembleStats::clear()
+{
+    members = 0.0;
+    for( size_t i = 0; i < summaries.size(); ++i ) {
+        summary& s = summaries[ i ];
+        s.mean = s.m2 = 0.0;
+        s.sketch = QuantileSketch( compression );
+        fill( s.exceed.begin(), s.exceed.end(), 0.0 );
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief The summary of an output at a date
+ */
+const EnsembleStats::summary& EnsembleStats::get( size_t output, size_t date ) const
+{
+    H_ASSERT( output < outputs.size() && date < dates.size(), "no such output or date" );
+    return summaries[ output * dates.size() + date ];
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Mean over the members
+ *  \param output Output number, in the order given to the constructor.
+ *  \param date Date number, in the order given to the constructor.
+ */
+double EnsembleStats::getMean( size_t output, size_t date ) const
+{
+    return members > 0.0 ? get( output, date ).mean : numeric_limits<double>::quiet_NaN();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Sample variance over the members
+ *  \param output Output number, in the order given to the constructor.
+ *  \param date Date number, in the order given to the constructor.
+ */
+double EnsembleStats::getVariance( size_t output, size_t date ) const
+{
+    return members > 1.0 ? get( output, date ).m2 / ( members - 1.0 ) :
+        numeric_limits<double>::quiet_NaN();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Estimated quantile over the members
+ *  \param output Output number, in the order given to the constructor.
+ *  \param date Date number, in the order given to the constructor.
+ *  \param q The probability.
+ */
+double EnsembleStats::getQuantile( size_t output, size_t date, double q ) const
+{
+    return get( output, date ).sketch.quantile( q );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Fraction of members above a threshold
+ *  \param output Output number, in the order given to the constructor.
+ *  \param date Date number, in the order given to the constructor.
+ *  \param threshold Threshold number, in the order they were added for the
+ *         output.
+ */
+double EnsembleStats::getExceedance( size_t output, size_t date, size_t threshold ) const
+{
+    const summary& s = get( output, date );
+    H_ASSERT( threshold < s.exceed.size(), "no such threshold" );
+    return members > 0.0 ? s.exceed[ threshold ] / members : numeric_limits<double>::quiet_NaN();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Write the summary, as text that read() accepts
+ *
+ *  \details Values are written with enough digits to be read back exactly.
+ */
+void EnsembleStats::write( ostream& out ) const
+{
+    const streamsize precision = out.precision( numeric_limits<double>::max_digits10 );
+    out << "hector-ensemble-stats 1\n"
+        << outputs.size() << ' ' << dates.size() << ' ' << members << '\n';
+    for( size_t o = 0; o < outputs.size(); ++o ) {
+        out << outputs[ o ] << ' ' << thresholds[ o ].size();
+        for( size_t j = 0; j < thresholds[ o ].size(); ++j )
+            out << ' ' << thresholds[ o ][ j ];
+        out << '\n';
+    }
+    for( size_t d = 0; d < dates.size(); ++d )
+        out << dates[ d ] << ( d + 1 < dates.size() ? ' ' : '\n' );
+    for( size_t i = 0; i < summaries.size(); ++i ) {
+        const summary& s = summaries[ i ];
+        out << s.mean << ' ' << s.m2;
+        for( size_t j = 0; j < s.exceed.size(); ++j )
+            out << ' ' << s.exceed[ j ];
+        out << '\n';
+        s.sketch.write( out );
+    }
+    out.precision( precision );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Replace the summary with one written by write()
+ *  \exception h_exception If the input is malformed or summarizes different
+ *              outputs, dates, or thresholds.
+ */
+void EnsembleStats::read( istream& in ) throw ( h_exception )
+{
+    string magic;
+    int version;
+    size_t nout, ndate;
+    double n;
+    in >> magic >> version >> nout >> ndate >> n;
+    H_ASSERT( !in.fail() && magic == "hector-ensemble-stats" && version == 1,
+              "not an ensemble summary" );
+    H_ASSERT( nout == outputs.size() && ndate == dates.size(),
+              "ensemble summary is of different outputs or dates" );
+    for( size_t o = 0; o < nout; ++o ) {
+        string name;
+        size_t nthr;
+        in >> name >> nthr;
+        vector<double> thr( nthr );
+        for( size_t j = 0; j < nthr; ++j )
+            in >> thr[ j ];
+        H_ASSERT( !in.fail() && name == outputs[ o ] && thr == thresholds[ o ],
+                  "ensemble summary is of different outputs or thresholds" );
+    }
+    for( size_t d = 0; d < ndate; ++d ) {
+        double date;
+        in >> date;
+        H_ASSERT( !in.fail() && date == dates[ d ], "ensemble summary is of different dates" );
+    }
+    // Read into a copy, so a malformed summary leaves this one as it was
+    vector<summary> values( summaries );
+    for( size_t i = 0; i < values.size(); ++i ) {
+        summary& s = values[ i ];
+        in >> s.mean >> s.m2;
+        for( size_t j = 0; j < s.exceed.size(); ++j )
+            in >> s.exceed[ j ];
+        H_ASSERT( !in.fail(), "malformed ensemble summary" );
+        s.sketch.read( in );
+    }
+    summaries.swap( values );
+    members = n;
+}
+
+}
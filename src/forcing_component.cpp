@@ -12,8 +12,9 @@
  *
  */
 
-#include <boost/array.hpp>
+#include <algorithm>
 #include <math.h>
+#include <sstream>
 
 #include "forcing_component.hpp"
 #include "halocarbon_component.hpp"
@@ -101,10 +102,60 @@ const char *ForcingComponent::halo_forcing_names[N_HALO_FORCINGS] = {
     D_RF_CH3Br
 };
 
-std::map<std::string, std::string> ForcingComponent::forcing_name_map;
+const char *ForcingComponent::forcing_names[F_HALO] = {
+    D_RF_TOTAL,
+    D_RF_CO2,
+    D_RF_T_ALBEDO,
+    D_RF_CH4,
+    D_RF_N2O,
+    D_RF_H2O_STRAT,
+    D_RF_O3_TROP,
+    D_RF_BC,
+    D_RF_OC,
+    D_RF_SO2d,
+    D_RF_SO2i,
+    D_RF_VOL
+};
 
 using namespace std;
 
+//------------------------------------------------------------------------------
+/*! \brief Map from forcing names to forcing agents
+ *
+ *  The tables are built the first time they are needed and never change, so
+ *  cores in different threads can share them.
+ */
+const map<string, int>& ForcingComponent::forcing_index() {
+    static const map<string, int> index = [] {
+        map<string, int> m;
+        for(int i=0; i<N_HALO_FORCINGS; ++i)
+            m[adjusted_halo_forcings[i]] = F_HALO + i;
+        for(int i=0; i<N_FORCINGS; ++i)
+            m[getForcingName(i)] = i;
+        return m;
+    }();
+    return index;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Forcing agents in order of name
+ *
+ *  The total has always been summed (and the forcings written out) in this
+ *  order, so keep it.
+ */
+const vector<int>& ForcingComponent::forcing_order() {
+    static const vector<int> order = [] {
+        vector<int> v;
+        for(int i=0; i<N_FORCINGS; ++i)
+            v.push_back(i);
+        sort(v.begin(), v.end(), [](int lhs, int rhs) {
+            return string(getForcingName(lhs)) < string(getForcingName(rhs));
+        });
+        return v;
+    }();
+    return order;
+}
+
 //------------------------------------------------------------------------------
 /*! \brief Constructor
  */
@@ -128,7 +179,7 @@ string ForcingComponent::getComponentName() const {
 // documentation is inherited
 void ForcingComponent::init( Core* coreptr ) {
 
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
 
     core = coreptr;
@@ -155,7 +206,6 @@ void ForcingComponent::init( Core* coreptr ) {
     core->registerCapability( D_RF_VOL, getComponentName());
     for(int i=0; i<N_HALO_FORCINGS; ++i) {
         core->registerCapability(adjusted_halo_forcings[i], getComponentName());
-        forcing_name_map[adjusted_halo_forcings[i]] = halo_forcing_names[i];
     }
 
     // Register our dependencies
@@ -260,8 +310,29 @@ void ForcingComponent::prepareToRun() throw ( h_exception ) {
         Logger& glog = core->getGlobalLogger();
         H_LOG( glog, Logger::WARNING ) << "Total forcing will be overwritten by user-supplied values!" << std::endl;
     }
-
-    baseyear_forcings.clear();
+    Ftot_constrain.share();
+
+    // Which agents we can compute depends on which components are enabled,
+    // and that is settled by now.
+    forcing_present.assign( false );
+    forcing_present[ F_TOTAL ] = true;
+    forcing_present[ F_CO2 ] = true;
+    forcing_present[ F_T_ALBEDO ] = core->checkCapability( D_RF_T_ALBEDO );
+    forcing_present[ F_CH4 ] = forcing_present[ F_N2O ] = forcing_present[ F_H2O_STRAT ] =
+        core->checkCapability( D_ATMOSPHERIC_CH4 ) && core->checkCapability( D_ATMOSPHERIC_N2O );
+    forcing_present[ F_O3_TROP ] = core->checkCapability( D_ATMOSPHERIC_O3 );
+    forcing_present[ F_BC ] = core->checkCapability( D_EMISSIONS_BC );
+    forcing_present[ F_OC ] = core->checkCapability( D_EMISSIONS_OC );
+    forcing_present[ F_SO2D ] = forcing_present[ F_SO2I ] =
+        core->checkCapability( D_NATURAL_SO2 ) && core->checkCapability( D_EMISSIONS_SO2 );
+    forcing_present[ F_VOL ] = core->checkCapability( D_VOLCANIC_SO2 );
+    // Halocarbons can be disabled individually via the input file
+    for( int i=0; i<N_HALO_FORCINGS; ++i )
+        forcing_present[ F_HALO+i ] = core->checkCapability( halo_forcing_names[i] );
+
+    baseyear_forcings.assign( unitval() );
+    if( core->getEndDate() >= baseyear )
+        forcings_ts.reserve( size_t( core->getEndDate() - baseyear ) + 1 );
 }
 
 //------------------------------------------------------------------------------
@@ -277,7 +348,15 @@ void ForcingComponent::run( const double runToDate ) throw ( h_exception ) {
     if( runToDate < baseyear ) {
         H_LOG( logger, Logger::DEBUG ) << "not yet at baseyear" << std::endl;
     } else {
-        forcings_t forcings;
+        // Compute this year's forcings in place in the stored time series
+        size_t yearIndex = size_t( runToDate - baseyear );
+        if( yearIndex >= forcings_ts.size() )
+            forcings_ts.resize( yearIndex+1 );
+        forcings_t& forcings = forcings_ts[ yearIndex ];
+
+        // The base year may fall between time steps, in which case the
+        // first time step after it serves.
+        const bool at_baseyear = runToDate - core->getTimeStep() < baseyear;
 
         // ---------- CO2 ----------
         // Instantaneous radiative forcings for CO2, CH4, and N2O from http://www.esrl.noaa.gov/gmd/aggi/
@@ -285,18 +364,18 @@ void ForcingComponent::run( const double runToDate ) throw ( h_exception ) {
 
         // This is identical to that of MAGICC; see Meinshausen et al. (2011)
         unitval Ca = core->sendMessage( M_GETDATA, D_ATMOSPHERIC_CO2 );
-        if( runToDate==baseyear )
+        if( at_baseyear )
             C0 = Ca;
-        forcings[D_RF_CO2 ].set( 5.35 * log( Ca/C0 ), U_W_M2 );
+        forcings[ F_CO2 ].set( 5.35 * log( Ca/C0 ), U_W_M2 );
 
         // ---------- Terrestrial albedo ----------
-        if( core->checkCapability( D_RF_T_ALBEDO ) ) {
-            forcings[ D_RF_T_ALBEDO ] = core->sendMessage( M_GETDATA, D_RF_T_ALBEDO, message_data( runToDate ) );
+        if( forcing_present[ F_T_ALBEDO ] ) {
+            forcings[ F_T_ALBEDO ] = core->sendMessage( M_GETDATA, D_RF_T_ALBEDO, message_data( runToDate ) );
         }
 
         // ---------- N2O and CH4 ----------
         // Equations from Joos et al., 2001
-        if( core->checkCapability( D_ATMOSPHERIC_CH4 ) && core->checkCapability( D_ATMOSPHERIC_N2O ) ) {
+        if( forcing_present[ F_CH4 ] ) {
 
 #define f(M,N) 0.47 * log( 1 + 2.01 * 1e-5 * pow( M * N, 0.75 ) + 5.31 * 1e-15 * M * pow( M * N, 1.52 ) )
             double Ma = core->sendMessage( M_GETDATA, D_ATMOSPHERIC_CH4, message_data( runToDate ) ).value( U_PPBV_CH4 );
@@ -305,83 +384,50 @@ void ForcingComponent::run( const double runToDate ) throw ( h_exception ) {
             double N0 = core->sendMessage( M_GETDATA, D_PREINDUSTRIAL_N2O ).value( U_PPBV_N2O );
 
             double fch4 =  0.036 * ( sqrt( Ma ) - sqrt( M0 ) ) - ( f( Ma, N0 ) - f( M0, N0 ) );
-            forcings[D_RF_CH4].set( fch4, U_W_M2 );
+            forcings[ F_CH4 ].set( fch4, U_W_M2 );
 
             double fn2o =  0.12 * ( sqrt( Na ) - sqrt( N0 ) ) - ( f( M0, Na ) - f( M0, N0 ) );
-            forcings[D_RF_N2O].set( fn2o, U_W_M2 );
+            forcings[ F_N2O ].set( fn2o, U_W_M2 );
 
             // ---------- Stratospheric H2O from CH4 oxidation ----------
             // From Tanaka et al, 2007, but using Joos et al., 2001 value of 0.05
             const double fh2o = 0.05 * ( 0.036 * ( sqrt( Ma ) - sqrt( M0 ) ) );
-            forcings[D_RF_H2O_STRAT].set( fh2o, U_W_M2 );
+            forcings[ F_H2O_STRAT ].set( fh2o, U_W_M2 );
         }
 
         // ---------- Troposheric Ozone ----------
-        if( core->checkCapability( D_ATMOSPHERIC_O3 ) ) {
+        if( forcing_present[ F_O3_TROP ] ) {
             //from Tanaka et al, 2007
             const double ozone = core->sendMessage( M_GETDATA, D_ATMOSPHERIC_O3, message_data( runToDate ) ).value( U_DU_O3 );
             const double fo3 = 0.042 * ozone;
-            forcings[D_RF_O3_TROP].set( fo3, U_W_M2 );
+            forcings[ F_O3_TROP ].set( fo3, U_W_M2 );
         }
 
         // ---------- Halocarbons ----------
-        // TODO: Would like to just 'know' all the halocarbon instances out there
-        boost::array<string, 26> halos = {
-            {
-                D_RF_CF4,
-                D_RF_C2F6,
-                D_RF_HFC23,
-                D_RF_HFC32,
-                D_RF_HFC4310,
-                D_RF_HFC125,
-                D_RF_HFC134a,
-                D_RF_HFC143a,
-                D_RF_HFC227ea,
-                D_RF_HFC245fa,
-                D_RF_SF6,
-                D_RF_CFC11,
-                D_RF_CFC12,
-                D_RF_CFC113,
-                D_RF_CFC114,
-                D_RF_CFC115,
-                D_RF_CCl4,
-                D_RF_CH3CCl3,
-                D_RF_HCFC22,
-                D_RF_HCFC141b,
-                D_RF_HCFC142b,
-                D_RF_halon1211,
-                D_RF_halon1301,
-                D_RF_halon2402,
-                D_RF_CH3Cl,
-                D_RF_CH3Br
-            }
-        };
-
-        // Halocarbons can be disabled individually via the input file, so we run through all possible ones
-         for (unsigned hc=0; hc<halos.size(); ++hc) {
-            if( core->checkCapability( halos[hc] ) ) {
+        for( int hc=0; hc<N_HALO_FORCINGS; ++hc ) {
+            if( forcing_present[ F_HALO+hc ] ) {
                 // Forcing values are actually computed by the halocarbon itself
-                forcings[ halos[hc] ] = core->sendMessage( M_GETDATA, halos[hc], message_data( runToDate ) );
-                }
+                forcings[ F_HALO+hc ] = core->sendMessage( M_GETDATA, halo_forcing_names[hc], message_data( runToDate ) );
+            }
         }
 
         // ---------- Black carbon ----------
-        if( core->checkCapability( D_EMISSIONS_BC ) ) {
+        if( forcing_present[ F_BC ] ) {
             double fbc = 0.0743 * core->sendMessage( M_GETDATA, D_EMISSIONS_BC, message_data( runToDate ) ).value( U_TG );
-            forcings[D_RF_BC].set( fbc, U_W_M2 );
+            forcings[ F_BC ].set( fbc, U_W_M2 );
             // includes both indirect and direct forcings from Bond et al 2013, Journal of Geophysical Research Atmo (table C1 - Central)
         }
 
         // ---------- Organic carbon ----------
-        if( core->checkCapability( D_EMISSIONS_OC ) ) {
+        if( forcing_present[ F_OC ] ) {
             double foc = -0.0128 * core->sendMessage( M_GETDATA, D_EMISSIONS_OC, message_data( runToDate ) ).value( U_TG );
-            forcings[D_RF_OC].set( foc, U_W_M2 );
+            forcings[ F_OC ].set( foc, U_W_M2 );
             // includes both indirect and direct forcings from Bond et al 2013, Journal of Geophysical Research Atmo (table C1 - Central).
             // The fossil fuel and biomass are weighted (-4.5) then added to the snow and clouds for a total of -12.8 (personal communication Steve Smith, PNNL)
         }
 
         // ---------- Sulphate Aerosols ----------
-        if( core->checkCapability( D_NATURAL_SO2 ) && core->checkCapability( D_EMISSIONS_SO2 ) ) {
+        if( forcing_present[ F_SO2D ] ) {
 
             unitval S0 = core->sendMessage( M_GETDATA, D_2000_SO2 );
             unitval SN = core->sendMessage( M_GETDATA, D_NATURAL_SO2 );
@@ -391,55 +437,73 @@ void ForcingComponent::run( const double runToDate ) throw ( h_exception ) {
             H_ASSERT( S0.value( U_GG_S ) >0, "S0 is 0" );
             unitval emission = core->sendMessage( M_GETDATA, D_EMISSIONS_SO2, message_data( runToDate ) );
             double fso2d = -0.35 * emission/S0;
-            forcings[D_RF_SO2d].set( fso2d, U_W_M2 );
+            forcings[ F_SO2D ].set( fso2d, U_W_M2 );
             // includes only direct forcings from Forster etal 2007 (IPCC)
 
             // Indirect aerosol effect via changes in cloud properties
             const double a = -0.6 * ( log( ( SN.value( U_GG_S ) + emission.value( U_GG_S ) ) / SN.value( U_GG_S ) ) ); // -.6
             const double b =  pow ( log ( ( SN.value( U_GG_S ) + S0.value( U_GG_S ) ) / SN.value( U_GG_S ) ), -1 );
             double fso2i = a * b;
-            forcings[D_RF_SO2i].set( fso2i, U_W_M2 );
+            forcings[ F_SO2I ].set( fso2i, U_W_M2 );
         }
 
-        if( core->checkCapability( D_VOLCANIC_SO2 ) ) {
+        if( forcing_present[ F_VOL ] ) {
             // Volcanic forcings
-            forcings[D_RF_VOL] = core->sendMessage( M_GETDATA, D_VOLCANIC_SO2, message_data( runToDate ) );
+            forcings[ F_VOL ] = core->sendMessage( M_GETDATA, D_VOLCANIC_SO2, message_data( runToDate ) );
         }
 
         // ---------- Total ----------
         unitval Ftot( 0.0, U_W_M2 );  // W/m2
-        for( forcingsIterator it = forcings.begin(); it != forcings.end(); ++it ) {
-            Ftot = Ftot + ( *it ).second;
-            H_LOG( logger, Logger::DEBUG ) << "forcing " << ( *it).first << " in " << runToDate << " is " << ( *it ).second << std::endl;
+        for( vector<int>::const_iterator it = forcing_order().begin(); it != forcing_order().end(); ++it ) {
+            if( *it == F_TOTAL || !forcing_present[ *it ] )
+                continue;
+            Ftot = Ftot + forcings[ *it ];
+            H_LOG( logger, Logger::DEBUG ) << "forcing " << getForcingName( *it ) << " in " << runToDate << " is " << forcings[ *it ] << std::endl;
         }
 
         // If the user has supplied total forcing data, use that
         if( Ftot_constrain.size() && runToDate <= Ftot_constrain.lastdate() ) {
             H_LOG( logger, Logger::WARNING ) << "** Overwriting total forcing with user-supplied value" << std::endl;
-            forcings[ D_RF_TOTAL ] = Ftot_constrain.get( runToDate );
+            forcings[ F_TOTAL ] = Ftot_constrain.get( runToDate );
         } else {
-            forcings[ D_RF_TOTAL ] = Ftot;
+            forcings[ F_TOTAL ] = Ftot;
         }
-        H_LOG( logger, Logger::DEBUG ) << "forcing total is " << forcings[ D_RF_TOTAL ] << std::endl;
+        H_LOG( logger, Logger::DEBUG ) << "forcing total is " << forcings[ F_TOTAL ] << std::endl;
 
         //---------- Change to relative forcing ----------
         // Note that the code below assumes model is always consistently run from base-year forward.
         // Results will not be consistent if parameters are changed but base-year is not re-run.
 
        // At this point, we've computed all absolute forcings. If base year, save those values
-        if( runToDate==baseyear ) {
+        if( at_baseyear ) {
             H_LOG( logger, Logger::DEBUG ) << "** At base year! Storing current forcing values" << std::endl;
             baseyear_forcings = forcings;
         }
 
         // Subtract base year forcing values from forcings, i.e. make them relative to base year
-        for( forcingsIterator it = forcings.begin(); it != forcings.end(); ++it ) {
-            forcings[ ( *it ).first ] = ( *it ).second - baseyear_forcings[ ( *it ).first ];
+        for( int i=0; i<N_FORCINGS; ++i ) {
+            if( forcing_present[ i ] )
+                forcings[ i ] = forcings[ i ] - baseyear_forcings[ i ];
         }
+    }
+}
 
-        // Store the forcings that we have calculated
-        forcings_ts.set(runToDate, forcings);
+//------------------------------------------------------------------------------
+/*! \brief Get the stored forcings for a year
+ *  \param date The year, which must be no earlier than the base year and
+ *         must fall on a time step.
+ *  \exception h_exception If the forcings for that year haven't been computed.
+ */
+const ForcingComponent::forcings_t& ForcingComponent::getForcings( double date ) const throw ( h_exception ) {
+    // Years between time steps have slots in the series, but nothing in them
+    H_ASSERT( core->isStepDate( round( date ) ), "Date is not a model time step" );
+    double yearIndex = round( date - baseyear );
+    if( yearIndex < 0 || yearIndex >= forcings_ts.size() ) {
+        std::ostringstream errmsg;
+        errmsg << "No data at requested time= " << round( date ) << "\n";
+        H_THROW( errmsg.str() );
     }
+    return forcings_ts[ size_t( yearIndex ) ];
 }
 
 //------------------------------------------------------------------------------
@@ -468,40 +532,21 @@ unitval ForcingComponent::getData( const std::string& varName,
                                  << baseyear
                                  << std::endl;
 
-    forcings_t forcings(forcings_ts.get(getdate));
+    const forcings_t& forcings = getForcings( getdate );
 
     if( varName == D_RF_BASEYEAR ) {
         returnval.set( baseyear, U_UNITLESS );
     } else if (varName == D_RF_SO2) {
         // total SO2 forcing
-        std::map<std::string, unitval>::const_iterator forcing_SO2d = forcings.find( D_RF_SO2d );
-        std::map<std::string, unitval>::const_iterator forcing_SO2i = forcings.find( D_RF_SO2i );
-        if ( forcing_SO2d != forcings.end() ) {
-            if ( forcing_SO2i != forcings.end() ) {
-                returnval = forcing_SO2d->second + forcing_SO2i->second;
-            } else {
-                returnval = forcing_SO2d->second;
-            }
+        if( forcing_present[ F_SO2D ] ) {
+            returnval = forcings[ F_SO2D ] + forcings[ F_SO2I ];
         } else {
-            if ( forcing_SO2i != forcings.end() ) {
-                returnval = forcing_SO2i->second;
-            } else {
-                returnval.set( 0.0, U_W_M2 );
-            }
+            returnval.set( 0.0, U_W_M2 );
         }
     } else {
-        std::string forcing_name;
-        auto forcit = forcing_name_map.find(varName);
-        if(forcit != forcing_name_map.end()) {
-            forcing_name = forcing_name_map[varName];
-        }
-        else {
-            forcing_name = varName;
-        }
-        std::map<std::string, unitval>::const_iterator forcing = forcings.find(forcing_name);
-        if ( forcing != forcings.end() ) {
-            // from the forcing map
-            returnval = forcing->second;
+        std::map<std::string, int>::const_iterator forcit = forcing_index().find( varName );
+        if( forcit != forcing_index().end() && forcing_present[ forcit->second ] ) {
+            returnval = forcings[ forcit->second ];
         } else {
             if (currentYear < baseyear) {
                 returnval.set( 0.0, U_W_M2 );
@@ -518,7 +563,10 @@ void ForcingComponent::reset(double time) throw(h_exception)
 {
     // Set the current year to the reset year, and drop outputs after the reset year.
     currentYear = time;
-    forcings_ts.truncate(time);
+    if( time < baseyear )
+        forcings_ts.clear();
+    else if( time - baseyear + 1 < forcings_ts.size() )
+        forcings_ts.resize( size_t( time - baseyear ) + 1 );
     H_LOG(logger, Logger::NOTICE)
         << getComponentName() << " reset to time= " << time << "\n";
 }
@@ -47,7 +47,7 @@ string HalocarbonComponent::getComponentName() const {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void HalocarbonComponent::init( Core* coreptr ) {
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     //    concentration.name = myGasName;
     core = coreptr;
 
@@ -143,6 +143,8 @@ void HalocarbonComponent::prepareToRun() throw ( h_exception ) {
 
     Ha_ts.set(oldDate,H0);
 
+    emissions.share();
+    Ha_constrain.share();
 
     //! \remark concentration values will not be allowed to interpolate beyond years already read in
     //    concentration.allowPartialInterp( true );
@@ -151,41 +153,56 @@ void HalocarbonComponent::prepareToRun() throw ( h_exception ) {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void HalocarbonComponent::run( const double runToDate ) throw ( h_exception ) {
-	H_ASSERT( !core->inSpinup() && runToDate-oldDate == 1, "timestep must equal 1" );
+	H_ASSERT( !core->inSpinup() && runToDate-oldDate <= core->getTimeStep(), "timestep must not exceed the core timestep" );
     #define AtmosphereDryAirConstant 1.8
 
     unitval Ha(Ha_ts.get(oldDate));
     
-    // If emissions-forced, calculate concentration from emissions and lifespan.
-    if ( Ha_constrain.size() && Ha_constrain.exists( runToDate ) ) {
-        // Concentration-forced. Just grab the current value from the time series.
-        Ha = Ha_constrain.get(runToDate);
-    } else {
-        const double timestep = 1.0;
-        const double alpha = 1 / tau;
-
-        // Compute the delta atmospheric concentration from current emissions
-        double emissMol = emissions.get( runToDate ).value( U_GG ) / molarMass * timestep; // this is in U_GMOL
-        unitval concDeltaEmiss;
-        concDeltaEmiss.set( emissMol / ( 0.1 * AtmosphereDryAirConstant ), U_PPTV );
-    
-        // Update the atmospheric concentration, accounting for this delta and exponential decay
-        double expfac = exp(-alpha);
-        Ha = Ha*expfac + concDeltaEmiss*tau * (1.0-expfac);
-    }
+    // Step through each year of the time step, so that every year's
+    // emissions are counted.
+    for( double year = oldDate+1; year <= runToDate; year += 1 ) {
+        // If emissions-forced, calculate concentration from emissions and lifespan.
+        if ( Ha_constrain.size() && Ha_constrain.exists( year ) ) {
+            // Concentration-forced. Just grab the current value from the time series.
+            Ha = Ha_constrain.get(year);
+        } else {
+            const double timestep = 1.0;
+            const double alpha = 1 / tau;
+
+            // Compute the delta atmospheric concentration from current emissions
+            double emissMol = emissions.get( year ).value( U_GG ) / molarMass * timestep; // this is in U_GMOL
+            unitval concDeltaEmiss;
+            concDeltaEmiss.set( emissMol / ( 0.1 * AtmosphereDryAirConstant ), U_PPTV );
+        
+            // Update the atmospheric concentration, accounting for this delta and exponential decay
+            double expfac = exp(-alpha);
+            Ha = Ha*expfac + concDeltaEmiss*tau * (1.0-expfac);
+        }
 
-    H_LOG( logger, Logger::DEBUG ) << "date: " << runToDate << " concentration: "<< Ha << endl;
-    Ha_ts.set(runToDate, Ha);
+        H_LOG( logger, Logger::DEBUG ) << "date: " << year << " concentration: "<< Ha << endl;
+        Ha_ts.set(year, Ha);
 
-    // Calculate radiative forcing    TODO: this should be moved to forcing component
-    unitval rf;
-    rf.set( rho.value( U_W_M2_PPTV ) * Ha.value( U_PPTV ), U_W_M2 );
-    hc_forcing.set( runToDate, rf );
+        // Calculate radiative forcing    TODO: this should be moved to forcing component
+        unitval rf;
+        rf.set( rho.value( U_W_M2_PPTV ) * Ha.value( U_PPTV ), U_W_M2 );
+        hc_forcing.set( year, rf );
+    }
 
     // Update time counter.
     oldDate = runToDate;
 }
 
+//------------------------------------------------------------------------------
+// documentation is inherited
+tseries<unitval>* HalocarbonComponent::getInputSeriesPtr( const std::string& varName,
+                                                          unit_types& units ) {
+    if( varName == myGasName + EMISSIONS_EXTENSION ) {
+        units = U_GG;
+        return &emissions;
+    }
+    return NULL;
+}
+
 //------------------------------------------------------------------------------
 // documentation is inherited
 unitval HalocarbonComponent::getData( const std::string& varName,
@@ -104,6 +104,42 @@ streamsize Logger::LoggerStreamBuf::xsputn( const char* s, streamsize n ) {
     return filebuf::xsputn( s, n );
 }
 
+//------------------------------------------------------------------------------
+// Methods for SinkStreamBuf
+
+//------------------------------------------------------------------------------
+/*! \brief Constructor
+ *
+ * \param tag The tag attached to each line sent to the shared sink.
+ * \param echoToScreen Boolean to indicate whether output will be echoed.
+ */
+Logger::SinkStreamBuf::SinkStreamBuf( const string& tag, const bool echoToScreen )
+:stringbuf( ios::out ),
+tag( tag )
+{
+    consoleBuf = echoToScreen ? STDOUT_STREAM.rdbuf() : 0;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Pass everything written since the last sync on to the sink.
+ *  \return 0 indicates success, any other value is an error code.
+ */
+int Logger::SinkStreamBuf::sync() {
+    const string text = str();
+    if( text.empty() ) {
+        return 0;
+    }
+
+    if( consoleBuf ) {
+        consoleBuf->sputn( text.data(), text.size() );
+        consoleBuf->pubsync();
+    }
+    LogSink::getSink().write( tag, text );
+    str( "" );
+
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 // Methods for Logger
 
@@ -113,6 +149,8 @@ streamsize Logger::LoggerStreamBuf::xsputn( const char* s, streamsize n ) {
 Logger::Logger() :
 minLogLevel( WARNING ),
 isInitialized( false ),
+echoToFile( false ),
+enabled( false ),
 loggerStream( 0 )
 {
 }
@@ -132,7 +170,7 @@ Logger::~Logger() {
  *  Initialization can only occur once, any subsequent attempts will result in
  *  an exception.  Once open the logger will be unable to change setting on
  *  which file to log to, whether to echo to screen, nor the minimum priority
- *  level which will be logged.
+ *  level which will be logged.  A disabled logger allocates no stream at all.
  *
  * \param logName The file name the log will be written to.
  * \param echoToScreen A flag to indicate if messages should be echoed to the
@@ -140,33 +178,47 @@ Logger::~Logger() {
  * \param minLogLevel The minimum priority which will be processed.
  * \param echoToFile A flag to indicate if messages should be written to a log
  *                   file. If neither echoToScreen nor echoToFile is true, the
- *                   logger is disabled.
+ *                   logger is disabled.  If the shared sink is open, the
+ *                   messages go there instead of to a file of their own.
  *                   (default: true)
+ * \param tagPrefix Prefix shared by the tags of all the loggers of one core.
  * \exception h_exception Exception thrown if the logger has already been
  *                        initialized.
  *
  */
 void Logger::open( const string& logName, bool echoToScreen,
-                   bool echoToFile, LogLevel minLogLevel ) throw ( h_exception ) {
+                   bool echoToFile, LogLevel minLogLevel,
+                   const string& tagPrefix ) throw ( h_exception ) {
     H_ASSERT( !isInitialized, "This log has already been initialized." );
 
     this->minLogLevel = minLogLevel;
     this->echoToFile = echoToFile;
+    this->tagPrefix = tagPrefix;
+    tag = tagPrefix.empty() ? logName : tagPrefix + "/" + logName;
+    enabled = echoToScreen || echoToFile;
+
+    if( !enabled ) {
+        isInitialized = true;
+        return;
+    }
 
-    if (echoToFile) {
+    if( echoToFile && LogSink::getSink().isOpen() ) {
+        loggerStream = new ostream( new SinkStreamBuf( tag, echoToScreen ) );
+    } else if( echoToFile ) {
         chk_logdir(LOG_DIRECTORY);
 
         const string fqName = LOG_DIRECTORY + logName + LOG_EXTENSION;	// fully-qualified name
 
         LoggerStreamBuf* buff = new LoggerStreamBuf( echoToScreen );
-        if( !buff->open( fqName.c_str(), ios::out ) )
+        if( !buff->open( fqName.c_str(), ios::out ) ) {
+            delete buff;
             H_THROW("Unable to open log file " + fqName);
+        }
 
-        loggerStream.rdbuf( buff );
+        loggerStream = new ostream( buff );
     } else {
-        loggerStream.rdbuf( STDOUT_STREAM.rdbuf() );
+        loggerStream = new ostream( STDOUT_STREAM.rdbuf() );
     }
-    enabled = echoToScreen || echoToFile;
 
     isInitialized = true;
 
@@ -174,6 +226,21 @@ void Logger::open( const string& logName, bool echoToScreen,
     printLogHeader( max( minLogLevel, NOTICE ) );
 }
 
+//------------------------------------------------------------------------------
+/*! \brief Open a component logger with the settings of its core's logger.
+ *
+ *  The logger writes to file if the parent does, at the same minimum level,
+ *  and its messages carry the parent's core tag.  It never echoes to screen.
+ *
+ * \param logName The name of the log (generally the component name).
+ * \param parent The logger of the core that owns the component.
+ * \exception h_exception Exception thrown if the logger has already been
+ *                        initialized.
+ */
+void Logger::open( const string& logName, const Logger& parent ) throw ( h_exception ) {
+    open( logName, false, parent.getEchoToFile(), parent.getMinLogLevel(), parent.tagPrefix );
+}
+
 //------------------------------------------------------------------------------
 /*! \brief Indicate whether a message at the given priority will be logged.
  *  \param writeLevel The priority level to check.
@@ -197,10 +264,10 @@ bool Logger::shouldWrite( const LogLevel writeLevel ) const {
 ostream& Logger::write( const LogLevel writeLevel,
                        const string& functionInfo ) throw ( h_exception )
 {
-    H_ASSERT( isInitialized, "can't write to logger until initialized" );
+    H_ASSERT( isInitialized && loggerStream, "can't write to logger until initialized" );
 
     // note that we not double checking the writeLevel
-    return loggerStream << getDateTimeStamp() << ':' <<logLevelToStr( writeLevel )
+    return *loggerStream << getDateTimeStamp() << ':' <<logLevelToStr( writeLevel )
     << ':' << functionInfo << ": ";
 }
 
@@ -209,10 +276,14 @@ ostream& Logger::write( const LogLevel writeLevel,
  */
 void Logger::close() {
     if( isInitialized ) {
-        if (echoToFile) {
-            LoggerStreamBuf *lsbuf = static_cast<LoggerStreamBuf*>( loggerStream.rdbuf() );
-            lsbuf->close();
-            delete lsbuf;
+        if( loggerStream ) {
+            loggerStream->flush();
+            if( echoToFile ) {
+                // Either our own log file or a buffer feeding the shared sink
+                delete loggerStream->rdbuf();
+            }
+            delete loggerStream;
+            loggerStream = 0;
         }
         /*! \note Setting isInitialized back to false will allow this logger to
          *        be reopened.
@@ -221,6 +292,115 @@ void Logger::close() {
     }
 }
 
+//------------------------------------------------------------------------------
+// Methods for LogSink
+
+//------------------------------------------------------------------------------
+/*! \brief Get the sink shared by all loggers in the process.
+ */
+LogSink& LogSink::getSink() {
+    static LogSink sink;
+    return sink;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Create an unopened sink.
+ */
+LogSink::LogSink() :
+isInitialized( false )
+{
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Destructor.  Anything still pending is written out.
+ */
+LogSink::~LogSink() {
+    close();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Open the sink.
+ *
+ *  Only loggers opened after this point send their messages to the sink.
+ *
+ * \param logName The file name the log will be written to.
+ * \exception h_exception If the sink is already open or the file can't be
+ *                        opened.
+ */
+void LogSink::open( const string& logName ) throw ( h_exception ) {
+    std::lock_guard<std::mutex> lock( sinkMutex );
+    H_ASSERT( !isInitialized, "The log sink has already been opened." );
+
+    Logger::chk_logdir( LOG_DIRECTORY );
+
+    const string fqName = LOG_DIRECTORY + logName + LOG_EXTENSION;
+    if( !logFile.open( fqName.c_str(), ios::out ) )
+        H_THROW( "Unable to open log file " + fqName );
+
+    isInitialized = true;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add the lines of a message, tagged with their source.
+ *  \param tag The tag identifying the logger that wrote the message.
+ *  \param text One or more lines of text.
+ */
+void LogSink::write( const string& tag, const string& text ) {
+    std::lock_guard<std::mutex> lock( sinkMutex );
+    if( !isInitialized ) {
+        return;
+    }
+
+    size_t start = 0;
+    while( start < text.size() ) {
+        size_t end = text.find( '\n', start );
+        if( end == string::npos ) {
+            end = text.size();
+        }
+        pending += '[';
+        pending += tag;
+        pending += "] ";
+        pending.append( text, start, end - start );
+        pending += '\n';
+        start = end + 1;
+    }
+
+    if( pending.size() >= LOG_SINK_BUFSIZE ) {
+        flushPending();
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Write out everything collected so far.
+ */
+void LogSink::flush() {
+    std::lock_guard<std::mutex> lock( sinkMutex );
+    flushPending();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Flush and close the sink.  Loggers still pointing at the sink
+ *         silently drop their messages.
+ */
+void LogSink::close() {
+    std::lock_guard<std::mutex> lock( sinkMutex );
+    if( isInitialized ) {
+        flushPending();
+        logFile.close();
+        isInitialized = false;
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Write pending lines to the log file.  The caller holds the lock.
+ */
+void LogSink::flushPending() {
+    if( !pending.empty() ) {
+        logFile.sputn( pending.data(), pending.size() );
+        logFile.pubsync();
+        pending.clear();
+    }
+}
 
 //------------------------------------------------------------------------------
 /*! \brief Convert the enum to a string so that it can be logged.
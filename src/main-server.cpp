@@ -0,0 +1,412 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+/*
+ *  main-server.cpp - long-lived server answering run requests
+ *  hector
+ *
+ *  Requests and responses are frames: the length of the payload in bytes,
+ *  in decimal, and a newline, followed by the payload.  A request payload is
+ *  a series of lines with tab-separated fields:
+ *
+ *      config  <input file>                        (required)
+ *      set     <variable> <date|NA> <value> <units>
+ *      run     <date>                              (default: end date)
+ *      get     <variable> <start|NA> [<end>]
+ *
+ *  Sets are applied in order, the model is run, and then the values asked for
+ *  are returned.  NA dates are for parameters.  The response payload is
+ *  either "ok" followed by one line per value,
+ *
+ *      <variable> <date> <value> <units>
+ *
+ *  or "error" and a message.  A client may send any number of requests over
+ *  one connection.
+ *
+ *  Cores are kept in a pool (see CorePool), so only the first request for a
+ *  given input file pays for reading the inputs and running the spinup.
+ *  Between requests, parameters that were set are put back; the next request
+ *  then reruns only what the changes invalidate.  A core that had dated
+ *  inputs (e.g. emissions) set can't be put back reliably, so it is not
+ *  reused.
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "component_data.hpp"
+#include "core.hpp"
+#include "core_pool.hpp"
+#include "h_exception.hpp"
+#include "message_data.hpp"
+#include "unitval.hpp"
+
+namespace Hector {
+
+using namespace std;
+
+namespace {
+
+//! Largest frame accepted, in bytes
+const size_t MAX_FRAME = 16 * 1024 * 1024;
+
+struct set_request {
+    string var;
+    double date;
+    unitval value;
+};
+
+struct get_request {
+    string var;
+    double start;
+    double end;
+};
+
+struct run_request {
+    string inifile;
+    vector<set_request> sets;
+    double rundate;
+    vector<get_request> gets;
+};
+
+//------------------------------------------------------------------------------
+/*! \brief Read exactly n bytes
+ *  \return False if the stream ended first.
+ */
+bool readFull( int fd, char* buf, size_t n ) {
+    while( n > 0 ) {
+        ssize_t got = read( fd, buf, n );
+        if( got < 0 && errno == EINTR )
+            continue;
+        if( got <= 0 )
+            return false;
+        buf += got;
+        n -= got;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Write exactly n bytes
+ *  \return False if the other end has gone away.
+ */
+bool writeFull( int fd, const char* buf, size_t n ) {
+    while( n > 0 ) {
+        ssize_t put = write( fd, buf, n );
+        if( put < 0 && errno == EINTR )
+            continue;
+        if( put <= 0 )
+            return false;
+        buf += put;
+        n -= put;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Read one frame
+ *  \return False if the stream ended before the frame started.
+ *  \exception h_exception If the frame is malformed or cut short.
+ */
+bool readFrame( int fd, string& payload ) throw ( h_exception ) {
+    string header;
+    char ch;
+    while( true ) {
+        if( !readFull( fd, &ch, 1 ) ) {
+            H_ASSERT( header.empty(), "connection closed in frame header" );
+            return false;
+        }
+        if( ch == '\n' )
+            break;
+        H_ASSERT( ch >= '0' && ch <= '9' && header.size() < 10, "bad frame header" );
+        header += ch;
+    }
+    H_ASSERT( !header.empty(), "bad frame header" );
+    const size_t len = strtoul( header.c_str(), NULL, 10 );
+    H_ASSERT( len <= MAX_FRAME, "frame too long" );
+    payload.resize( len );
+    H_ASSERT( len == 0 || readFull( fd, &payload[ 0 ], len ), "connection closed in frame" );
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Write one frame
+ *  \return False if the other end has gone away.
+ */
+bool writeFrame( int fd, const string& payload ) {
+    ostringstream header;
+    header << payload.size() << '\n';
+    const string h = header.str();
+    return writeFull( fd, h.data(), h.size() ) && writeFull( fd, payload.data(), payload.size() );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Parse a date field; NA means no date (a parameter)
+ */
+double parseDate( const string& field ) throw ( h_exception ) {
+    if( field == "NA" )
+        return Core::undefinedIndex();
+    char* end;
+    double date = strtod( field.c_str(), &end );
+    H_ASSERT( !field.empty() && *end == '\0', "bad date: " + field );
+    return date;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Parse a request payload
+ */
+run_request parseRequest( const string& payload ) throw ( h_exception ) {
+    run_request req;
+    req.rundate = -1.0;
+
+    istringstream lines( payload );
+    string line;
+    while( getline( lines, line ) ) {
+        if( !line.empty() && line[ line.size()-1 ] == '\r' )
+            line.erase( line.size()-1 );
+        if( line.empty() )
+            continue;
+
+        vector<string> fields;
+        istringstream fs( line );
+        string field;
+        while( getline( fs, field, '\t' ) )
+            fields.push_back( field );
+        const string& cmd = fields[ 0 ];
+
+        if( cmd == "config" ) {
+            H_ASSERT( fields.size() == 2, "usage: config <input file>" );
+            req.inifile = fields[ 1 ];
+        }
+        else if( cmd == "set" ) {
+            H_ASSERT( fields.size() == 5, "usage: set <variable> <date|NA> <value> <units>" );
+            char* end;
+            double value = strtod( fields[ 3 ].c_str(), &end );
+            H_ASSERT( !fields[ 3 ].empty() && *end == '\0', "bad value: " + fields[ 3 ] );
+            set_request s = { fields[ 1 ], parseDate( fields[ 2 ] ),
+                              unitval( value, unitval::parseUnitsName( fields[ 4 ] ) ) };
+            req.sets.push_back( s );
+        }
+        else if( cmd == "run" ) {
+            H_ASSERT( fields.size() == 2, "usage: run <date>" );
+            req.rundate = parseDate( fields[ 1 ] );
+        }
+        else if( cmd == "get" ) {
+            H_ASSERT( fields.size() == 3 || fields.size() == 4, "usage: get <variable> <start|NA> [<end>]" );
+            get_request g = { fields[ 1 ], parseDate( fields[ 2 ] ), 0.0 };
+            g.end = fields.size() == 4 ? parseDate( fields[ 3 ] ) : g.start;
+            req.gets.push_back( g );
+        }
+        else {
+            H_THROW( "unknown request: " + cmd );
+        }
+    }
+    H_ASSERT( !req.inifile.empty(), "request has no config" );
+    return req;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Append one output line to a response
+ */
+void writeValue( ostream& out, const string& var, double date, const unitval& v ) {
+    out << var << '\t';
+    if( date == Core::undefinedIndex() )
+        out << "NA";
+    else
+        out << date;
+    out << '\t' << v.value( v.units() ) << '\t' << v.unitsName() << '\n';
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Carry out a request on a core
+ *
+ *  \details Parameters that were set are put back before returning; reusable
+ *           is cleared if anything else was changed.
+ *  \return The lines of the response after "ok".
+ */
+string runRequest( Core* core, const run_request& req, bool& reusable ) throw ( h_exception ) {
+    vector<pair<const set_request*, unitval> > undo;
+    for( vector<set_request>::const_iterator it = req.sets.begin(); it != req.sets.end(); ++it ) {
+        if( it->date == Core::undefinedIndex() ) {
+            unitval old = core->sendMessage( M_GETDATA, it->var, message_data( it->date ) );
+            undo.push_back( make_pair( &*it, old ) );
+        }
+        else {
+            reusable = false;
+        }
+        core->sendMessage( M_SETDATA, it->var, message_data( it->date, it->value ) );
+    }
+
+    // Changes made here and by earlier requests rerun only what they affect.
+    if( core->changesPending() )
+        core->applyChanges();
+
+    const double rundate = req.rundate < 0.0 ? core->getEndDate() : req.rundate;
+    if( rundate > core->getCurrentDate() )
+        core->run( rundate );
+
+    ostringstream out;
+    out.precision( numeric_limits<double>::max_digits10 );
+    for( vector<get_request>::const_iterator it = req.gets.begin(); it != req.gets.end(); ++it ) {
+        if( it->start == Core::undefinedIndex() ) {
+            writeValue( out, it->var, it->start, core->sendMessage( M_GETDATA, it->var, message_data( it->start ) ) );
+            continue;
+        }
+        H_ASSERT( it->start <= it->end, "empty date range for " + it->var );
+        H_ASSERT( it->end <= rundate, "dates requested for " + it->var + " after the run date" );
+        for( double date = it->start; date <= it->end; date += 1.0 )
+            writeValue( out, it->var, date, core->sendMessage( M_GETDATA, it->var, message_data( date ) ) );
+    }
+
+    for( size_t i = undo.size(); i-- > 0; )
+        core->sendMessage( M_SETDATA, undo[ i ].first->var, message_data( undo[ i ].first->date, undo[ i ].second ) );
+
+    return out.str();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Answer one request, borrowing a core from the pool
+ *  \return The response payload.
+ */
+string handleRequest( CorePool& pool, double budget, const string& payload ) {
+    run_request req;
+    try {
+        req = parseRequest( payload );
+    }
+    catch( h_exception& e ) {
+        return string( "error\t" ) + e.what() + "\n";
+    }
+
+    Core* core;
+    try {
+        core = pool.acquire( req.inifile );
+    }
+    catch( h_exception& e ) {
+        return string( "error\t" ) + e.what() + "\n";
+    }
+
+    bool reusable = true;
+    try {
+        core->setRunBudget( budget );
+        string result = runRequest( core, req, reusable );
+        pool.release( req.inifile, core, reusable );
+        return "ok\n" + result;
+    }
+    catch( h_exception& e ) {
+        // The core may be partway through a change; don't reuse it.
+        pool.release( req.inifile, core, false );
+        return string( "error\t" ) + e.what() + "\n";
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Answer requests from one client until it disconnects
+ */
+void serveConnection( CorePool& pool, double budget, int infd, int outfd ) {
+    string payload;
+    while( true ) {
+        try {
+            if( !readFrame( infd, payload ) )
+                return;
+        }
+        catch( h_exception& e ) {
+            // The stream can't be resynchronized; give up on it.
+            writeFrame( outfd, string( "error\t" ) + e.what() + "\n" );
+            return;
+        }
+        if( !writeFrame( outfd, handleRequest( pool, budget, payload ) ) )
+            return;
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Accept clients on a Unix domain socket, each in its own thread
+ */
+int serveSocket( CorePool& pool, double budget, const string& path ) {
+    sockaddr_un addr;
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    if( path.size() >= sizeof( addr.sun_path ) ) {
+        cerr << "Socket path too long: " << path << endl;
+        return 1;
+    }
+    strncpy( addr.sun_path, path.c_str(), sizeof( addr.sun_path ) - 1 );
+
+    int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    unlink( path.c_str() );     // left over from an earlier server
+    if( fd < 0 || bind( fd, reinterpret_cast<sockaddr*>( &addr ), sizeof( addr ) ) < 0
+       || listen( fd, SOMAXCONN ) < 0 ) {
+        cerr << "Can't listen on " << path << ": " << strerror( errno ) << endl;
+        return 1;
+    }
+    cerr << "Hector server listening on " << path << endl;
+
+    while( true ) {
+        int client = accept( fd, NULL, NULL );
+        if( client < 0 ) {
+            if( errno == EINTR || errno == ECONNABORTED )
+                continue;
+            cerr << "accept failed: " << strerror( errno ) << endl;
+            close( fd );
+            return 1;
+        }
+        thread( [&pool, budget, client]() {
+            serveConnection( pool, budget, client, client );
+            close( client );
+        } ).detach();
+    }
+}
+
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Entry point for server mode
+ *
+ *  Usage: hector --server [--socket <path>] [--budget <seconds>]
+ *
+ *  Without a socket, requests are read from standard input and answered on
+ *  standard output.  The budget limits the time spent on each request (see
+ *  Core::setRunBudget).
+ */
+int serverMain( int argc, char* const argv[] ) {
+    string socketPath;
+    double budget = 0.0;
+    for( int i = 2; i < argc; ++i ) {
+        string arg = argv[ i ];
+        if( arg == "--socket" && i+1 < argc )
+            socketPath = argv[ ++i ];
+        else if( arg == "--budget" && i+1 < argc )
+            budget = atof( argv[ ++i ] );
+        else {
+            cerr << "Usage: " << argv[ 0 ] << " --server [--socket <path>] [--budget <seconds>]" << endl;
+            return 1;
+        }
+    }
+
+    // A client disconnecting shouldn't take the server down.
+    signal( SIGPIPE, SIG_IGN );
+
+    static CorePool pool;
+    if( socketPath.empty() ) {
+        serveConnection( pool, budget, STDIN_FILENO, STDOUT_FILENO );
+        return 0;
+    }
+    return serveSocket( pool, budget, socketPath );
+}
+
+}
@@ -13,8 +13,9 @@
  */
 
 #include <iostream>
+#include <memory>
 
-#include "core.hpp"
+#include "composed_core.hpp"
 #include "logger.hpp"
 #include "h_exception.hpp"
 #include "h_util.hpp"
@@ -27,17 +28,35 @@
 
 using namespace std;
 
+namespace Hector {
+int serverMain( int argc, char* const argv[] );
+}
+
 //-----------------------------------------------------------------------
 /*! \brief Entry point for HECTOR wrapper.
  *
- *  Starting point for wrapper, not the core.
+ *  Starting point for wrapper, not the core.  With --server as the first
+ *  argument, runs as a server instead (see main-server.cpp).  With --dynamic
+ *  as the first argument, runs a plain Core instead of a StandardCore, to
+ *  check that the two give the same results.
  */
 int main (int argc, char * const argv[]) {
     using namespace Hector;
 
-	try {
+    if( argc > 1 && string( argv[1] ) == "--server" )
+        return serverMain( argc, argv );
+
+    bool dynamic = false;
+    if( argc > 1 && string( argv[1] ) == "--dynamic" ) {
+        dynamic = true;
+        --argc;
+        ++argv;
+    }
+
+    try {
         // Create the Hector core
-        Core core;
+        std::unique_ptr<Core> corePtr( dynamic ? new Core : new StandardCore );
+        Core& core = *corePtr;
         Logger& glog = core.getGlobalLogger();
         H_LOG( glog, Logger::NOTICE ) << MODEL_NAME << " wrapper start" << endl;
 
@@ -53,7 +53,7 @@ string N2OComponent::getComponentName() const {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void N2OComponent::init( Core* coreptr ) {
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
     core = coreptr;
     oldDate = core->getStartDate();
@@ -141,42 +141,61 @@ void N2OComponent::prepareToRun() throw ( h_exception ) {
         N0 = N2O_constrain.get( oldDate );
     }
     N2O.set( oldDate, N0 );
+
+    N2O_emissions.share();
+    N2O_natural_emissions.share();
+    N2O_constrain.share();
 }
 
 //------------------------------------------------------------------------------
 // documentation is inherited
 void N2OComponent::run( const double runToDate ) throw ( h_exception ) {
 
-	H_ASSERT( !core->inSpinup() && runToDate-oldDate == 1, "timestep must equal 1" );
-
-    if ( N2O_constrain.size() && N2O_constrain.exists( runToDate ) ) {
-        N2O.set( runToDate, N2O_constrain.get( runToDate ) );
-    } else {
-        // Approach modified from Ward and Mahowald, 2014, 10.5194/acp-14-12701-2014
-        double previous_n2o = N0.value( U_PPBV_N2O );
+	H_ASSERT( !core->inSpinup() && runToDate-oldDate <= core->getTimeStep(), "timestep must not exceed the core timestep" );
 
-        if (runToDate != oldDate) {
-            previous_n2o = N2O.get( oldDate );
+    // Step the concentration through each year of the time step
+    for( double year = oldDate+1; year <= runToDate; year += 1 ) {
+        if ( N2O_constrain.size() && N2O_constrain.exists( year ) ) {
+            N2O.set( year, N2O_constrain.get( year ) );
+            continue;
         }
 
+        // Approach modified from Ward and Mahowald, 2014, 10.5194/acp-14-12701-2014
+        const double previous_n2o = N2O.get( year-1 ).value( U_PPBV_N2O );
+
         // Decay constant varies based on N2O concentrations
         // This is Eq. B8 in Ward and Mahowald, 2014
-        TAU_N2O.set( runToDate, unitval( TN2O0.value( U_YRS ) * ( pow( previous_n2o /N0.value( U_PPBV_N2O ), -0.05 ) ), U_YRS ) );
+        TAU_N2O.set( year, unitval( TN2O0.value( U_YRS ) * ( pow( previous_n2o /N0.value( U_PPBV_N2O ), -0.05 ) ), U_YRS ) );
     
         // Current emissions are the sum of natural and anthropogenic sources
-        const double current_n2oem = N2O_emissions.get( runToDate ).value( U_TG_N ) + N2O_natural_emissions.get( runToDate ).value( U_TG_N );
+        const double current_n2oem = N2O_emissions.get( year ).value( U_TG_N ) + N2O_natural_emissions.get( year ).value( U_TG_N );
     
         // This calculation follows Eq. B7 in Ward and Mahowald 2014
-        const double dN2O = current_n2oem / UC_N2O - previous_n2o / TAU_N2O.get( runToDate ).value( U_YRS );
+        const double dN2O = current_n2oem / UC_N2O - previous_n2o / TAU_N2O.get( year ).value( U_YRS );
 
-        N2O.set( runToDate, unitval( previous_n2o + dN2O, U_PPBV_N2O ) );
-        H_LOG( logger, Logger::DEBUG ) << runToDate << "tau = " << TAU_N2O.get( runToDate );
+        N2O.set( year, unitval( previous_n2o + dN2O, U_PPBV_N2O ) );
+        H_LOG( logger, Logger::DEBUG ) << year << "tau = " << TAU_N2O.get( year );
     }
 
     oldDate = runToDate;
     H_LOG( logger, Logger::DEBUG ) << runToDate << " N2O = " << N2O.get( runToDate ) << std::endl;
 }
 
+//------------------------------------------------------------------------------
+// documentation is inherited
+tseries<unitval>* N2OComponent::getInputSeriesPtr( const std::string& varName,
+                                                   unit_types& units ) {
+    if( varName == D_EMISSIONS_N2O ) {
+        units = U_TG_N;
+        return &N2O_emissions;
+    }
+    if( varName == D_NAT_EMISSIONS_N2O ) {
+        units = U_TG_N;
+        return &N2O_natural_emissions;
+    }
+    return NULL;
+}
+
 //------------------------------------------------------------------------------
 // documentation is inherited
 unitval N2OComponent::getData( const std::string& varName,
@@ -46,7 +46,7 @@ string OzoneComponent::getComponentName() const {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void OzoneComponent::init( Core* coreptr ) {
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
     core = coreptr;
 
@@ -64,6 +64,9 @@ void OzoneComponent::init( Core* coreptr ) {
     core->registerInput(D_EMISSIONS_CO, getComponentName());
     core->registerInput(D_EMISSIONS_NMVOC, getComponentName());
     core->registerInput(D_EMISSIONS_NOX, getComponentName());
+
+    // We read the current year's CH4, so CH4 has to run first
+    core->registerDependency( D_ATMOSPHERIC_CH4, getComponentName() );
 }
 
 //------------------------------------------------------------------------------
@@ -125,6 +128,10 @@ void OzoneComponent::prepareToRun() throw ( h_exception ) {
     H_LOG( logger, Logger::DEBUG ) << "prepareToRun " << std::endl;
     oldDate = core->getStartDate();
     O3.set(oldDate, PO3);  // set the first year's value
+
+    NOX_emissions.share();
+    CO_emissions.share();
+    NMVOC_emissions.share();
 }
 
 //------------------------------------------------------------------------------
@@ -147,6 +154,25 @@ void OzoneComponent::run( const double runToDate ) throw ( h_exception ) {
     H_LOG( logger, Logger::DEBUG ) << "Year " << runToDate << " O3 concentration = " << O3.get( runToDate ) << std::endl;
 }
 
+//------------------------------------------------------------------------------
+// documentation is inherited
+tseries<unitval>* OzoneComponent::getInputSeriesPtr( const std::string& varName,
+                                                     unit_types& units ) {
+    if( varName == D_EMISSIONS_NOX ) {
+        units = U_TG_N;
+        return &NOX_emissions;
+    }
+    if( varName == D_EMISSIONS_CO ) {
+        units = U_TG_CO;
+        return &CO_emissions;
+    }
+    if( varName == D_EMISSIONS_NMVOC ) {
+        units = U_TG_NMVOC;
+        return &NMVOC_emissions;
+    }
+    return NULL;
+}
+
 //------------------------------------------------------------------------------
 // documentation is inherited
 unitval OzoneComponent::getData( const std::string& varName,
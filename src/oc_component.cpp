@@ -46,7 +46,7 @@ string OrganicCarbonComponent::getComponentName() const {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void OrganicCarbonComponent::init( Core* coreptr ) {
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
   	core = coreptr;
 
@@ -105,15 +105,28 @@ void OrganicCarbonComponent::prepareToRun() throw ( h_exception ) {
 
     H_LOG( logger, Logger::DEBUG ) << "prepareToRun " << std::endl;
     oldDate = core->getStartDate();
+
+    OC_emissions.share();
 }
 
 //------------------------------------------------------------------------------
 // documentation is inherited
 void OrganicCarbonComponent::run( const double runToDate ) throw ( h_exception ) {
-	H_ASSERT( !core->inSpinup() && runToDate-oldDate == 1, "timestep must equal 1" );
+	H_ASSERT( !core->inSpinup() && runToDate-oldDate <= core->getTimeStep(), "timestep must not exceed the core timestep" );
     oldDate = runToDate;
 }
 
+//------------------------------------------------------------------------------
+// documentation is inherited
+tseries<unitval>* OrganicCarbonComponent::getInputSeriesPtr( const std::string& varName,
+                                                             unit_types& units ) {
+    if( varName == D_EMISSIONS_OC ) {
+        units = U_TG;
+        return &OC_emissions;
+    }
+    return NULL;
+}
+
 //------------------------------------------------------------------------------
 // documentation is inherited
 unitval OrganicCarbonComponent::getData( const std::string& varName,
@@ -50,7 +50,7 @@ string OceanComponent::getComponentName() const {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void OceanComponent::init( Core* coreptr ) {
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
 
     max_timestep = OCEAN_MAX_TIMESTEP;
@@ -69,6 +69,7 @@ void OceanComponent::init( Core* coreptr ) {
     Tgav.set( 0.0, U_DEGC );
 
 	lastflux_annualized.set( 0.0, U_PGC );
+    annualflux_years = 0.0;
 
     // Register the data we can provide
     core->registerCapability( D_OCEAN_CFLUX, getComponentName() );
@@ -81,6 +82,10 @@ void OceanComponent::init( Core* coreptr ) {
     core->registerCapability( D_TU, getComponentName() );
     core->registerCapability( D_TWI, getComponentName() );
     core->registerCapability( D_TID, getComponentName() );
+
+    // Atmospheric CO2 and temperature are read from the previous time step
+    core->registerLaggedDependency( D_ATMOSPHERIC_CO2, getComponentName() );
+    core->registerLaggedDependency( D_GLOBAL_TEMP, getComponentName() );
 }
 
 //------------------------------------------------------------------------------
@@ -286,6 +291,7 @@ void OceanComponent::run( const double runToDate ) throw ( h_exception ) {
 	annualflux_sum.set( 0.0, U_PGC );
 	annualflux_sumHL.set( 0.0, U_PGC );
 	annualflux_sumLL.set( 0.0, U_PGC );
+    annualflux_years = 0.0;
     timesteps = 0;
 
     // Initialize ocean box boundary conditions and inform them new year starting
@@ -328,6 +334,15 @@ bool OceanComponent::run_spinup( const int step ) throw ( h_exception ) {
     return true;        // solver will be the one signalling
 }
 
+//------------------------------------------------------------------------------
+/*! \brief A running flux total as the flux for one year
+ *  \details Over a time step of several years the totals cover all of them;
+ *           they are reported as the mean per year.
+ */
+static unitval per_year( const unitval& sum, double years ) {
+    return years > 1.0 ? sum / years : sum;
+}
+
 //------------------------------------------------------------------------------
 // documentation is inherited
 unitval OceanComponent::getData( const std::string& varName,
@@ -342,9 +357,10 @@ unitval OceanComponent::getData( const std::string& varName,
     if( varName == D_OCEAN_CFLUX ) {
         // If no date, we're in spinup; just return the current value
         if( date == Core::undefinedIndex() ) {
-            returnval = annualflux_sum;
+            returnval = per_year( annualflux_sum, annualflux_years );
         } else {
-            returnval = annualflux_sum_ts.get(date);
+            const ocean_state& state = state_tv.get(date);
+            returnval = per_year( state.annualflux_sum, state.annualflux_years );
         }
     } else if( varName == D_OCEAN_C ) {
         returnval = totalcpool();
@@ -355,9 +371,9 @@ unitval OceanComponent::getData( const std::string& varName,
 	} else if( varName == D_PH_LL ) {
         returnval = surfaceLL.mychemistry.pH;
 	} else if( varName == D_ATM_OCEAN_FLUX_HL ) {
-		returnval = unitval( annualflux_sumHL.value( U_PGC ), U_PGC_YR );
+		returnval = unitval( per_year( annualflux_sumHL, annualflux_years ).value( U_PGC ), U_PGC_YR );
     } else if( varName == D_ATM_OCEAN_FLUX_LL ) {
-		returnval = unitval( annualflux_sumLL.value( U_PGC ), U_PGC_YR );
+		returnval = unitval( per_year( annualflux_sumLL, annualflux_years ).value( U_PGC ), U_PGC_YR );
 	} else if( varName == D_PCO2_HL ) {
         returnval = surfaceHL.mychemistry.PCO2o;
 	} else if( varName == D_PCO2_LL ) {
@@ -526,6 +542,7 @@ void OceanComponent::stashCValues( double t, const double c[] ) {
     annualflux_sumHL = annualflux_sumHL + surfaceHL.atmosphere_flux;
     annualflux_sumLL = annualflux_sumLL + surfaceLL.atmosphere_flux;
     annualflux_sum = annualflux_sum + lastflux;
+    annualflux_years += yearfraction;
 
     // lastflux_annualized is our basis of comparison for variable timestep
     lastflux_annualized = lastflux / yearfraction;
@@ -555,40 +572,28 @@ void OceanComponent::reset(double time) throw(h_exception)
 {
 
     // Reset state variables to their values at the reset time
-    surfaceHL = surfaceHL_tv.get(time);
-    surfaceLL = surfaceLL_tv.get(time);
-    inter = inter_tv.get(time);
-    deep = deep_tv.get(time);
-
-    Tgav = Tgav_ts.get(time);
-    Ca = Ca_ts.get(time);
-
-    annualflux_sum = annualflux_sum_ts.get(time);
-    annualflux_sumHL = annualflux_sumHL_ts.get(time);
-    annualflux_sumLL = annualflux_sumLL_ts.get(time);
-    lastflux_annualized = lastflux_annualized_ts.get(time);
-
-    max_timestep = max_timestep_ts.get(time);
-    reduced_timestep_timeout = reduced_timestep_timeout_ts.get(time);
+    const ocean_state& state = state_tv.get(time);
+    surfaceHL.set_state(state.surfaceHL);
+    surfaceLL.set_state(state.surfaceLL);
+    inter.set_state(state.inter);
+    deep.set_state(state.deep);
+
+    Tgav = state.Tgav;
+    Ca = state.Ca;
+
+    annualflux_sum = state.annualflux_sum;
+    annualflux_sumHL = state.annualflux_sumHL;
+    annualflux_sumLL = state.annualflux_sumLL;
+    annualflux_years = state.annualflux_years;
+    lastflux_annualized = state.lastflux_annualized;
+
+    max_timestep = state.max_timestep;
+    reduced_timestep_timeout = state.reduced_timestep_timeout;
     timesteps = 0;
 
 
-    // truncate all the time series beyond the reset time
-    surfaceHL_tv.truncate(time);
-    surfaceLL_tv.truncate(time);
-    inter_tv.truncate(time);
-    deep_tv.truncate(time);
-
-    Tgav_ts.truncate(time);
-    Ca_ts.truncate(time);
-
-    annualflux_sum_ts.truncate(time);
-    annualflux_sumHL_ts.truncate(time);
-    annualflux_sumLL_ts.truncate(time);
-    lastflux_annualized_ts.truncate(time);
-
-    max_timestep_ts.truncate(time);
-    reduced_timestep_timeout_ts.truncate(time);
+    // truncate the state record beyond the reset time
+    state_tv.truncate(time);
 
     H_LOG(logger, Logger::NOTICE)
         << getComponentName() << " reset to time= " << time << "\n";
@@ -599,21 +604,24 @@ void OceanComponent::record_state(double time)
 {
     H_LOG(logger, Logger::DEBUG) << "Recording component state at t= "
                                  << time << endl;
-    surfaceHL_tv.set(time, surfaceHL);
-    surfaceLL_tv.set(time, surfaceLL);
-    inter_tv.set(time, inter);
-    deep_tv.set(time, deep);
-
-    Tgav_ts.set(time, Tgav);
-    Ca_ts.set(time, Ca);
-
-    annualflux_sum_ts.set(time, annualflux_sum);
-    annualflux_sumHL_ts.set(time, annualflux_sumHL);
-    annualflux_sumLL_ts.set(time, annualflux_sumLL);
-    lastflux_annualized_ts.set(time, lastflux_annualized);
-
-    max_timestep_ts.set(time, max_timestep);
-    reduced_timestep_timeout_ts.set(time, reduced_timestep_timeout);
+    ocean_state state;
+    state.surfaceHL = surfaceHL.get_state();
+    state.surfaceLL = surfaceLL.get_state();
+    state.inter = inter.get_state();
+    state.deep = deep.get_state();
+
+    state.Tgav = Tgav;
+    state.Ca = Ca;
+
+    state.annualflux_sum = annualflux_sum;
+    state.annualflux_sumHL = annualflux_sumHL;
+    state.annualflux_sumLL = annualflux_sumLL;
+    state.annualflux_years = annualflux_years;
+    state.lastflux_annualized = lastflux_annualized;
+
+    state.max_timestep = max_timestep;
+    state.reduced_timestep_timeout = reduced_timestep_timeout;
+    state_tv.set(time, state);
 }
 
 //------------------------------------------------------------------------------
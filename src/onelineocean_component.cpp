@@ -42,11 +42,14 @@ string OneLineOceanComponent::getComponentName() const {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void OneLineOceanComponent::init( Core* coreptr ) {
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
 
     core = coreptr;
 
+    // Atmospheric carbon is read from the previous time step
+    core->registerLaggedDependency( D_ATMOSPHERIC_C, getComponentName() );
+
     ocean_c.set(core->getStartDate(), unitval(38000.0, U_PGC));
     total_cflux.set(core->getStartDate(), unitval(0.0, U_PGC_YR));
 }
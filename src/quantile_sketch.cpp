@@ -0,0 +1,190 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+/*
+ *  quantile_sketch.cpp
+ *  hector
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "quantile_sketch.hpp"
+
+namespace Hector {
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/*! \brief Constructor
+ *  \param compression Larger values give more accurate quantiles and use
+ *         more memory.
+ */
+QuantileSketch::QuantileSketch( double compression )
+: compression( compression ), total( 0.0 ),
+  min( numeric_limits<double>::infinity() ), max( -numeric_limits<double>::infinity() )
+{
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add a value
+ */
+void QuantileSketch::add( double x )
+{
+    buffer.push_back( centroid( x, 1.0 ) );
+    total += 1.0;
+    min = std::min( min, x );
+    max = std::max( max, x );
+    if( buffer.size() >= 5 * compression )
+        compress();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add the values summarized by another sketch
+ */
+void QuantileSketch::merge( const QuantileSketch& other )
+{
+    if( !other.buffer.empty() ) {
+        QuantileSketch folded( other );
+        folded.compress();
+        merge( folded );
+        return;
+    }
+    buffer.insert( buffer.end(), other.centroids.begin(), other.centroids.end() );
+    total += other.total;
+    min = std::min( min, other.min );
+    max = std::max( max, other.max );
+    compress();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Fold the buffered values into the centroids
+ *
+ *  \details Neighbouring centroids are merged for as long as the merged
+ *           centroid spans no more than one unit of the scale function
+ *           k(q) = compression/(2 pi) asin(2q-1), which is steep near q=0
+ *           and q=1.
+ */
+void QuantileSketch::compress()
+{
+    if( buffer.empty() )
+        return;
+    buffer.insert( buffer.end(), centroids.begin(), centroids.end() );
+    sort( buffer.begin(), buffer.end() );
+    centroids.clear();
+
+    // The cumulative weight one unit of k past the given weight
+    const double norm = compression / ( 2.0 * M_PI );
+    const auto limit = [&]( double sofar ) {
+        const double k = norm * asin( std::min( 1.0, 2.0 * sofar / total - 1.0 ) ) + 1.0;
+        return k >= norm * M_PI / 2.0 ? total : total * ( sin( k / norm ) + 1.0 ) / 2.0;
+    };
+
+    double sofar = 0.0;         // weight before the current centroid
+    double upto = limit( sofar );
+    centroid current = buffer[ 0 ];
+    for( size_t i = 1; i < buffer.size(); ++i ) {
+        const double w = current.second + buffer[ i ].second;
+        if( sofar + w <= upto ) {
+            current.first += ( buffer[ i ].first - current.first ) * buffer[ i ].second / w;
+            current.second = w;
+        }
+        else {
+            centroids.push_back( current );
+            sofar += current.second;
+            upto = limit( sofar );
+            current = buffer[ i ];
+        }
+    }
+    centroids.push_back( current );
+    buffer.clear();
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Estimate a quantile
+ *
+ *  \details Each centroid's mean is taken to sit at the middle of its weight,
+ *           and quantiles in between are interpolated linearly; below the
+ *           first and above the last centroid, the exact minimum and maximum
+ *           are used.
+ *  \param q The probability, between 0 and 1.
+ *  \return The estimate, or NaN if no values have been added.
+ */
+double QuantileSketch::quantile( double q ) const
+{
+    if( total == 0.0 )
+        return numeric_limits<double>::quiet_NaN();
+    if( !buffer.empty() ) {
+        QuantileSketch folded( *this );
+        folded.compress();
+        return folded.quantile( q );
+    }
+
+    const double target = std::min( 1.0, std::max( 0.0, q ) ) * total;
+    double left = 0.0;          // weight before centroid i
+    double prevMid = 0.0;       // cumulative weight at the previous mean
+    double prevMean = min;
+    for( size_t i = 0; i < centroids.size(); ++i ) {
+        const double mid = left + centroids[ i ].second / 2.0;
+        if( target < mid ) {
+            if( mid == prevMid )
+                return centroids[ i ].first;
+            return prevMean + ( centroids[ i ].first - prevMean ) * ( target - prevMid ) / ( mid - prevMid );
+        }
+        prevMid = mid;
+        prevMean = centroids[ i ].first;
+        left += centroids[ i ].second;
+    }
+    if( total == prevMid )
+        return max;
+    return prevMean + ( max - prevMean ) * ( target - prevMid ) / ( total - prevMid );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Write the sketch, as text that read() accepts, with enough digits
+ *         to be read back exactly
+ */
+void QuantileSketch::write( ostream& out ) const
+{
+    if( !buffer.empty() ) {
+        QuantileSketch folded( *this );
+        folded.compress();
+        folded.write( out );
+        return;
+    }
+    const streamsize precision = out.precision( numeric_limits<double>::max_digits10 );
+    // An empty sketch's bounds are infinite, which streams can't read back
+    out << compression << ' ' << total << ' ' << ( total > 0.0 ? min : 0.0 ) << ' '
+        << ( total > 0.0 ? max : 0.0 ) << ' ' << centroids.size();
+    for( size_t i = 0; i < centroids.size(); ++i )
+        out << ' ' << centroids[ i ].first << ' ' << centroids[ i ].second;
+    out << '\n';
+    out.precision( precision );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Replace the sketch with one written by write()
+ *  \exception h_exception If the input is malformed.
+ */
+void QuantileSketch::read( istream& in ) throw ( h_exception )
+{
+    size_t n;
+    in >> compression >> total >> min >> max >> n;
+    H_ASSERT( !in.fail(), "malformed quantile sketch" );
+    if( total == 0.0 ) {
+        min = numeric_limits<double>::infinity();
+        max = -numeric_limits<double>::infinity();
+    }
+    centroids.resize( n );
+    buffer.clear();
+    for( size_t i = 0; i < n; ++i )
+        in >> centroids[ i ].first >> centroids[ i ].second;
+    H_ASSERT( !in.fail(), "malformed quantile sketch" );
+}
+
+}
@@ -1,10 +1,16 @@
 #include <Rcpp.h>
+#include <cmath>
 #include <fstream>
+#include <map>
 #include <sstream>
 
 #include "hector.hpp"
 #include "logger.hpp"
 #include "message_data.hpp"
+#include "scenario_tree.hpp"
+#include "calibrator.hpp"
+#include "sensitivity.hpp"
+#include "ensemble_runner.hpp"
 
 using namespace Rcpp;
 
@@ -26,10 +32,24 @@ Hector::Core *gethcore(Environment core)
     return hcore;
 }
 
+// Add a stop condition for each element of a named vector of thresholds.
+void add_stop_conditions(Hector::Core *hcore, const Nullable<NumericVector>& thresholds,
+                         bool above)
+{
+    if(thresholds.isNull())
+        return;
+    NumericVector thr(thresholds);
+    CharacterVector vars = thr.names();
+    for(int i=0; i<thr.size(); ++i) {
+        hcore->addStopCondition(Rcpp::as<std::string>(vars[i]), thr[i], above);
+    }
+}
+
 // This is the C++ implementation of the core constructor.  It should only ever
 // be called from the `newcore` wrapper function.
 // [[Rcpp::export]]
-Environment newcore_impl(String inifile, int loglevel, bool suppresslogging, String name)
+Environment newcore_impl(String inifile, int loglevel, bool suppresslogging, String name,
+                         std::vector<std::string> targets, bool arena)
 {
     try {
         // Check that the configuration file exists. The easiest way to do
@@ -46,7 +66,7 @@ Environment newcore_impl(String inifile, int loglevel, bool suppresslogging, Str
         // Create and initialize the core.
         int coreidx = Hector::Core::mkcore(!suppresslogging,
                                            (Hector::Logger::LogLevel)loglevel,
-                                           false);
+                                           false, arena);
 
         Hector::Core *hcore = Hector::Core::getcore(coreidx);
         hcore->init();
@@ -61,6 +81,10 @@ Environment newcore_impl(String inifile, int loglevel, bool suppresslogging, Str
             Rcpp::stop(msg.str());
         }
 
+        // Components the targets don't need are dropped during setup
+        if(!targets.empty())
+            hcore->setTargetOutputs(targets);
+
         // Run the last bit of setup
         hcore->prepareToRun();
 
@@ -76,6 +100,7 @@ Environment newcore_impl(String inifile, int loglevel, bool suppresslogging, Str
         rv["name"] = name;
         rv["clean"] = true;
         rv["reset_date"] = 0;
+        rv["abort_reason"] = NA_STRING;
 
         return rv;
     }
@@ -117,7 +142,8 @@ Environment shutdown(Environment core)
 //' the spinup will be rerun, and the model will be
 //' left ready to run at the start date.  (By contrast, resetting \emph{to} the start
 //' date leaves the model ready to run at the start date, but without having rerun the
-//' spinup.)
+//' spinup.)  A date between time steps is taken as the
+//' time step before it.
 //'
 //' @param core Handle for the Hector instance that is to be reset.
 //' @param date Date to reset to.  The default is to reset to the model start date with
@@ -146,24 +172,66 @@ Environment reset(Environment core, double date=0)
 }
 
 
+// Bring a core whose values have changed up to date before running it.  This
+// is not callable from R directly.
+void clean_core(Environment core, Hector::Core *hcore)
+{
+    if(core["clean"])
+        return;
+    if(hcore->changesPending()) {
+        // Let the core work out how little of the run has to be redone.
+        try {
+            hcore->applyChanges();
+        }
+        catch(h_exception e) {
+            std::stringstream msg;
+            msg << "Error resetting after parameter changes:  " << e;
+            Rcpp::stop(msg.str());
+        }
+        core["clean"] = true;
+    }
+    else {
+        reset(core, core["reset_date"]);
+    }
+}
+
+
 //' Run the Hector climate model
 //'
 //' Run Hector up through the specified time.  This function does not return the results
 //' of the run.  To get results, run \code{fetch}.
+//' If values have been changed since the last run, only the part of the run they
+//' invalidate is recomputed; for example, changing the climate sensitivity does not
+//' require rerunning the spinup.
+//'
+//' The run can be made to stop early, at the end of the first year in which a
+//' stop condition is met.  The date it stopped at is stored in the handle as
+//' \code{core$stop_date} (\code{NA} if it ran to the end), and later calls to
+//' \code{run} pick up from there.  Stop conditions apply only to the call they
+//' are given to.
 //'
 //' @param core Handle to the Hector instance that is to be run.
 //' @param runtodate Date to run to.  The default is to run to the end date configured
 //' in the input file used to initialize the core.
+//' @param stop_above Named vector of thresholds; the run stops once any of the
+//' named variables (e.g. \code{GLOBAL_TEMP()}) is at or above its threshold.
+//' Thresholds are in the units \code{fetchvars} reports.
+//' @param stop_below Like \code{stop_above}, but stops once a variable is at or
+//' below its threshold.
+//' @param stop_fun Function called as \code{stop_fun(core, date)} after each year;
+//' the run stops if it returns \code{TRUE}.
 //' @return The Hector instance handle
 //' @export
 //' @family main user interface functions
 // [[Rcpp::export]]
-Environment run(Environment core, double runtodate=-1.0)
+Environment run(Environment core, double runtodate=-1.0,
+                Nullable<NumericVector> stop_above=R_NilValue,
+                Nullable<NumericVector> stop_below=R_NilValue,
+                Nullable<Function> stop_fun=R_NilValue)
 {
-    if(!core["clean"])
-        reset(core, core["reset_date"]);
-
     Hector::Core *hcore = gethcore(core);
+    clean_core(core, hcore);
+
     if(runtodate > 0 && runtodate < hcore->getCurrentDate()) {
         std::stringstream msg;
         msg << "Requested run date " << runtodate << " is prior to the current date of "
@@ -172,14 +240,95 @@ Environment run(Environment core, double runtodate=-1.0)
     }
 
     try {
+        hcore->clearStopConditions();
+        add_stop_conditions(hcore, stop_above, true);
+        add_stop_conditions(hcore, stop_below, false);
+        if(stop_fun.isNotNull()) {
+            Function fn(stop_fun);
+            hcore->addStopCondition([core, fn](Hector::Core&, double date) {
+                // Errors in R code must not unwind through the core, so
+                // evaluate with Rcpp_eval, which turns them into exceptions.
+                try {
+                    Shield<SEXP> call(Rf_lang3(fn, core, Rf_ScalarReal(date)));
+                    return Rcpp::as<bool>(Rcpp_eval(call, R_GlobalEnv));
+                }
+                catch(std::exception& e) {
+                    H_THROW(std::string("Error in stop function: ") + e.what());
+                }
+                catch(...) {
+                    H_THROW("Stop function was interrupted");
+                }
+            });
+        }
+
         hcore->run(runtodate);
+        hcore->clearStopConditions();
+    }
+    catch(h_run_aborted e) {
+        hcore->clearStopConditions();
+        // The components may have run past the core's current date, partway
+        // into a year, so the next run resets to that date first.
+        core["clean"] = false;
+        core["reset_date"] = hcore->getCurrentDate();
+        std::string reason = e.getReason() == h_run_aborted::CANCELLED ? "cancelled" :
+            e.getReason() == h_run_aborted::TIME_BUDGET ? "time budget" : "evaluation budget";
+        core["abort_reason"] = reason;
+        std::stringstream msg;
+        msg << "Hector run aborted (" << reason << "):  " << e;
+        Rcpp::stop(msg.str());
     }
     catch(h_exception e) {
+        hcore->clearStopConditions();
         std::stringstream msg;
         msg << "Error while running hector:  " << e;
         Rcpp::stop(msg.str());
     }
 
+    double stopdate = hcore->getStopDate();
+    core["stop_date"] = stopdate < 0 ? NA_REAL : stopdate;
+    core["abort_reason"] = NA_STRING;
+
+    return core;
+}
+
+
+//' Limit or cancel runs
+//'
+//' A run that goes over its budget, or is cancelled, stops with an error, and
+//' the reason (\code{"time budget"}, \code{"evaluation budget"}, or
+//' \code{"cancelled"}) is stored in the handle as \code{core$abort_reason}
+//' (\code{NA} after a run that finished).  The next call to \code{run}
+//' starts over from the date \code{getdate} reports.
+//'
+//' \strong{setbudget}: Limit how long each call to \code{run} may take.
+//'
+//' @param core Handle to a Hector instance
+//' @param seconds Wall-clock time allowed per run (0 for no limit).
+//' @param evaluations Carbon cycle derivative evaluations allowed per run (0
+//' for no limit).  Unlike the time limit, this stops at the same point on
+//' any machine.
+//' @return The Hector instance handle
+//' @rdname budgets
+//' @export
+// [[Rcpp::export]]
+Environment setbudget(Environment core, double seconds=0, double evaluations=0)
+{
+    Hector::Core *hcore = gethcore(core);
+    hcore->setRunBudget(seconds, long(evaluations));
+    return core;
+}
+
+//' \strong{cancelrun}: Cancel the run in progress (for example, from a
+//' \code{stop_fun}) and every run after it until the cancellation is lifted.
+//'
+//' @param cancel If false, lift an earlier cancellation.
+//' @rdname budgets
+//' @export
+// [[Rcpp::export]]
+Environment cancelrun(Environment core, bool cancel=true)
+{
+    Hector::Core *hcore = gethcore(core);
+    *hcore->getCancelToken() = cancel;
     return core;
 }
 
@@ -195,6 +344,109 @@ double getdate(Environment core)
     return hcore->getCurrentDate();
 }
 
+//' Record outputs as the model runs
+//'
+//' A subscription records the chosen outputs at regular dates as the model
+//' runs.  Fetching them with \code{fetchsubscription} gives the same values as
+//' \code{fetchvars} would, but costs nothing per variable and date, which helps
+//' when a core is run many times.  Only dates run after subscribing are
+//' recorded; when part of a run is redone, its values are recorded again.
+//'
+//' \strong{subscribe}: Start recording outputs.
+//'
+//' @param core Hector core object
+//' @param vars Capability strings of the variables to record.
+//' @param start First date to record.  The default is the first date after
+//' the start date.
+//' @param end Last date to record.  The default is the end date.
+//' @param stride Record every \code{stride}th date.
+//' @return \code{subscribe} returns an id for the subscription;
+//' \code{unsubscribe} returns the core.
+//' @rdname subscriptions
+//' @export
+// [[Rcpp::export]]
+int subscribe(Environment core, std::vector<std::string> vars, double start=-1.0,
+              double end=-1.0, int stride=1)
+{
+    Hector::Core *hcore = gethcore(core);
+    int id = -1;
+    try {
+        id = hcore->subscribeOutputs(vars, start, end, stride);
+    }
+    catch(h_exception e) {
+        std::stringstream msg;
+        msg << "Error subscribing to outputs:  " << e;
+        Rcpp::stop(msg.str());
+    }
+    return id;
+}
+
+//' \strong{unsubscribe}: Stop recording outputs and free what was recorded.
+//'
+//' @param id Id returned by \code{subscribe}.
+//' @rdname subscriptions
+//' @export
+// [[Rcpp::export]]
+Environment unsubscribe(Environment core, int id)
+{
+    Hector::Core *hcore = gethcore(core);
+    try {
+        hcore->unsubscribeOutputs(id);
+    }
+    catch(h_exception e) {
+        std::stringstream msg;
+        msg << "Error unsubscribing:  " << e;
+        Rcpp::stop(msg.str());
+    }
+    return core;
+}
+
+// This is the C++ implementation of fetchsubscription.  It should only ever
+// be called from the `fetchsubscription` wrapper function.
+// [[Rcpp::export]]
+DataFrame fetchsubscription_impl(Environment core, int id)
+{
+    Hector::Core *hcore = gethcore(core);
+    std::vector<double> dates;
+    std::vector<Hector::unit_types> units;
+    const std::vector<double>* values = NULL;
+    try {
+        dates = hcore->getSubscriptionDates(id);
+        units = hcore->getSubscriptionUnits(id);
+        values = &hcore->getSubscriptionValues(id);
+    }
+    catch(h_exception e) {
+        std::stringstream msg;
+        msg << "Error fetching subscription:  " << e;
+        Rcpp::stop(msg.str());
+    }
+
+    // Rows for dates not yet run are left over from earlier runs, if any
+    int ndate = 0;
+    while(ndate < int(dates.size()) && dates[ndate] <= hcore->getCurrentDate())
+        ++ndate;
+    std::vector<std::string> vars = hcore->getSubscriptionDatums(id);
+
+    // Rows are ordered as in fetchvars: by variable, then date
+    int nv = vars.size();
+    int nrow = nv * ndate;
+    CharacterVector varout(nrow), unitsout(nrow);
+    NumericVector yearout(nrow), valueout(nrow);
+    int row = 0;
+    for(int j=0; j<nv; ++j) {
+        for(int i=0; i<ndate; ++i, ++row) {
+            yearout[row] = dates[i];
+            varout[row] = vars[j];
+            valueout[row] = (*values)[i*nv + j];
+            unitsout[row] = Hector::unitval(0.0, units[j]).unitsName();
+        }
+    }
+
+    return DataFrame::create(Named("year")=yearout, Named("variable")=varout,
+                             Named("value")=valueout, Named("units")=unitsout,
+                             Named("stringsAsFactors")=false);
+}
+
 //' Retrieve the current list of biomes for a Hector instance
 //'
 //' @param core Handle to the Hector instance from which to retrieve
@@ -220,6 +472,21 @@ Environment create_biome_impl(Environment core, std::string biome)
     return core;
 }
 
+//' Create several biomes at once
+//'
+//' This is faster than creating them one at a time, because the
+//' model's time series are restructured only once.
+//'
+//' @param core Handle to the Hector instance that is to be run.
+//' @param biomes (character) Names of new biomes
+// [[Rcpp::export]]
+Environment create_biomes_impl(Environment core, std::vector<std::string> biomes)
+{
+    Hector::Core *hcore = gethcore(core);
+    hcore->createBiomes(biomes);
+    return core;
+}
+
 //' Delete a biome
 //'
 //' @param core Handle to the Hector instance that is to be run.
@@ -358,6 +625,411 @@ DataFrame sendmessage(Environment core, String msgtype, String capability, Numer
     return result;
 }
 
+// This is the C++ implementation of runscenarios.  It should only ever be
+// called from the `runscenarios` wrapper function.  Each scenario is a data
+// frame with columns year, variable, value, and units.
+// [[Rcpp::export]]
+DataFrame runscenarios_impl(Environment core, List scenarios, std::vector<std::string> vars,
+                            NumericVector dates, double runtodate)
+{
+    Hector::Core *hcore = gethcore(core);
+    Hector::ScenarioTree tree(hcore);
+    CharacterVector names = scenarios.names();
+
+    try {
+        for(int i=0; i<scenarios.size(); ++i) {
+            int s = tree.addScenario(Rcpp::as<std::string>(names[i]));
+            DataFrame inputs = Rcpp::as<DataFrame>(scenarios[i]);
+            NumericVector year = inputs["year"];
+            CharacterVector variable = inputs["variable"];
+            NumericVector value = inputs["value"];
+            CharacterVector units = inputs["units"];
+            for(int j=0; j<inputs.nrows(); ++j) {
+                double date = NumericVector::is_na(year[j]) ?
+                    Hector::Core::undefinedIndex() : year[j];
+                Hector::unit_types utype =
+                    Hector::unitval::parseUnitsName(Rcpp::as<std::string>(units[j]));
+                tree.setInput(s, Rcpp::as<std::string>(variable[j]), date,
+                              Hector::unitval(value[j], utype));
+            }
+        }
+
+        std::vector<double> d(dates.begin(), dates.end());
+        tree.run(vars, d, runtodate);
+    }
+    catch(h_exception e) {
+        std::stringstream msg;
+        msg << "Error while running scenarios:  " << e;
+        Rcpp::stop(msg.str());
+    }
+
+    // The core's own inputs have been restored, but not yet applied.
+    if(hcore->changesPending())
+        core["clean"] = false;
+
+    // Rows are ordered as in fetchvars: by variable, then date, for each scenario
+    int nv = vars.size();
+    int nrow = tree.size() * dates.size() * nv;
+    CharacterVector scenarioout(nrow), varout(nrow), unitsout(nrow);
+    NumericVector yearout(nrow), valueout(nrow);
+    int row = 0;
+    for(int s=0; s<int(tree.size()); ++s) {
+        const std::vector<double>& values = tree.getValues(s);
+        for(int j=0; j<nv; ++j) {
+            for(int i=0; i<dates.size(); ++i, ++row) {
+                scenarioout[row] = tree.getName(s);
+                yearout[row] = dates[i];
+                varout[row] = vars[j];
+                valueout[row] = values[i*nv + j];
+                unitsout[row] = Hector::unitval(0.0, tree.getUnits()[j]).unitsName();
+            }
+        }
+    }
+
+    return DataFrame::create(Named("scenario")=scenarioout, Named("year")=yearout,
+                             Named("variable")=varout, Named("value")=valueout,
+                             Named("units")=unitsout,
+                             Named("stringsAsFactors")=false);
+}
+
+// This is the C++ implementation of runcoupled.  It should only ever be called
+// from the `runcoupled` wrapper function.  The inputs have columns year,
+// variable, value, and units, with each variable given for consecutive years.
+// [[Rcpp::export]]
+DataFrame runcoupled_impl(Environment core, DataFrame inputs, std::vector<std::string> vars,
+                          double runtodate)
+{
+    Hector::Core *hcore = gethcore(core);
+    clean_core(core, hcore);
+
+    double start = hcore->getCurrentDate();
+    double end = runtodate > 0 ? runtodate : hcore->getEndDate();
+    if(end < start) {
+        std::stringstream msg;
+        msg << "Requested run date " << end << " is prior to the current date of "
+            << start << ". Run reset() to reset to an earlier date.";
+        Rcpp::stop(msg.str());
+    }
+
+    // Gather each input variable's values into its own buffer.
+    NumericVector year = inputs["year"];
+    CharacterVector variable = inputs["variable"];
+    NumericVector value = inputs["value"];
+    CharacterVector units = inputs["units"];
+    std::map<std::string, std::vector<double> > invalues;
+    std::map<std::string, double> instart;
+    std::map<std::string, std::string> inunits;
+    for(int i=0; i<inputs.nrows(); ++i) {
+        std::string v = Rcpp::as<std::string>(variable[i]);
+        std::vector<double>& buf = invalues[v];
+        if(buf.empty()) {
+            instart[v] = year[i];
+            inunits[v] = Rcpp::as<std::string>(units[i]);
+        }
+        else if(year[i] != instart[v] + buf.size()) {
+            Rcpp::stop("Inputs for " + v + " must be given for consecutive years.");
+        }
+        buf.push_back(value[i]);
+    }
+
+    int nv = vars.size();
+    // The last step may overshoot the run date when steps are several years.
+    int ndate = int(end - start) + hcore->getTimeStep();
+    std::vector<std::vector<double> > outvalues(nv, std::vector<double>(ndate));
+    std::vector<Hector::unit_types> outunits(nv);
+    std::vector<double> stepdates;
+    try {
+        for(std::map<std::string, std::vector<double> >::const_iterator it = invalues.begin();
+            it != invalues.end(); ++it) {
+            hcore->registerInputBuffer(it->first, &it->second[0], it->second.size(),
+                                       instart[it->first],
+                                       Hector::unitval::parseUnitsName(inunits[it->first]));
+        }
+        for(int j=0; j<nv; ++j) {
+            outunits[j] = hcore->sendMessage(M_GETDATA, vars[j]).units();
+            hcore->registerOutputBuffer(vars[j], &outvalues[j][0], ndate, start + 1.0,
+                                        outunits[j]);
+        }
+
+        while(hcore->getCurrentDate() < end) {
+            stepdates.push_back(hcore->step());
+        }
+        hcore->clearCouplingBuffers();
+    }
+    catch(h_exception e) {
+        hcore->clearCouplingBuffers();
+        std::stringstream msg;
+        msg << "Error while running hector:  " << e;
+        Rcpp::stop(msg.str());
+    }
+
+    // Rows are ordered as in fetchvars: by variable, then date.  With
+    // multi-year time steps, only the dates stepped to have values.
+    int nstep = stepdates.size();
+    int nrow = nv * nstep;
+    CharacterVector varout(nrow), unitsout(nrow);
+    NumericVector yearout(nrow), valueout(nrow);
+    int row = 0;
+    for(int j=0; j<nv; ++j) {
+        for(int i=0; i<nstep; ++i, ++row) {
+            yearout[row] = stepdates[i];
+            varout[row] = vars[j];
+            valueout[row] = outvalues[j][int(stepdates[i] - start - 1.0)];
+            unitsout[row] = Hector::unitval(0.0, outunits[j]).unitsName();
+        }
+    }
+
+    return DataFrame::create(Named("year")=yearout, Named("variable")=varout,
+                             Named("value")=valueout, Named("units")=unitsout,
+                             Named("stringsAsFactors")=false);
+}
+
+// This is the C++ implementation of calibrate.  It should only ever be called
+// from the `calibrate` wrapper function.
+// [[Rcpp::export]]
+List calibrate_impl(Environment core, DataFrame parameters, DataFrame targets,
+                    NumericVector weights, int maxeval, double tol)
+{
+    Hector::Core *hcore = gethcore(core);
+    Hector::Calibrator cal(hcore);
+    cal.setMaxEvaluations(maxeval);
+    cal.setTolerance(tol);
+
+    CharacterVector pvar = parameters["variable"];
+    NumericVector lower = parameters["lower"];
+    NumericVector upper = parameters["upper"];
+    CharacterVector punits = parameters["units"];
+
+    NumericVector year = targets["year"];
+    CharacterVector tvar = targets["variable"];
+    NumericVector value = targets["value"];
+    CharacterVector tunits = targets["units"];
+
+    double objective;
+    try {
+        for(int i=0; i<pvar.size(); ++i) {
+            cal.addParameter(Rcpp::as<std::string>(pvar[i]), lower[i], upper[i],
+                             Hector::unitval::parseUnitsName(Rcpp::as<std::string>(punits[i])));
+        }
+
+        // Collect each variable's observations into one series, keeping the
+        // variables in order of first appearance.
+        std::vector<std::string> order;
+        std::map<std::string, std::vector<double> > dates;
+        std::map<std::string, std::vector<Hector::unitval> > values;
+        for(int i=0; i<tvar.size(); ++i) {
+            std::string v = Rcpp::as<std::string>(tvar[i]);
+            if(!dates.count(v))
+                order.push_back(v);
+            Hector::unit_types utype = CharacterVector::is_na(tunits[i]) ? Hector::U_UNDEFINED :
+                Hector::unitval::parseUnitsName(Rcpp::as<std::string>(tunits[i]));
+            dates[v].push_back(year[i]);
+            values[v].push_back(Hector::unitval(value[i], utype));
+        }
+        for(size_t i=0; i<order.size(); ++i) {
+            double w = 1.0;
+            if(weights.containsElementNamed(order[i].c_str()))
+                w = weights[order[i]];
+            cal.addTarget(order[i], dates[order[i]], values[order[i]], w);
+        }
+
+        objective = cal.calibrate();
+    }
+    catch(h_exception e) {
+        std::stringstream msg;
+        msg << "Error while calibrating:  " << e;
+        Rcpp::stop(msg.str());
+    }
+
+    // The calibrated run has been done, so nothing is left to reset.
+    core["clean"] = true;
+
+    DataFrame best =
+        DataFrame::create(Named("variable")=pvar,
+                          Named("value")=NumericVector(cal.getBestValues().begin(),
+                                                       cal.getBestValues().end()),
+                          Named("units")=punits,
+                          Named("stringsAsFactors")=false);
+    return List::create(Named("parameters")=best, Named("objective")=objective,
+                        Named("evaluations")=cal.getEvaluations(),
+                        Named("converged")=cal.converged());
+}
+
+// This is the C++ implementation of sensitivity.  It should only ever be
+// called from the `sensitivity` wrapper function.
+// [[Rcpp::export]]
+DataFrame sensitivity_impl(String inifile, DataFrame parameters, std::vector<std::string> vars,
+                           NumericVector dates, String method, int n, int levels,
+                           int threads, double seed)
+{
+    Hector::SensitivityAnalysis sa(inifile);
+    CharacterVector pvar = parameters["variable"];
+    NumericVector lower = parameters["lower"];
+    NumericVector upper = parameters["upper"];
+    CharacterVector punits = parameters["units"];
+
+    std::string methodstr = method;
+    std::vector<Hector::SensitivityAnalysis::Index> indices;
+    std::vector<std::string> indexnames;
+    try {
+        for(int i=0; i<pvar.size(); ++i) {
+            sa.addParameter(Rcpp::as<std::string>(pvar[i]), lower[i], upper[i],
+                            Hector::unitval::parseUnitsName(Rcpp::as<std::string>(punits[i])));
+        }
+        for(size_t j=0; j<vars.size(); ++j)
+            sa.addOutput(vars[j]);
+        sa.setDates(std::vector<double>(dates.begin(), dates.end()));
+
+        if(methodstr == "sobol") {
+            sa.runSobol(n, threads, (unsigned long)seed);
+            indices.push_back(Hector::SensitivityAnalysis::FIRST_ORDER);
+            indices.push_back(Hector::SensitivityAnalysis::TOTAL_ORDER);
+            indexnames.push_back("S1");
+            indexnames.push_back("ST");
+        }
+        else if(methodstr == "morris") {
+            sa.runMorris(n, levels, threads, (unsigned long)seed);
+            indices.push_back(Hector::SensitivityAnalysis::MU);
+            indices.push_back(Hector::SensitivityAnalysis::MU_STAR);
+            indices.push_back(Hector::SensitivityAnalysis::SIGMA);
+            indexnames.push_back("mu");
+            indexnames.push_back("mustar");
+            indexnames.push_back("sigma");
+        }
+        else {
+            Rcpp::stop("Unknown sensitivity method: " + methodstr);
+        }
+    }
+    catch(h_exception e) {
+        std::stringstream msg;
+        msg << "Error in sensitivity analysis:  " << e;
+        Rcpp::stop(msg.str());
+    }
+
+    // One row per variable, date, parameter, and index, in that order
+    int np = pvar.size();
+    int ni = indices.size();
+    int nrow = vars.size() * dates.size() * np * ni;
+    CharacterVector varout(nrow), paramout(nrow), indexout(nrow);
+    NumericVector yearout(nrow), valueout(nrow);
+    int row = 0;
+    for(size_t j=0; j<vars.size(); ++j) {
+        for(int d=0; d<dates.size(); ++d) {
+            for(int p=0; p<np; ++p) {
+                for(int i=0; i<ni; ++i, ++row) {
+                    varout[row] = vars[j];
+                    yearout[row] = dates[d];
+                    paramout[row] = pvar[p];
+                    indexout[row] = indexnames[i];
+                    valueout[row] = sa.getIndex(indices[i], p, j, d);
+                }
+            }
+        }
+    }
+
+    return DataFrame::create(Named("variable")=varout, Named("year")=yearout,
+                             Named("parameter")=paramout, Named("index")=indexout,
+                             Named("value")=valueout,
+                             Named("stringsAsFactors")=false);
+}
+
+// This is the C++ implementation of runensemble.  It should only ever be
+// called from the `runensemble` wrapper function.  Each column of members
+// is a parameter; thresholds is a named list of thresholds by variable.
+// [[Rcpp::export]]
+DataFrame runensemble_impl(String inifile, DataFrame members, CharacterVector units,
+                           std::vector<std::string> vars, NumericVector dates,
+                           NumericVector probs, List thresholds, int threads,
+                           double compression, String journal, String output,
+                           int chunksize)
+{
+    std::vector<double> d(dates.begin(), dates.end());
+    Hector::EnsembleStats stats(vars, d, compression);
+    Hector::EnsembleRunner ensemble(inifile);
+    CharacterVector params = members.names();
+    CharacterVector thrvars = thresholds.names();
+
+    try {
+        for(int i=0; i<params.size(); ++i) {
+            ensemble.addParameter(Rcpp::as<std::string>(params[i]),
+                                  Hector::unitval::parseUnitsName(Rcpp::as<std::string>(units[i])));
+        }
+        std::vector<NumericVector> columns;
+        for(int i=0; i<params.size(); ++i)
+            columns.push_back(members[i]);
+        std::vector<double> values(params.size());
+        for(int m=0; m<members.nrows(); ++m) {
+            for(int i=0; i<params.size(); ++i)
+                values[i] = columns[i][m];
+            ensemble.addMember(values);
+        }
+        for(int i=0; i<thresholds.size(); ++i) {
+            NumericVector thr = thresholds[i];
+            for(int j=0; j<thr.size(); ++j)
+                stats.addThreshold(Rcpp::as<std::string>(thrvars[i]), thr[j]);
+        }
+
+        ensemble.setChunkSize(chunksize);
+        ensemble.setJournal(journal);
+        ensemble.setOutputFile(output);
+        ensemble.run(stats, threads);
+    }
+    catch(h_exception e) {
+        std::stringstream msg;
+        msg << "Error while running ensemble:  " << e;
+        Rcpp::stop(msg.str());
+    }
+
+    // One row per variable, date, and statistic, in that order
+    std::vector<std::string> varout, statout;
+    std::vector<double> yearout, valueout;
+    for(size_t o=0; o<vars.size(); ++o) {
+        const std::vector<double>& thr = stats.getThresholds(o);
+        for(size_t t=0; t<d.size(); ++t) {
+            std::vector<std::string> names;
+            std::vector<double> values;
+            names.push_back("mean");
+            values.push_back(stats.getMean(o, t));
+            names.push_back("sd");
+            values.push_back(std::sqrt(stats.getVariance(o, t)));
+            for(int q=0; q<probs.size(); ++q) {
+                std::stringstream name;
+                name << "q" << probs[q];
+                names.push_back(name.str());
+                values.push_back(stats.getQuantile(o, t, probs[q]));
+            }
+            for(size_t j=0; j<thr.size(); ++j) {
+                std::stringstream name;
+                name << "P>" << thr[j];
+                names.push_back(name.str());
+                values.push_back(stats.getExceedance(o, t, j));
+            }
+            for(size_t i=0; i<names.size(); ++i) {
+                varout.push_back(vars[o]);
+                yearout.push_back(d[t]);
+                statout.push_back(names[i]);
+                valueout.push_back(values[i]);
+            }
+        }
+    }
+
+    // Members that failed, counting from 0 as in the output file
+    const std::vector<Hector::EnsembleRunner::failure>& failures = ensemble.getFailures();
+    std::vector<double> failedout;
+    std::vector<std::string> reasonout;
+    for(size_t i=0; i<failures.size(); ++i) {
+        failedout.push_back(failures[i].member);
+        reasonout.push_back(failures[i].reason);
+    }
+
+    DataFrame rv = DataFrame::create(Named("variable")=varout, Named("year")=yearout,
+                                     Named("statistic")=statout, Named("value")=valueout,
+                                     Named("stringsAsFactors")=false);
+    rv.attr("failed") = DataFrame::create(Named("member")=failedout, Named("reason")=reasonout,
+                                          Named("stringsAsFactors")=false);
+    return rv;
+}
+
 // helper for isactive()
 // [[Rcpp::export]]
 bool chk_core_valid(Environment core)
@@ -367,3 +1039,19 @@ bool chk_core_valid(Environment core)
 
     return hcore != NULL;
 }
+
+// helper for testing that cores share their input series
+// [[Rcpp::export]]
+bool shares_input(Environment core, Environment other, String var)
+{
+    Hector::Core *hcore = gethcore(core);
+    Hector::Core *hother = gethcore(other);
+    try {
+        return hcore->sharesInput(var, *hother);
+    }
+    catch(h_exception e) {
+        std::stringstream msg;
+        msg << "Error comparing inputs:  " << e;
+        Rcpp::stop(msg.str());
+    }
+}
@@ -0,0 +1,268 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+/*
+ *  scenario_tree.cpp
+ *  hector
+ *
+ */
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+#include "scenario_tree.hpp"
+#include "component_data.hpp"
+#include "message_data.hpp"
+
+namespace Hector {
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/*! \brief Constructor
+ *  \param core The core to run the scenarios on.  It must have been prepared
+ *         to run, and its inputs are the ones the scenarios replace.
+ */
+ScenarioTree::ScenarioTree( Core* core ) : core( core )
+{
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add a scenario
+ *  \param name The scenario name.
+ *  \return The scenario's index, for setInput() and the accessors.
+ */
+int ScenarioTree::addScenario( const string& name )
+{
+    scenario s;
+    s.name = name;
+    scenarios.push_back( s );
+    return int( scenarios.size() ) - 1;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Set an input of a scenario
+ *  \param scenario The scenario index.
+ *  \param datum The input name (e.g. D_FFI_EMISSIONS).
+ *  \param date The date, or Core::undefinedIndex() for a parameter.
+ *  \param value The value.
+ *  \exception h_exception If there is no such scenario.
+ */
+void ScenarioTree::setInput( int scenario, const string& datum, double date,
+                             const unitval& value ) throw ( h_exception )
+{
+    H_ASSERT( scenario >= 0 && size_t( scenario ) < scenarios.size(), "no such scenario" );
+    scenarios[ scenario ].inputs[ input_key( datum, date ) ] = value;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Read the core's values of the inputs the scenarios set
+ *  \details Only inputs not seen before are read, so this must happen while
+ *           the core holds its own inputs.
+ *  \exception h_exception If the core has no value for an input that some
+ *              scenarios leave unset.
+ */
+void ScenarioTree::readBaseInputs() throw ( h_exception )
+{
+    for( vector<scenario>::const_iterator s = scenarios.begin(); s != scenarios.end(); ++s ) {
+        for( map<input_key, unitval>::const_iterator it = s->inputs.begin(); it != s->inputs.end(); ++it ) {
+            const input_key& key = it->first;
+            if( baseInputs.count( key ) || baseMissing.count( key ) )
+                continue;
+            try {
+                baseInputs[ key ] = core->sendMessage( M_GETDATA, key.first, message_data( key.second ) );
+            }
+            catch( h_exception& e ) {
+                baseMissing.insert( key );
+            }
+        }
+    }
+
+    for( set<input_key>::const_iterator key = baseMissing.begin(); key != baseMissing.end(); ++key ) {
+        for( vector<scenario>::const_iterator s = scenarios.begin(); s != scenarios.end(); ++s ) {
+            if( !s->inputs.count( *key ) ) {
+                ostringstream msg;
+                msg << "Scenario " << s->name << " has no value for " << key->first
+                    << " at " << key->second << ", and neither has the model";
+                H_THROW( msg.str() );
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief The value an input takes in a scenario
+ *  \param s The scenario, or NULL for the core's own value.
+ *  \param key The input and date.
+ *  \return The value, or NULL if there is none.
+ */
+const unitval* ScenarioTree::inputValue( const scenario* s, const input_key& key ) const
+{
+    if( s ) {
+        map<input_key, unitval>::const_iterator it = s->inputs.find( key );
+        if( it != s->inputs.end() )
+            return &it->second;
+    }
+    map<input_key, unitval>::const_iterator it = baseInputs.find( key );
+    return it == baseInputs.end() ? NULL : &it->second;
+}
+
+//! Whether two input values are the same, units included
+static bool same_value( const unitval* a, const unitval* b )
+{
+    if( !a || !b )
+        return a == b;
+    return a->units() == b->units() && a->value( a->units() ) == b->value( b->units() );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief The first date at which the scenarios' inputs differ
+ *  \return The date, or the largest double if the scenarios are all alike.
+ *          Scenarios that differ in a parameter (which has no date) share no
+ *          history, and the start date is returned.
+ *  \exception h_exception See readBaseInputs().
+ */
+double ScenarioTree::getForkDate() throw ( h_exception )
+{
+    readBaseInputs();
+
+    double fork = numeric_limits<double>::max();
+    set<input_key> keys( baseMissing );
+    for( map<input_key, unitval>::const_iterator it = baseInputs.begin(); it != baseInputs.end(); ++it )
+        keys.insert( it->first );
+    for( set<input_key>::const_iterator key = keys.begin(); key != keys.end(); ++key ) {
+        const unitval* first = inputValue( &scenarios.front(), *key );
+        for( size_t i = 1; i < scenarios.size(); ++i ) {
+            if( !same_value( first, inputValue( &scenarios[ i ], *key ) ) ) {
+                fork = min( fork, key->second );
+                break;
+            }
+        }
+    }
+    if( fork == Core::undefinedIndex() )
+        fork = core->getStartDate();
+    return fork;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Send a scenario's inputs in a range of dates to the core
+ *  \details Parameters (inputs without a date) are sent whatever the range,
+ *           since they hold from the start of the run.
+ *  \param s The scenario, or NULL for the core's own values.
+ *  \param from First date to send.
+ *  \param to Dates before this one are sent.
+ *  \param current The values the core holds (NULL where it has none).  Only
+ *         inputs that change are sent, so the core invalidates no more of
+ *         the run than it must.
+ */
+void ScenarioTree::applyInputs( const scenario* s, double from, double to,
+                                map<input_key, const unitval*>& current ) throw ( h_exception )
+{
+    for( map<input_key, const unitval*>::iterator it = current.begin(); it != current.end(); ++it ) {
+        const input_key& key = it->first;
+        if( key.second != Core::undefinedIndex() && ( key.second < from || key.second >= to ) )
+            continue;
+        const unitval* value = inputValue( s, key );
+        if( !value || same_value( value, it->second ) )
+            continue;
+        core->sendMessage( M_SETDATA, key.first, message_data( key.second, *value ) );
+        it->second = value;
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Record a scenario's outputs once it has run
+ */
+void ScenarioTree::collectOutputs( scenario& s, const vector<string>& outputs,
+                                   const vector<double>& dates ) throw ( h_exception )
+{
+    s.values.clear();
+    s.values.reserve( outputs.size() * dates.size() );
+    units.assign( outputs.size(), U_UNDEFINED );
+    for( size_t i = 0; i < dates.size(); ++i ) {
+        for( size_t j = 0; j < outputs.size(); ++j ) {
+            const unitval v = core->sendMessage( M_GETDATA, outputs[ j ], message_data( dates[ i ] ) );
+            s.values.push_back( v.value( v.units() ) );
+            units[ j ] = v.units();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Run every scenario and record its outputs
+ *
+ *  \details The model is run once through the last time step before the fork
+ *           date, with the inputs all the scenarios share.  Each scenario
+ *           then sets its remaining inputs and runs on from the last date
+ *           its inputs leave valid.  Afterwards the core gets its own inputs
+ *           back (except those it had no value for); they are applied by the
+ *           core's next applyChanges().
+ *
+ *  \param outputs The output names (e.g. D_GLOBAL_TEMP).
+ *  \param dates The dates to record them at.
+ *  \param runtodate Date to run to.  Default (<0) is the end date.
+ *  \exception h_exception If a run fails.  The core is left with the inputs
+ *              of the scenario that failed.
+ *  \sa getValues
+ */
+void ScenarioTree::run( const vector<string>& outputs, const vector<double>& dates,
+                        double runtodate ) throw ( h_exception )
+{
+    H_ASSERT( !scenarios.empty(), "no scenarios to run" );
+    if( runtodate < 0.0 )
+        runtodate = core->getEndDate();
+
+    const double fork = getForkDate();
+    map<input_key, const unitval*> current;
+    for( map<input_key, unitval>::const_iterator it = baseInputs.begin(); it != baseInputs.end(); ++it )
+        current[ it->first ] = &it->second;
+    for( set<input_key>::const_iterator key = baseMissing.begin(); key != baseMissing.end(); ++key )
+        current[ *key ] = NULL;
+
+    // The shared history
+    applyInputs( &scenarios.front(), -numeric_limits<double>::max(), fork, current );
+    if( core->changesPending() )
+        core->applyChanges();
+    const double shared = min( runtodate, fork - 1.0 );
+    if( shared > core->getCurrentDate() )
+        core->run( shared );
+
+    for( vector<scenario>::iterator s = scenarios.begin(); s != scenarios.end(); ++s ) {
+        applyInputs( &*s, fork, numeric_limits<double>::max(), current );
+        if( core->changesPending() )
+            core->applyChanges();
+        if( runtodate > core->getCurrentDate() )
+            core->run( runtodate );
+        collectOutputs( *s, outputs, dates );
+    }
+
+    applyInputs( NULL, -numeric_limits<double>::max(), numeric_limits<double>::max(), current );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief A scenario's name
+ *  \param scenario The scenario index.
+ */
+const string& ScenarioTree::getName( int scenario ) const throw ( h_exception )
+{
+    H_ASSERT( scenario >= 0 && size_t( scenario ) < scenarios.size(), "no such scenario" );
+    return scenarios[ scenario ].name;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief A scenario's outputs from the last run()
+ *  \param scenario The scenario index.
+ *  \return One row per date, each with one value per output, in the order
+ *          they were given to run().  Units are given by getUnits().
+ */
+const vector<double>& ScenarioTree::getValues( int scenario ) const throw ( h_exception )
+{
+    H_ASSERT( scenario >= 0 && size_t( scenario ) < scenarios.size(), "no such scenario" );
+    return scenarios[ scenario ].values;
+}
+
+}
@@ -0,0 +1,304 @@
+/* Hector -- A Simple Climate Model
+   Copyright (C) 2014-2015  Battelle Memorial Institute
+
+   Please see the accompanying file LICENSE.md for additional licensing
+   information.
+*/
+/*
+ *  sensitivity.cpp
+ *  hector
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "sensitivity.hpp"
+#include "component_data.hpp"
+#include "message_data.hpp"
+
+namespace Hector {
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/*! \brief Constructor
+ *  \param inifile The input file the model is set up from.
+ */
+SensitivityAnalysis::SensitivityAnalysis( const string& inifile )
+: inifile( inifile ), runs( 0 )
+{
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add a parameter to vary
+ *  \param datum The parameter name (e.g. D_ECS).
+ *  \param lower Lower bound.
+ *  \param upper Upper bound.
+ *  \param units Units of the bounds.
+ *  \exception h_exception If the bounds are empty.
+ */
+void SensitivityAnalysis::addParameter( const string& datum, double lower, double upper,
+                                        unit_types units ) throw ( h_exception )
+{
+    H_ASSERT( lower < upper, "lower bound of " + datum + " must be below the upper bound" );
+    parameter p;
+    p.datum = datum;
+    p.lower = lower;
+    p.upper = upper;
+    p.units = units;
+    parameters.push_back( p );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Add an output to analyze
+ *  \param datum The output name (e.g. D_GLOBAL_TEMP).  It is analyzed at each
+ *         of the dates given to setDates().
+ */
+void SensitivityAnalysis::addOutput( const string& datum )
+{
+    outputs.push_back( datum );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Check that there is something to analyze
+ */
+void SensitivityAnalysis::checkSetup() const throw ( h_exception )
+{
+    H_ASSERT( !parameters.empty(), "no parameters to analyze" );
+    H_ASSERT( !outputs.empty() && !dates.empty(), "no outputs to analyze" );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Run the model at one point of the design
+ *  \param core The core to run.
+ *  \param x The parameter values, scaled to [0,1] between their bounds.
+ *  \param out The outputs, [ output * dates + date ], are written here.
+ */
+void SensitivityAnalysis::evaluate( Core* core, const double* x, double* out ) const throw ( h_exception )
+{
+    for( size_t i = 0; i < parameters.size(); ++i ) {
+        const parameter& p = parameters[ i ];
+        core->sendMessage( M_SETDATA, p.datum,
+                           message_data( unitval( p.lower + x[ i ] * ( p.upper - p.lower ), p.units ) ) );
+    }
+    if( core->changesPending() )
+        core->applyChanges();
+    const double end = *max_element( dates.begin(), dates.end() );
+    if( core->getCurrentDate() < end )
+        core->run( end );
+
+    for( size_t j = 0; j < outputs.size(); ++j ) {
+        for( size_t d = 0; d < dates.size(); ++d ) {
+            const unitval v = core->sendMessage( M_GETDATA, outputs[ j ], message_data( dates[ d ] ) );
+            out[ j * dates.size() + d ] = v.value( v.units() );
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Estimate Sobol first- and total-order indices
+ *  \param samples Number of rows of each of the sample matrices A and B.
+ *  \param threads Number of threads to run the model in.
+ *  \param seed Seed for the samples.
+ *  \exception h_exception If a run fails.
+ */
+void SensitivityAnalysis::runSobol( int samples, int threads, unsigned long seed ) throw ( h_exception )
+{
+    checkSetup();
+    H_ASSERT( samples > 0 && threads > 0, "samples and threads must be positive" );
+    const size_t k = parameters.size();
+    const size_t m = outputSize();
+    results.clear();
+
+    // Rows of A and B, interleaved
+    mt19937_64 rng( seed );
+    uniform_real_distribution<double> uniform( 0.0, 1.0 );
+    vector<double> design( 2 * samples * k );
+    for( size_t i = 0; i < design.size(); ++i )
+        design[ i ] = uniform( rng );
+
+    // Outputs are shifted by their values at the first sample, which keeps
+    // the sums of squares from losing precision.
+    vector<double> shift( m );
+    Core* core = pool.acquire( inifile );
+    try {
+        evaluate( core, &design[ 0 ], &shift[ 0 ] );
+    }
+    catch( h_exception& e ) {
+        pool.release( inifile, core, false );
+        throw;
+    }
+    pool.release( inifile, core, true );
+
+    // Per-thread sums: of the outputs and their squares over A and B, and
+    // per parameter of fB*(fABi-fA) and (fA-fABi)^2
+    vector<vector<double> > sum( threads, vector<double>( m, 0.0 ) );
+    vector<vector<double> > sumsq( threads, vector<double>( m, 0.0 ) );
+    vector<vector<double> > first( threads, vector<double>( m * k, 0.0 ) );
+    vector<vector<double> > total( threads, vector<double>( m * k, 0.0 ) );
+
+    pool.forEach( inifile, samples, threads, [&]( Core* core, int j, int t ) {
+        const double* a = &design[ 2 * j * k ];
+        const double* b = a + k;
+        vector<double> fA( m ), fB( m ), fAB( m ), ab( a, a + k );
+        evaluate( core, a, &fA[ 0 ] );
+        evaluate( core, b, &fB[ 0 ] );
+        for( size_t o = 0; o < m; ++o ) {
+            fA[ o ] -= shift[ o ];
+            fB[ o ] -= shift[ o ];
+            sum[ t ][ o ] += fA[ o ] + fB[ o ];
+            sumsq[ t ][ o ] += fA[ o ] * fA[ o ] + fB[ o ] * fB[ o ];
+        }
+        for( size_t i = 0; i < k; ++i ) {
+            ab[ i ] = b[ i ];
+            evaluate( core, &ab[ 0 ], &fAB[ 0 ] );
+            ab[ i ] = a[ i ];
+            for( size_t o = 0; o < m; ++o ) {
+                const double diff = fAB[ o ] - shift[ o ] - fA[ o ];
+                first[ t ][ o * k + i ] += fB[ o ] * diff;
+                total[ t ][ o * k + i ] += diff * diff;
+            }
+        }
+        return true;
+    } );
+
+    for( int t = 1; t < threads; ++t ) {
+        for( size_t o = 0; o < m; ++o ) {
+            sum[ 0 ][ o ] += sum[ t ][ o ];
+            sumsq[ 0 ][ o ] += sumsq[ t ][ o ];
+        }
+        for( size_t o = 0; o < m * k; ++o ) {
+            first[ 0 ][ o ] += first[ t ][ o ];
+            total[ 0 ][ o ] += total[ t ][ o ];
+        }
+    }
+
+    vector<double>& s1 = results[ FIRST_ORDER ];
+    vector<double>& st = results[ TOTAL_ORDER ];
+    s1.resize( m * k );
+    st.resize( m * k );
+    for( size_t o = 0; o < m; ++o ) {
+        const double mean = sum[ 0 ][ o ] / ( 2.0 * samples );
+        const double var = sumsq[ 0 ][ o ] / ( 2.0 * samples ) - mean * mean;
+        for( size_t i = 0; i < k; ++i ) {
+            if( var > 0.0 ) {
+                s1[ o * k + i ] = first[ 0 ][ o * k + i ] / samples / var;
+                st[ o * k + i ] = total[ 0 ][ o * k + i ] / ( 2.0 * samples ) / var;
+            }
+            else {
+                s1[ o * k + i ] = st[ o * k + i ] = numeric_limits<double>::quiet_NaN();
+            }
+        }
+    }
+    runs = samples * int( k + 2 ) + 1;
+}
+
+//------------------------------------------------------------------------------
+/*! \brief Estimate Morris elementary effect statistics
+ *  \param trajectories Number of trajectories.
+ *  \param levels Number of grid levels for each parameter, which must be
+ *         even.  The step is levels/(2*(levels-1)) of the parameter's range,
+ *         so every level has a step up or down that stays on the grid.
+ *  \param threads Number of threads to run the model in.
+ *  \param seed Seed for the trajectories.
+ *  \exception h_exception If a run fails.
+ */
+void SensitivityAnalysis::runMorris( int trajectories, int levels, int threads,
+                                     unsigned long seed ) throw ( h_exception )
+{
+    checkSetup();
+    H_ASSERT( trajectories > 0 && threads > 0, "trajectories and threads must be positive" );
+    H_ASSERT( levels >= 2 && levels % 2 == 0, "Morris designs need an even number of levels" );
+    const size_t k = parameters.size();
+    const size_t m = outputSize();
+    const double delta = levels / ( 2.0 * ( levels - 1 ) );
+    results.clear();
+
+    // Each trajectory is a start point on the grid and the order in which
+    // the parameters are stepped.  A step goes up unless that would leave
+    // the range.
+    mt19937_64 rng( seed );
+    uniform_int_distribution<int> level( 0, levels - 1 );
+    vector<double> start( trajectories * k );
+    vector<size_t> order( trajectories * k );
+    for( int r = 0; r < trajectories; ++r ) {
+        for( size_t i = 0; i < k; ++i ) {
+            start[ r * k + i ] = double( level( rng ) ) / ( levels - 1 );
+            order[ r * k + i ] = i;
+        }
+        shuffle( order.begin() + r * k, order.begin() + ( r + 1 ) * k, rng );
+    }
+
+    // Per-thread sums of the effects, their absolute values, and squares
+    vector<vector<double> > sum( threads, vector<double>( m * k, 0.0 ) );
+    vector<vector<double> > sumabs( threads, vector<double>( m * k, 0.0 ) );
+    vector<vector<double> > sumsq( threads, vector<double>( m * k, 0.0 ) );
+
+    pool.forEach( inifile, trajectories, threads, [&]( Core* core, int r, int t ) {
+        vector<double> x( start.begin() + r * k, start.begin() + ( r + 1 ) * k );
+        vector<double> f( m ), fnext( m );
+        evaluate( core, &x[ 0 ], &f[ 0 ] );
+        for( size_t s = 0; s < k; ++s ) {
+            const size_t i = order[ r * k + s ];
+            const double step = x[ i ] + delta <= 1.0 ? delta : -delta;
+            x[ i ] += step;
+            evaluate( core, &x[ 0 ], &fnext[ 0 ] );
+            for( size_t o = 0; o < m; ++o ) {
+                const double effect = ( fnext[ o ] - f[ o ] ) / step;
+                sum[ t ][ o * k + i ] += effect;
+                sumabs[ t ][ o * k + i ] += fabs( effect );
+                sumsq[ t ][ o * k + i ] += effect * effect;
+            }
+            f.swap( fnext );
+        }
+        return true;
+    } );
+
+    for( int t = 1; t < threads; ++t ) {
+        for( size_t o = 0; o < m * k; ++o ) {
+            sum[ 0 ][ o ] += sum[ t ][ o ];
+            sumabs[ 0 ][ o ] += sumabs[ t ][ o ];
+            sumsq[ 0 ][ o ] += sumsq[ t ][ o ];
+        }
+    }
+
+    vector<double>& mu = results[ MU ];
+    vector<double>& mustar = results[ MU_STAR ];
+    vector<double>& sigma = results[ SIGMA ];
+    mu.resize( m * k );
+    mustar.resize( m * k );
+    sigma.resize( m * k );
+    for( size_t o = 0; o < m * k; ++o ) {
+        mu[ o ] = sum[ 0 ][ o ] / trajectories;
+        mustar[ o ] = sumabs[ 0 ][ o ] / trajectories;
+        sigma[ o ] = trajectories > 1 ?
+            sqrt( max( 0.0, ( sumsq[ 0 ][ o ] - trajectories * mu[ o ] * mu[ o ] ) / ( trajectories - 1 ) ) ) :
+            numeric_limits<double>::quiet_NaN();
+    }
+    runs = trajectories * int( k + 1 );
+}
+
+//------------------------------------------------------------------------------
+/*! \brief A sensitivity index from the last analysis
+ *  \param index Which index.  Sobol analyses give FIRST_ORDER and TOTAL_ORDER,
+ *         Morris analyses MU, MU_STAR, and SIGMA.
+ *  \param parameter Parameter number, in the order they were added.
+ *  \param output Output number, in the order they were added.
+ *  \param date Date number, in the order given to setDates().
+ *  \return The index.  Sobol indices of outputs that did not vary are NaN.
+ *  \exception h_exception If the last analysis did not compute the index.
+ */
+double SensitivityAnalysis::getIndex( Index index, size_t parameter, size_t output,
+                                      size_t date ) const throw ( h_exception )
+{
+    map<Index, vector<double> >::const_iterator it = results.find( index );
+    H_ASSERT( it != results.end(), "index not computed by the last analysis" );
+    H_ASSERT( parameter < parameters.size() && output < outputs.size() && date < dates.size(),
+              "no such parameter, output, or date" );
+    return it->second[ ( output * dates.size() + date ) * parameters.size() + parameter ];
+}
+
+}
@@ -74,6 +74,8 @@ void SimpleNbox::init( Core* coreptr ) {
 
     // Register our dependencies
     core->registerDependency( D_OCEAN_CFLUX, getComponentName() );
+    // Temperature feeds back on the land fluxes with a one-step lag
+    core->registerLaggedDependency( D_GLOBAL_TEMP, getComponentName() );
 
     // Register the inputs we can receive from outside
     core->registerInput(D_FFI_EMISSIONS, getComponentName());
@@ -92,6 +94,12 @@ void SimpleNbox::init( Core* coreptr ) {
     core->registerInput(D_F_LUCV, getComponentName());
     core->registerInput(D_F_LUCD, getComponentName());
     core->registerInput(D_CO2_CONSTRAIN, getComponentName());
+
+    // CO2 fertilization and temperature effects are switched off during the
+    // spinup, so these only require rerunning from the start date.
+    core->registerInvalidation(D_WARMINGFACTOR, getComponentName(), Core::INVALIDATE_RUN);
+    core->registerInvalidation(D_BETA, getComponentName(), Core::INVALIDATE_RUN);
+    core->registerInvalidation(D_Q10_RH, getComponentName(), Core::INVALIDATE_RUN);
 }
 
 //------------------------------------------------------------------------------
@@ -426,6 +434,12 @@ void SimpleNbox::prepareToRun() throw( h_exception )
         H_LOG( glog, Logger::WARNING ) << "Atmospheric CO2 will be constrained to user-supplied values!" << std::endl;
     }
 
+    // Input data are read-only from here on; share them with other cores
+    ffiEmissions.share();
+    lucEmissions.share();
+    Ftalbedo.share();
+    CO2_constrain.share();
+
     // One-time checks
     for( auto it = biome_list.begin(); it != biome_list.end(); it++ ) {
         H_ASSERT( beta.at( *it ) >= 0.0, "beta < 0" );
@@ -463,6 +477,38 @@ bool SimpleNbox::run_spinup( const int step ) throw ( h_exception )
     return true;        // solver will really be the one signalling
 }
 
+//------------------------------------------------------------------------------
+// documentation is inherited.  Global atmospheric values can be read
+// directly; biome-specific ones have to go through getData, which parses
+// the biome name.
+const unitval* SimpleNbox::getCurrentValuePtr(const std::string& varName) const
+{
+    if( varName == D_ATMOSPHERIC_CO2 )
+        return &Ca;
+    if( varName == D_ATMOSPHERIC_C )
+        return &atmos_c;
+    if( varName == D_ATMOSPHERIC_C_RESIDUAL )
+        return &residual;
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// documentation is inherited.  Only the global emissions are exposed; the
+// biome-specific inputs go through setData, which parses the biome name.
+tseries<unitval>* SimpleNbox::getInputSeriesPtr( const std::string& varName,
+                                                 unit_types& units )
+{
+    if( varName == D_FFI_EMISSIONS ) {
+        units = U_PGC_YR;
+        return &ffiEmissions;
+    }
+    if( varName == D_LUC_EMISSIONS ) {
+        units = U_PGC_YR;
+        return &lucEmissions;
+    }
+    return NULL;
+}
+
 //------------------------------------------------------------------------------
 // documentation is inherited
 unitval SimpleNbox::getData(const std::string& varName,
@@ -1162,45 +1208,65 @@ bool SimpleNbox::has_biome(const std::string& biome) {
 // Create a new biome, and initialize it with zero C pools and fluxes
 // and the same parameters as the most recently created biome.
 void SimpleNbox::createBiome(const std::string& biome)
+{
+    createBiomes(std::vector<std::string>(1, biome));
+}
+
+// Create several new biomes at once. Each is initialized as by
+// `createBiome`, but the time series are restructured in a single
+// pass, rather than once per biome.
+void SimpleNbox::createBiomes(const std::vector<std::string>& biomes)
 {
 
-    H_LOG(logger, Logger::DEBUG) << "Creating new biome '" << biome << "'." << std::endl;
+    H_LOG(logger, Logger::DEBUG) << "Creating " << biomes.size() << " new biomes." << std::endl;
 
-    // Throw an error if the biome already exists
-    std::string errmsg = "Biome '" + biome + "' is already in `biome_list`.";
-    H_ASSERT(!has_biome( biome ), errmsg);
+    // Check all the names before changing anything
+    for (size_t i = 0; i < biomes.size(); i++) {
+        std::string errmsg = "Biome '" + biomes[i] + "' is already in `biome_list`.";
+        H_ASSERT(!has_biome( biomes[i] ), errmsg);
+        errmsg = "Biome '" + biomes[i] + "' is given more than once.";
+        H_ASSERT(std::find(biomes.begin(), biomes.begin() + i, biomes[i]) == biomes.begin() + i, errmsg);
+    }
+    if (biomes.empty())
+        return;
 
     // Initialize new pools
-    veg_c[ biome ] = unitval(0, U_PGC);
-    add_biome_to_ts(veg_c_tv, biome, veg_c.at( biome ));
-    detritus_c[ biome ] = unitval(0, U_PGC);
-    add_biome_to_ts(detritus_c_tv, biome, detritus_c.at( biome ));
-    soil_c[ biome ] = unitval(0, U_PGC);
-    add_biome_to_ts(soil_c_tv, biome, soil_c.at( biome ));
-
-    npp_flux0[ biome ] = unitval(0, U_PGC_YR);
-
-    // Other defaults (these will be re-calculated later)
-    co2fert[ biome ] = 1.0;
-    tempfertd[ biome ] = 1.0;
-    add_biome_to_ts(tempfertd_tv, biome, 1.0);
-    tempferts[ biome ] = 1.0;
-    add_biome_to_ts(tempferts_tv, biome, 1.0);
+    add_biomes_to_ts(veg_c_tv, biomes, unitval(0, U_PGC));
+    add_biomes_to_ts(detritus_c_tv, biomes, unitval(0, U_PGC));
+    add_biomes_to_ts(soil_c_tv, biomes, unitval(0, U_PGC));
+    add_biomes_to_ts(tempfertd_tv, biomes, 1.0);
+    add_biomes_to_ts(tempferts_tv, biomes, 1.0);
 
     std::string last_biome = biome_list.back();
 
-    // Set parameters to same as most recent biome
-    beta[ biome ] = beta[ last_biome ];
-    q10_rh[ biome ] = q10_rh[ last_biome ];
-    warmingfactor[ biome ] = warmingfactor[ last_biome ];
-    f_nppv[ biome ] = f_nppv[ last_biome ];
-    f_nppd[ biome ] = f_nppd[ last_biome ];
-    f_litterd[ biome ] = f_litterd[ last_biome ];
+    for (size_t i = 0; i < biomes.size(); i++) {
+        const std::string& biome = biomes[i];
+
+        veg_c[ biome ] = unitval(0, U_PGC);
+        detritus_c[ biome ] = unitval(0, U_PGC);
+        soil_c[ biome ] = unitval(0, U_PGC);
 
-    // Add to end of biome list
-    biome_list.push_back(biome);
+        npp_flux0[ biome ] = unitval(0, U_PGC_YR);
 
-    H_LOG(logger, Logger::DEBUG) << "Finished creating biome '" << biome << "'." << std::endl;}
+        // Other defaults (these will be re-calculated later)
+        co2fert[ biome ] = 1.0;
+        tempfertd[ biome ] = 1.0;
+        tempferts[ biome ] = 1.0;
+
+        // Set parameters to same as most recent biome
+        beta[ biome ] = beta[ last_biome ];
+        q10_rh[ biome ] = q10_rh[ last_biome ];
+        warmingfactor[ biome ] = warmingfactor[ last_biome ];
+        f_nppv[ biome ] = f_nppv[ last_biome ];
+        f_nppd[ biome ] = f_nppd[ last_biome ];
+        f_litterd[ biome ] = f_litterd[ last_biome ];
+
+        // Add to end of biome list
+        biome_list.push_back(biome);
+    }
+
+    H_LOG(logger, Logger::DEBUG) << "Finished creating " << biomes.size() << " biomes." << std::endl;
+}
 
 // Delete a biome: Remove it from the `biome_list` and `erase` all of
 // the associated parameters.
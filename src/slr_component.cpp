@@ -47,15 +47,27 @@ string slrComponent::getComponentName() const {
 // documentation is inherited
 void slrComponent::init( Core* coreptr ) {
 
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
 
     core = coreptr;
 
+    // Inform core what data we can provide
+    core->registerCapability( D_SL_RC, getComponentName() );
+    core->registerCapability( D_SLR, getComponentName() );
+    core->registerCapability( D_SL_RC_NO_ICE, getComponentName() );
+    core->registerCapability( D_SLR_NO_ICE, getComponentName() );
+
     // Mean global temperature is the only thing used to calculate sea level rise
     // Register our dependencies
     core->registerDependency( D_GLOBAL_TEMP, getComponentName() );
 
+    // The reference period only changes our own outputs
+    core->registerInput( D_SLR_REFPERIOD_LOW, getComponentName() );
+    core->registerInput( D_SLR_REFPERIOD_HIGH, getComponentName() );
+    core->registerInvalidation( D_SLR_REFPERIOD_LOW, getComponentName(), Core::INVALIDATE_DIAGNOSTICS );
+    core->registerInvalidation( D_SLR_REFPERIOD_HIGH, getComponentName(), Core::INVALIDATE_DIAGNOSTICS );
+
 	refperiod_low = 1951;
 	refperiod_high = 1980;
 	normalize_year = 1990;
@@ -76,10 +88,8 @@ unitval slrComponent::sendMessage( const std::string& message,
         return getData( datum, info.date );
 
     } else if( message==M_SETDATA ) {   //! Caller is requesting to set data
-        H_THROW("SLR sendMessage not yet implemented for message=M_SETDATA.");
-        //TODO: call setData below
-        //TODO: change core so that parsing is routed through sendMessage
         //TODO: make setData private
+        setData( datum, info );
 
     } else {                        //! We don't handle any other messages
         H_THROW( "Caller sent unknown message: "+message );
@@ -95,8 +105,20 @@ void slrComponent::setData( const string& varName,
 {
     H_LOG( logger, Logger::DEBUG ) << "Setting " << varName << "[" << data.date << "]=" << data.value_str << std::endl;
 
-    H_THROW( "Unknown variable name while parsing " + getComponentName() + ": "
-            + varName );
+    try {
+        if( varName == D_SLR_REFPERIOD_LOW ) {
+            H_ASSERT( data.date == Core::undefinedIndex(), "date not allowed" );
+            refperiod_low = data.getUnitval( U_UNITLESS ).value( U_UNITLESS );
+        } else if( varName == D_SLR_REFPERIOD_HIGH ) {
+            H_ASSERT( data.date == Core::undefinedIndex(), "date not allowed" );
+            refperiod_high = data.getUnitval( U_UNITLESS ).value( U_UNITLESS );
+        } else {
+            H_THROW( "Unknown variable name while parsing " + getComponentName() + ": "
+                    + varName );
+        }
+    } catch( h_exception& parseException ) {
+        H_RETHROW( parseException, "Could not parse var: "+varName );
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -106,12 +128,9 @@ void slrComponent::prepareToRun() throw ( h_exception ) {
     H_LOG( logger, Logger::DEBUG ) << "prepareToRun " << std::endl;
     oldDate = core->getStartDate();
     H_ASSERT( refperiod_high >= refperiod_low, "bad refperiod" );
+    H_ASSERT( refperiod_low > oldDate, "refperiod must start after the start date" );
 }
 
-//------------------------------------------------------------------------------
-
-tseries<double> tgav_vals;
-
 //------------------------------------------------------------------------------
 /*! \brief compute sea-level rise
  * from Vermeer and Rahmstorf (2009)
@@ -125,6 +144,7 @@ void slrComponent::compute_slr( const double date ) {
     // First need to compute dTdt, the first derivative of the temperature curve
     double dTdt_double = 0.0;
     if( tgav.size() > 2 ) {
+        tseries<double> tgav_vals;
         for( int i=tgav.firstdate(); i<=tgav.lastdate(); i++ ) {
             tgav_vals.set( i, tgav.get( i ).value( U_DEGC ) );
         }
@@ -191,24 +211,41 @@ void slrComponent::run( const double runToDate ) throw ( h_exception ) {
     // Sea level rise is different from some of the other model outputs, because the formula used here to compute it
     // depends on knowing a reference period temperature
 
-    tgav.set( runToDate, core->sendMessage( M_GETDATA, D_GLOBAL_TEMP ) );	// store global temperature
+    // The formula needs a temperature for every year; over a time step of
+    // several years, temperatures in between are interpolated.
+    // When only this component is rerun (see Core::applyChanges), the model
+    // is already past runToDate, so the temperature has to be asked for by date.
+    const unitval tgav_now = runToDate <= core->getCurrentDate() ?
+        core->sendMessage( M_GETDATA, D_GLOBAL_TEMP, message_data( runToDate ) ) :
+        core->sendMessage( M_GETDATA, D_GLOBAL_TEMP );
+    const double tgav_new = tgav_now.value( U_DEGC );
+    const double tgav_old = tgav.exists( oldDate ) ? tgav.get( oldDate ).value( U_DEGC ) : tgav_new;
+
+    for( double year = oldDate+1; year <= runToDate; year += 1 ) {
+        if( year == runToDate ) {
+            tgav.set( year, tgav_now );	// store global temperature
+        } else {
+            const double frac = ( year - oldDate ) / ( runToDate - oldDate );
+            tgav.set( year, unitval( tgav_old + ( tgav_new - tgav_old ) * frac, U_DEGC ) );
+        }
 
-    if( runToDate==refperiod_high ) {	// then compute reference period temperature
-        H_LOG( logger, Logger::DEBUG ) << "Computing reference temperature" << std::endl;
-        double sum = 0.0;
-        for( int i=refperiod_low; i<=refperiod_high; i++ )
-            sum += tgav.get( i ).value( U_DEGC );
-        refperiod_tgav.set( sum / ( refperiod_high - refperiod_low + 1 ), U_DEGC );
-        H_LOG( logger, Logger::DEBUG ) << "Computed reference temperature "
-                                       << refperiod_tgav.value( U_DEGC ) << " (" << refperiod_low << "-" << refperiod_high << ")" << std::endl;
+        if( year==refperiod_high ) {	// then compute reference period temperature
+            H_LOG( logger, Logger::DEBUG ) << "Computing reference temperature" << std::endl;
+            double sum = 0.0;
+            for( int i=refperiod_low; i<=refperiod_high; i++ )
+                sum += tgav.get( i ).value( U_DEGC );
+            refperiod_tgav.set( sum / ( refperiod_high - refperiod_low + 1 ), U_DEGC );
+            H_LOG( logger, Logger::DEBUG ) << "Computed reference temperature "
+                                           << refperiod_tgav.value( U_DEGC ) << " (" << refperiod_low << "-" << refperiod_high << ")" << std::endl;
+
+            // Now we can compute and store data up to this point
+            for( int i=tgav.firstdate(); i<=refperiod_high; i++ )
+                compute_slr( i );
+        }
 
-        // Now we can compute and store data up to this point
-        for( int i=tgav.firstdate(); i<=refperiod_high; i++ )
-            compute_slr( i );
+        if( year > refperiod_high )
+            compute_slr( year );
     }
-
-    if( runToDate > refperiod_high )
-        compute_slr( runToDate );
     oldDate = runToDate;
 }
 
@@ -219,6 +256,14 @@ unitval slrComponent::getData( const std::string& varName,
 
     unitval returnval;
 
+    if( varName == D_SLR_REFPERIOD_LOW ) {
+        H_ASSERT( date == Core::undefinedIndex(), "Date not allowed for refperiod_low" );
+        return unitval( refperiod_low, U_UNITLESS );
+    } else if( varName == D_SLR_REFPERIOD_HIGH ) {
+        H_ASSERT( date == Core::undefinedIndex(), "Date not allowed for refperiod_high" );
+        return unitval( refperiod_high, U_UNITLESS );
+    }
+
     H_ASSERT( date != Core::undefinedIndex(), "Date required for all slr data" );
 
     if( varName == D_SL_RC ) {
@@ -48,7 +48,7 @@ string SulfurComponent::getComponentName() const {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void SulfurComponent::init( Core* coreptr ) {
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
     core = coreptr;
 
@@ -123,15 +123,29 @@ void SulfurComponent::prepareToRun() throw ( h_exception ) {
 
     H_LOG( logger, Logger::DEBUG ) << "prepareToRun " << std::endl;
     oldDate = core->getStartDate();
+
+    SO2_emissions.share();
+    SV.share();
 }
 
 //------------------------------------------------------------------------------
 // documentation is inherited
 void SulfurComponent::run( const double runToDate ) throw ( h_exception ) {
-    H_ASSERT( !core->inSpinup() && runToDate-oldDate == 1, "timestep must equal 1" );
+    H_ASSERT( !core->inSpinup() && runToDate-oldDate <= core->getTimeStep(), "timestep must not exceed the core timestep" );
     oldDate = runToDate;
 }
 
+//------------------------------------------------------------------------------
+// documentation is inherited
+tseries<unitval>* SulfurComponent::getInputSeriesPtr( const std::string& varName,
+                                                      unit_types& units ) {
+    if( varName == D_EMISSIONS_SO2 ) {
+        units = U_GG_S;
+        return &SO2_emissions;
+    }
+    return NULL;
+}
+
 //------------------------------------------------------------------------------
 // documentation is inherited
 unitval SulfurComponent::getData( const std::string& varName,
@@ -144,8 +144,9 @@ double seval_forsythe( int n, double u, double *x, double *y, double *b, double
      u = the abscissa at which the spline is to be evaluated
      x,y = the arrays of data abscissas and ordinates
      b,c,d = arrays of spline coefficients computed by spline
-     If  u  is not in the same interval as the previous call, then a binary search is
-     performed to determine the proper interval.
+     A binary search determines the proper interval.  (The original kept the
+     interval from the previous call in a static variable to skip the search, which
+     made the function unsafe to call from more than one thread.)
 
      The function seval() is invoked with the (x, y) pairs underlying the interpolating
      function specified by the arguments x and y, and the spline coefficients that
@@ -154,7 +155,7 @@ double seval_forsythe( int n, double u, double *x, double *y, double *b, double
 
     H_ASSERT( n && x && y && b && c && d, "seval_forsythe needs nonzero params" );
 
-    static int i = 0;
+    int i = 0;
     int j, k;
     double dx;
 
@@ -165,9 +166,6 @@ double seval_forsythe( int n, double u, double *x, double *y, double *b, double
 
     /* Search for the data points with independent values containing the
      argument u. */
-    if (i >= n-1) i = 0;
-
-    /* If u is not in the current interval, then execute a binary search. */
     if ((u < x[i]) || (u > x[i+1])) {
         i = 0;
         j = n;
@@ -194,8 +192,7 @@ double seval_deriv_forsythe( int n, double u, double *x, double *y, double *b, d
      u = the abscissa at which the spline is to be evaluated
      x,y = the arrays of data abscissas and ordinates
      b,c,d = arrays of spline coefficients computed by spline
-     If  u  is not in the same interval as the previous call, then a binary search is
-     performed to determine the proper interval.
+     A binary search determines the proper interval, as in seval_forsythe().
 
      The function seval() is invoked with the (x, y) pairs underlying the interpolating
      function specified by the arguments x and y, and the spline coefficients that
@@ -204,7 +201,7 @@ double seval_deriv_forsythe( int n, double u, double *x, double *y, double *b, d
 
     H_ASSERT( n && x && y && b && c && d, "seval_forsythe needs nonzero params" );
 
-    static int i = 0;
+    int i = 0;
     int j, k;
     double dx;
 
@@ -215,9 +212,6 @@ double seval_deriv_forsythe( int n, double u, double *x, double *y, double *b, d
 
     /* Search for the data points with independent values containing the
      argument u. */
-    if (i >= n-1) i = 0;
-
-    /* If u is not in the current interval, then execute a binary search. */
     if ((u < x[i]) || (u > x[i+1])) {
         i = 0;
         j = n;
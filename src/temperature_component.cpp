@@ -79,7 +79,7 @@ void TemperatureComponent::invert_1d_2x2_matrix(double * x, double * y) {
 //------------------------------------------------------------------------------
 // documentation is inherited
 void TemperatureComponent::init( Core* coreptr ) {
-    logger.open( getComponentName(), false, coreptr->getGlobalLogger().getEchoToFile(), coreptr->getGlobalLogger().getMinLogLevel() );
+    logger.open( getComponentName(), coreptr->getGlobalLogger() );
     H_LOG( logger, Logger::DEBUG ) << "hello " << getComponentName() << std::endl;
 
     tgaveq.set( 0.0, U_DEGC, 0.0 );
@@ -122,6 +122,13 @@ void TemperatureComponent::init( Core* coreptr ) {
     core->registerInput(D_DIFFUSIVITY, getComponentName());
     core->registerInput(D_AERO_SCALE, getComponentName());
     core->registerInput(D_VOLCANIC_SCALE, getComponentName());
+
+    // None of our parameters act during the spinup, so changing them only
+    // requires rerunning from the start date.
+    core->registerInvalidation(D_ECS, getComponentName(), Core::INVALIDATE_RUN);
+    core->registerInvalidation(D_DIFFUSIVITY, getComponentName(), Core::INVALIDATE_RUN);
+    core->registerInvalidation(D_AERO_SCALE, getComponentName(), Core::INVALIDATE_RUN);
+    core->registerInvalidation(D_VOLCANIC_SCALE, getComponentName(), Core::INVALIDATE_RUN);
 }
 
 //------------------------------------------------------------------------------
@@ -191,9 +198,11 @@ void TemperatureComponent::prepareToRun() throw ( h_exception ) {
         Logger& glog = core->getGlobalLogger();
         H_LOG( glog, Logger::WARNING ) << "Temperature will be overwritten by user-supplied values!" << std::endl;
     }
+    tgav_constrain.share();
 
     // Initializing all model components that depend on the number of timesteps (ns)
-    ns = core->getEndDate() - core->getStartDate() + 1;
+    dt = core->getTimeStep();
+    ns = int( ( core->getEndDate() - core->getStartDate() ) / dt ) + 1;
 
     KT0 = std::vector<double>(ns, 0.0);
     KTA1 = std::vector<double>(ns, 0.0);
@@ -334,7 +343,7 @@ void TemperatureComponent::run( const double runToDate ) throw ( h_exception ) {
     }
 
     // Some needed inputs
-    int tstep = runToDate - core->getStartDate();
+    int tstep = timestepIndex( runToDate );
     double aero_forcing =
         double(core->sendMessage( M_GETDATA, D_RF_BC ).value( U_W_M2 )) + double(core->sendMessage( M_GETDATA, D_RF_OC).value( U_W_M2 )) +
         double(core->sendMessage( M_GETDATA, D_RF_SO2d ).value( U_W_M2 )) + double(core->sendMessage( M_GETDATA, D_RF_SO2i ).value( U_W_M2 ));
@@ -433,6 +442,28 @@ void TemperatureComponent::run( const double runToDate ) throw ( h_exception ) {
     H_LOG( logger, Logger::DEBUG ) << " tgav=" << tgav << " in " << runToDate << std::endl;
 }
 
+//------------------------------------------------------------------------------
+// documentation is inherited
+const unitval* TemperatureComponent::getCurrentValuePtr( const std::string& varName ) const {
+    if( varName == D_GLOBAL_TEMP )
+        return &tgav;
+    if( varName == D_GLOBAL_TEMPEQ )
+        return &tgaveq;
+    if( varName == D_LAND_AIR_TEMP )
+        return &tgav_land;
+    if( varName == D_OCEAN_SURFACE_TEMP )
+        return &tgav_sst;
+    if( varName == D_OCEAN_AIR_TEMP )
+        return &tgav_oceanair;
+    if( varName == D_FLUX_MIXED )
+        return &flux_mixed;
+    if( varName == D_FLUX_INTERIOR )
+        return &flux_interior;
+    if( varName == D_HEAT_FLUX )
+        return &heatflux;
+    return NULL;
+}
+
 //------------------------------------------------------------------------------
 // documentation is inherited
 unitval TemperatureComponent::getData( const std::string& varName,
@@ -476,7 +507,7 @@ unitval TemperatureComponent::getData( const std::string& varName,
         // time-indexed values, so asking for one of those with a date
         // is an error.
         H_ASSERT(date <= core->getCurrentDate(), "Date must be <= current date.");
-        int tstep = date - core->getStartDate();
+        int tstep = timestepIndex( date );
 
         if( varName == D_GLOBAL_TEMP ) {
             returnval = unitval(temp[tstep], U_DEGC);
@@ -511,7 +542,7 @@ void TemperatureComponent::reset(double time) throw(h_exception)
     if(time < core->getStartDate()) // in this case, reset to the starting value.
         time = core->getStartDate();
 
-    int tstep = time - core->getStartDate();
+    int tstep = int( ( time - core->getStartDate() ) / dt );
     setoutputs(tstep);
     H_LOG(logger, Logger::NOTICE)
         << getComponentName() << " reset to time= " << time << "\n";
@@ -532,7 +563,22 @@ void TemperatureComponent::accept( AVisitor* visitor ) {
     visitor->visit( this );
 }
 
+//------------------------------------------------------------------------------
+/*! \brief Index of the time step at a date
+ *  \param date The date, which must fall on a time step.
+ *  \exception h_exception If the date falls between time steps.
+ */
+int TemperatureComponent::timestepIndex( double date ) const
+{
+    const int tstep = int( ( date - core->getStartDate() ) / dt );
+    H_ASSERT( core->getStartDate() + tstep * dt == date, "Date is not a model time step" );
+    return tstep;
+}
 
+//------------------------------------------------------------------------------
+/*! \brief Set the reported values from the stored values at a time step
+ *  \param tstep Index of the time step.
+ */
 void TemperatureComponent::setoutputs(int tstep)
 {
     double temp_oceanair;
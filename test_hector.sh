@@ -35,6 +35,13 @@ sed 's/endDate=2300/endDate=2250/' $INPUT/hector_rcp45.ini > $INPUT/hector_rcp45
 $HECTOR $INPUT/hector_rcp45_time.ini
 rm $INPUT/hector_rcp45_time.ini
 
+# Time steps must be whole years
+sed 's/^startDate=1745$/&\ntimestep=2.5/' $INPUT/hector_rcp45.ini > $INPUT/hector_rcp45_step.ini
+$HECTOR $INPUT/hector_rcp45_step.ini > /dev/null 2>&1
+STATUS=$?
+rm $INPUT/hector_rcp45_step.ini
+[ $STATUS -ne 0 ] || { echo "Fractional time step accepted"; exit 1; }
+
 # Turn off spinup
 sed 's/do_spinup=1/do_spinup=0/' $INPUT/hector_rcp45.ini > $INPUT/hector_rcp45_spinup.ini
 $HECTOR $INPUT/hector_rcp45_spinup.ini
@@ -62,4 +69,52 @@ rm $INPUT/hector_rcp45_ftot.ini
 #$HECTOR input/hector_rcp45_ocean.ini
 #rm input/hector_rcp45_ocean.ini
 
+# The default StandardCore must match a plain Core exactly
+$HECTOR $INPUT/hector_rcp45.ini
+cp output/outputstream_rcp45.csv output/outputstream_rcp45_composed.csv
+$HECTOR --dynamic $INPUT/hector_rcp45.ini
+cmp -s output/outputstream_rcp45.csv output/outputstream_rcp45_composed.csv || { echo "StandardCore and Core differ"; exit 1; }
+rm output/outputstream_rcp45_composed.csv
+
+# Server mode: one request over standard input
+REQ=$(printf 'config\t%s\nrun\t2100\nget\tTgav\t2100\n' $INPUT/hector_rcp45.ini)
+printf '%d\n%s' ${#REQ} "$REQ" | $HECTOR --server | grep -q '^ok$' || { echo "Server request failed"; exit 1; }
+
+# Server mode: a parameter set by one request is undone before the next
+SET=$(printf 'config\t%s\nset\tS\tNA\t4.5\tdegC\nrun\t2100\nget\tTgav\t2100\n' $INPUT/hector_rcp45.ini)
+OUT=$(printf '%d\n%s%d\n%s%d\n%s' ${#REQ} "$REQ" ${#SET} "$SET" ${#REQ} "$REQ" | $HECTOR --server | grep '^Tgav')
+[ $(echo "$OUT" | wc -l) -eq 3 ] || { echo "Server requests failed"; exit 1; }
+FIRST=$(echo "$OUT" | sed -n 1p)
+[ "$(echo "$OUT" | sed -n 2p)" != "$FIRST" ] || { echo "Server request parameter not applied"; exit 1; }
+[ "$(echo "$OUT" | sed -n 3p)" = "$FIRST" ] || { echo "Server request parameter not undone"; exit 1; }
+
+# Server mode: the same request over a Unix domain socket
+if command -v python3 > /dev/null; then
+    SOCK=$(mktemp -u /tmp/hector_test.XXXXXX)
+    $HECTOR --server --socket $SOCK 2> /dev/null &
+    SERVER=$!
+    SOCKOUT=$(python3 - "$SOCK" "$REQ" <<'EOF'
+import socket, sys, time
+path, req = sys.argv[1], sys.argv[2].encode()
+s = socket.socket(socket.AF_UNIX)
+for i in range(100):         # wait for the server to start listening
+    try:
+        s.connect(path)
+        break
+    except OSError:
+        time.sleep(0.1)
+s.sendall(b"%d\n" % len(req) + req)
+f = s.makefile("rb")
+n = int(f.readline())
+sys.stdout.write(f.read(n).decode())
+EOF
+)
+    kill $SERVER
+    rm -f $SOCK
+    echo "$SOCKOUT" | grep -q '^ok$' || { echo "Socket server request failed"; exit 1; }
+    [ "$(echo "$SOCKOUT" | grep '^Tgav')" = "$FIRST" ] || { echo "Socket server answer differs"; exit 1; }
+else
+    echo "python3 not found; skipping socket server test"
+fi
+
 echo "All done."